@@ -9,6 +9,9 @@
 #include "types.h"
 #include "ipc.h"
 #include "utils.h"
+#include "czas.h"
+#include "obecnosc.h"
+#include "zdarzenia.h"
 
 /*
  * KOLEJ KRZESEŁKOWA - PROCES BRAMKI (Bramka1)
@@ -40,7 +43,7 @@ int main(int argc, char *argv[]) {
     ustaw_smierc_z_rodzicem();
     
     /* Inicjalizacja */
-    inicjalizuj_losowanie();
+    inicjalizuj_losowanie(LOS_SOL_BRAMKA(g_numer_bramki));
     
     /* Obsługa sygnałów - sigaction BEZ SA_RESTART */
     struct sigaction sa;
@@ -75,7 +78,7 @@ int main(int argc, char *argv[]) {
         }
         
         /* Podczas awarii - czekaj na wznowienie */
-        if (g_shm->awaria && !g_koniec) {
+        if (STAN(awaria) && !g_koniec) {
             char buf[32];
             snprintf(buf, sizeof(buf), "BRAMKA%d", g_numer_bramki);
             czekaj_na_wznowienie(buf);
@@ -85,9 +88,9 @@ int main(int argc, char *argv[]) {
         odp.mtype = msg.pid_klienta;
         if (g_numer_bramki == 1 && !msg.vip) {
             odp.sukces = 0;
-            msg_send(g_mq_bramka_odp, &odp, sizeof(odp));
-            loguj("BRAMKA%d: ODRZUT - bramka VIP-only (pid=%d karnet=%d)",
-                  g_numer_bramki, (int)msg.pid_klienta, msg.id_karnetu);
+            msg_send_odp(g_mq_bramka_odp, msg.skrzynka, &odp, sizeof(odp), 1);
+            LOG_INFO("BRAMKA%d: ODRZUT - bramka VIP-only (pid=%d karnet=%d)",
+                     g_numer_bramki, (int)msg.pid_klienta, msg.id_karnetu);
             continue;
         }
 
@@ -95,11 +98,11 @@ int main(int argc, char *argv[]) {
         Karnet *karnet = pobierz_karnet(msg.id_karnetu);
         /* odp.mtype ustawiony wyżej */
         
-        if (karnet == NULL || !czy_karnet_wazny(karnet, time(NULL))) {
+        if (karnet == NULL || !czy_karnet_wazny(karnet, czas_mono_ns())) {
             odp.sukces = 0;
-            msg_send(g_mq_bramka_odp, &odp, sizeof(odp));
-            loguj("BRAMKA%d: ODRZUT - nieważny karnet id=%d (pid=%d)",
-                  g_numer_bramki, msg.id_karnetu, (int)msg.pid_klienta);
+            msg_send_odp(g_mq_bramka_odp, msg.skrzynka, &odp, sizeof(odp), 1);
+            LOG_INFO("BRAMKA%d: ODRZUT - nieważny karnet id=%d (pid=%d)",
+                     g_numer_bramki, msg.id_karnetu, (int)msg.pid_klienta);
             continue;
         }
         
@@ -107,20 +110,20 @@ int main(int argc, char *argv[]) {
         if (sem_wait_n(SEM_TEREN, msg.rozmiar_grupy) != 0) {
             /* Semafor przerwany - odmów */
             odp.sukces = 0;
-            msg_send(g_mq_bramka_odp, &odp, sizeof(odp));
-            loguj("BRAMKA%d: ODRZUT - brak miejsca na terenie (pid=%d grupa=%d)",
-                  g_numer_bramki, (int)msg.pid_klienta, msg.rozmiar_grupy);
+            msg_send_odp(g_mq_bramka_odp, msg.skrzynka, &odp, sizeof(odp), 1);
+            LOG_INFO("BRAMKA%d: ODRZUT - brak miejsca na terenie (pid=%d grupa=%d)",
+                     g_numer_bramki, (int)msg.pid_klienta, msg.rozmiar_grupy);
             continue;
         }
         
         /* CHECK #2: Po pobraniu semafora sprawdź karnet PONOWNIE!
          * Mógł wygasnąć w trakcie czekania (czas upłynął lub koniec dnia). */
-        if (!czy_karnet_wazny(karnet, time(NULL))) {
+        if (!czy_karnet_wazny(karnet, czas_mono_ns())) {
             sem_signal_n(SEM_TEREN, msg.rozmiar_grupy); /* Zwróć semafor */
             odp.sukces = 0;
-            msg_send(g_mq_bramka_odp, &odp, sizeof(odp));
-            loguj("BRAMKA%d: ODRZUT - karnet wygasł po oczekiwaniu id=%d (pid=%d)",
-                  g_numer_bramki, msg.id_karnetu, (int)msg.pid_klienta);
+            msg_send_odp(g_mq_bramka_odp, msg.skrzynka, &odp, sizeof(odp), 1);
+            LOG_INFO("BRAMKA%d: ODRZUT - karnet wygasł po oczekiwaniu id=%d (pid=%d)",
+                     g_numer_bramki, msg.id_karnetu, (int)msg.pid_klienta);
             continue;
         }
         
@@ -140,20 +143,17 @@ int main(int argc, char *argv[]) {
         }
         
         /* Aktualizuj licznik osób na terenie */
-        MUTEX_SHM_LOCK();
-        g_shm->osoby_na_terenie += msg.rozmiar_grupy;
-        MUTEX_SHM_UNLOCK();
+        obecnosc_przenies(STREFA_POZA, STREFA_TEREN, msg.rozmiar_grupy);
         
         /* Zaloguj przejście do SHM (nie do stderr) */
         dodaj_log(msg.id_karnetu, LOG_BRAMKA1, g_numer_bramki);
 
-        loguj("BRAMKA%d: OK - pid=%d karnet=%d grupa=%d vip=%d",
-              g_numer_bramki, (int)msg.pid_klienta, msg.id_karnetu, msg.rozmiar_grupy,
-              msg.vip);
+        LOG_ZDARZENIE(ZD_BRAMKA_OK, g_numer_bramki, (int)msg.pid_klienta, msg.id_karnetu, msg.rozmiar_grupy,
+                      msg.vip);
         
         /* Wyślij potwierdzenie */
         odp.sukces = 1;
-        msg_send(g_mq_bramka_odp, &odp, sizeof(odp));
+        msg_send_odp(g_mq_bramka_odp, msg.skrzynka, &odp, sizeof(odp), 1);
     }
     
     loguj("BRAMKA%d: Kończę pracę", g_numer_bramki);
@@ -164,7 +164,7 @@ int main(int argc, char *argv[]) {
         MsgBramkaOdp odp;
         odp.mtype = msg.pid_klienta;
         odp.sukces = 0;
-        msg_send_nowait(g_mq_bramka_odp, &odp, sizeof(odp));
+        msg_send_odp(g_mq_bramka_odp, msg.skrzynka, &odp, sizeof(odp), 0);
     }
     
     detach_ipc();
@@ -18,8 +18,20 @@
 #define MAX_KLIENTOW        60000     // max procesów klientów jednocześnie
 /* Maksymalna liczba klientów, których generator utworzy łącznie (0 = bez limitu) */
 #define MAX_WYG_KLIENTOW    21000
-#define MAX_KARNETOW        999999 // max karnetów w pamięci
-#define MAX_LOGOW           999999   // max wpisów w logu przejść
+/* Karnety: chunki w osobnych segmentach, dokładane na żądanie (id -> chunk O(1)) */
+#define KARNETY_CHUNK_BITY  16      // 2^16 karnetów na chunk
+#define KARNETY_W_CHUNKU    (1 << KARNETY_CHUNK_BITY)
+#define KARNETY_MAX_CHUNKOW 1024    // max chunków (~67M karnetów)
+/* Startowe chunki karnetów liczone z limit_utworzonych (geometria_shm_oblicz) */
+#define KARNETY_NA_KLIENTA  3       // opiekun + max 2 dzieci
+#define ZAPAS_SHM_PROC      100     // zapas magazynów ponad oczekiwane (%)
+#define ENV_ZAPAS_SHM       "KOLEJ_ZAPAS_SHM"  // nadpisuje ZAPAS_SHM_PROC (czyta main)
+#define STAT_SHARDY_KLIENTOW MAX_KLIENTOW // shardy statystyk klientów (slot = id % N)
+/* Log przejść: stały pierścień w SHM, main drenuje go na bieżąco do PLIK_LOG */
+#define LOGI_PIERSCIEN      16384   // wpisów w pierścieniu (potęga 2)
+#define LOGI_DRENAZ_MS      100     // co ile wątek main opróżnia pierścień
+#define LOGI_CZEKANIE_MS    50      // pełny pierścień: producent czeka tyle, potem wpis zgubiony
+#define LOGI_BUFOR_ZAPISU   4096    // wpisów na jeden write() do PLIK_LOG (64 KB)
 
 /* ============================================
  * INFRASTRUKTURA KOLEI
@@ -56,8 +68,61 @@
  * Czas przejazdu = (LICZBA_RZEDOW/2) * INTERWAL_KRZESELKA_MS
  * ============================================ */
 #define INTERWAL_KRZESELKA_MS 1   // co ile podjeżdża krzesełko (ms)
+/*
+ * Zegar wyciągu: tick co INTERWAL_KRZESELKA_MS od bezwzględnego terminu
+ * (clock_nanosleep TIMER_ABSTIME). Spóźniony tick (wywłaszczenie, długa
+ * praca) obsługuje tryb nadrabiania - KOLEJ_WYCIAG_NADRABIANIE (czyta main):
+ *   seria   - zaległe ticki od razu jeden po drugim (przepustowość = nominalna)
+ *   pomin   - zaległe terminy przepadają, następny tick na siatce terminów
+ *   przesun - siatka przesuwa się: następny termin = teraz + interwał
+ */
+#define ENV_WYCIAG_NADRABIANIE "KOLEJ_WYCIAG_NADRABIANIE"
+#define NADRABIANIE_SERIA     0     // domyślnie
+#define NADRABIANIE_POMIN     1
+#define NADRABIANIE_PRZESUN   2
+#define WYCIAG_SERIA_MAX      100   // seria: max zaległych ticków; starsze terminy przepadają
+/*
+ * Pakowanie rzędu (w każdej klasie osobno, VIP przed resztą) -
+ * KOLEJ_PAKOWANIE (czyta main):
+ *   zachlanna - kolejność przyjścia, stop na pierwszej grupie, która się nie mieści
+ *   ffd       - first-fit-decreasing po pierwszych PAKOWANIE_OKNO grupach
+ *   dokladna  - podzbiór pierwszych PAKOWANIE_OKNO grup zapełniający najwięcej slotów
+ * Grupa wyprzedzona w PAKOWANIE_MAX_WYPRZEDZEN rzędach wsiada jako pierwsza.
+ */
+#define ENV_PAKOWANIE         "KOLEJ_PAKOWANIE"
+#define PAKOWANIE_ZACHLANNA   0     // domyślnie
+#define PAKOWANIE_FFD         1
+#define PAKOWANIE_DOKLADNA    2
+#define PAKOWANIE_OKNO        8     // grup z klasy branych pod uwagę (ffd / dokladna)
+#define PAKOWANIE_MAX_WYPRZEDZEN 3  // limit rzędów, w których grupę ktoś wyprzedził
 #define KURS_ROWEROWY_CO      3     // co który kurs gwarantuje rower
 #define PERON_SLOTY           4     // max slotów na peronie (pieszy=1, rower=2)
+/*
+ * Geometria wyciągu w czasie uruchomienia (czyta main, trafia do g_shm->wyciag).
+ * LICZBA_RZEDOW, KRZESLA_W_RZEDZIE, PERON_SLOTY i INTERWAL_KRZESELKA_MS
+ * są wartościami domyślnymi; nadpisują je:
+ *   KOLEJ_RZEDY          rzędów w ringu (2..RZEDY_MAX)
+ *   KOLEJ_KRZESLA        miejsc w rzędzie (1..KRZESLA_MAX)
+ *   KOLEJ_PERON_SLOTY    slotów peronu = start SEM_PERON (1..PERON_SLOTY_MAX)
+ *   KOLEJ_INTERWAL_MS    co ile podjeżdża rząd (1..INTERWAL_MAX_MS)
+ *   KOLEJ_POZYCJA_GORNA  pozycja stacji górnej (1..rzedy-1, domyślnie rzedy/2)
+ *   KOLEJ_LINIE          równoległych linii wyciągu (1..LINIE_MAX, domyślnie 1)
+ * Ring do LICZBA_RZEDOW rzędów leży w tablicy statycznej wyciągu (bez malloc).
+ * Każda linia to osobny proces wyciag z własnym ringiem, SEM_PERON_LINII
+ * i kanałem kolejki wyciag_req (mtype = numer linii, jak bramki);
+ * pracownik1 kieruje grupę na linię z najkrótszą kolejką.
+ */
+#define ENV_RZEDY             "KOLEJ_RZEDY"
+#define ENV_KRZESLA           "KOLEJ_KRZESLA"
+#define ENV_PERON_SLOTY       "KOLEJ_PERON_SLOTY"
+#define ENV_INTERWAL_MS       "KOLEJ_INTERWAL_MS"
+#define ENV_POZYCJA_GORNA     "KOLEJ_POZYCJA_GORNA"
+#define ENV_LINIE             "KOLEJ_LINIE"
+#define RZEDY_MAX             240   // LINIE_MAX * RZEDY_MAX * KRZESLA_MAX mieści się w polu krzesło (obecnosc.c)
+#define KRZESLA_MAX           8
+#define PERON_SLOTY_MAX       256
+#define INTERWAL_MAX_MS       60000
+#define LINIE_MAX             4
 
 /* ============================================
  * GODZINY PRACY
@@ -133,17 +198,21 @@
  * Wszystkie semafory w jednym zestawie
  * ============================================ */
 #define SEM_TEREN           0       // limit N osób na terenie (init: N)
-#define SEM_MUTEX_SHM       1       // mutex pamięci współdzielonej (init: 1)
+#define SEM_MUTEX_SHM       1       // DEPRECATED - mutex SHM jest w SharedMemory (MUTEX_SHM_LOCK)
 #define SEM_MUTEX_KASA      2       // mutex kasy (init: 1)
 #define SEM_MUTEX_LOG       3       // mutex logów (init: 1)
-#define SEM_PERON           4       // sloty peronu (init: PERON_SLOTY=4, pieszy=1, rower=2)
+#define SEM_PERON           4       // sloty peronu linii 1 (init: g_shm->wyciag.peron_sloty, pieszy=1, rower=2)
 #define SEM_PRACOWNIK1      5       // sygnalizacja dla P1 (init: 0)
 #define SEM_PRACOWNIK2      6       // sygnalizacja dla P2 (init: 0)
 #define SEM_GOTOWY_P1       7       // P1 gotowy po awarii (init: 0)
 #define SEM_GOTOWY_P2       8       // P2 gotowy po awarii (init: 0)
 #define SEM_KONIEC          9       // sygnał zakończenia (init: 0)
 #define SEM_BARIERA_AWARIA  10      // bariera podczas awarii (init: 0)
-#define SEM_COUNT           11      // łączna liczba semaforów
+#define SEM_PERON_DALSZE    11      // sloty peronów linii 2..LINIE_MAX (init jak SEM_PERON, 0 = linia wyłączona)
+#define SEM_COUNT           (SEM_PERON_DALSZE + LINIE_MAX - 1)  // łączna liczba semaforów
+
+/* Semafor peronu linii 1..LINIE_MAX */
+#define SEM_PERON_LINII(linia) ((linia) <= 1 ? SEM_PERON : SEM_PERON_DALSZE + (linia) - 2)
 
 /* ============================================
  * TYPY KOMUNIKATÓW (mtype w kolejkach)
@@ -169,6 +238,52 @@
 #define IPC_KEY_MQ_WYCIAG_ODP 8     // odpowiedzi wyciągu
 #define IPC_KEY_MQ_PERON     9       // kolejka klient->pracownik1 (bramki2/peron)
 #define IPC_KEY_MQ_PERON_ODP 10      // odpowiedzi pracownik1->klient (peron)
+#define IPC_KEY_SHM_KOLEJKI  11      // segment z pierścieniami (TRANSPORT_SHM)
+#define IPC_KEY_SHM_KARNETY  12      // + nr chunka: segmenty karnetów (12..12+KARNETY_MAX_CHUNKOW-1)
+
+/* ============================================
+ * TRANSPORT KOMUNIKATÓW
+ * Wybór przez zmienną środowiskową KOLEJ_TRANSPORT=sysv|shm (czyta main)
+ * ============================================ */
+#define TRANSPORT_SYSV      0       // kolejki SysV msgsnd/msgrcv (domyślnie)
+#define TRANSPORT_SHM       1       // pierścienie w pamięci współdzielonej + futex
+#define ENV_TRANSPORT       "KOLEJ_TRANSPORT"
+#define SHMQ_POJEMNOSC      4096    // slotów na kanał (potęga 2)
+#define SHMQ_SKRZYNKI       MAX_KLIENTOW  // skrzynki odpowiedzi (1 na żywego klienta)
+#define SKRZYNKA_GLEBOKOSC  4       // odpowiedzi w drodze do 1 klienta (potęga 2)
+#define CZEKANIE_ODP_MS     1000    // max sen klienta na odpowiedź bez zdarzenia (kontrola P1)
+#define ODP_POLL_MS         10      // SysV: co ile klient sprawdza kolejkę odpowiedzi
+#define ODP_BACKOFF_MAX_MS  50      // max odstęp ponowień przy pełnej skrzynce (msg_send_odp czekaj=1)
+
+/* ============================================
+ * DIAGNOSTYKA
+ * ============================================ */
+#define ENV_KONTROLA_OBECNOSCI "KOLEJ_KONTROLA_OBECNOSCI"  // =1: sprawdzaj niezmienniki liczników stref
+#define ENV_SEED            "KOLEJ_SEED"        // ziarno losowania (powtarzalny ciąg klientów); brak = czas ^ PID
+
+/* ============================================
+ * LOGOWANIE
+ * ============================================ */
+#define ENV_LOG_BUFOR       "KOLEJ_LOG_BUFOR"   // =1: loguj() buforuje wiersze w procesie
+#define ENV_LOG_LEVEL       "KOLEJ_LOG_LEVEL"   // debug|info|warn|error|none (próg LOG_DEBUG..LOG_ERROR)
+#define LOG_BUFOR_ROZMIAR   16384   // bufor wierszy jednego procesu (bajty)
+#define LOG_BUFOR_PROG      8192    // opróżnij po zebraniu tylu bajtów
+#define LOG_BUFOR_MS        250     // ... albo gdy najstarszy wiersz czeka dłużej
+
+/* Dziennik: gorące zdarzenia (LOG_ZDARZENIE) jako rekordy w pierścieniu SHM,
+ * tekst do output/<kanał>.log składa osobny proces dziennika */
+#define ENV_LOG_DZIENNIK    "KOLEJ_LOG_DZIENNIK"  // =1: włącz pierścień zdarzeń + proces dziennika
+#define DZIENNIK_POJEMNOSC  16384   // rekordów w pierścieniu (potęga 2); pełny = zapis bezpośredni
+#define DZIENNIK_POLL_MS    10      // sen dziennika przy pustym pierścieniu
+#define DZIENNIK_CISZA_MS   200     // po SIGTERM: koniec po tylu ms pustego pierścienia
+#define DZIENNIK_LIMIT_MS   3000    // ... ale najpóźniej po tylu ms
+
+/* Próbkowanie: szereg czasowy kolejek / semaforów / stref, zapis na koniec dnia */
+#define ENV_PROBKI_MS       "KOLEJ_PROBKI_MS"   // odstęp próbek w ms (0 = wyłączone)
+#define PROBKI_MS           10      // domyślny odstęp próbek
+#define PROBKI_MS_MAX       60000
+#define PROBKI_MAX          65536   // próbek w pamięci; pełny bufor = co 2. próbka, odstęp x2
+#define PROBKI_KAWALEK_MS   50      // najdłuższy jednorazowy sen wątku (tyle max czeka probki_zakoncz)
 
 /* ============================================
  * ŚCIEŻKI DO PLIKÓW WYKONYWALNYCH
@@ -181,12 +296,14 @@
 #define PATH_KLIENT         "./klient"
 #define PATH_WYCIAG         "./wyciag"
 #define PATH_SPRZATACZ      "./sprzatacz"
+#define PATH_DZIENNIK       "./dziennik"
 
 /* ============================================
  * PLIKI RAPORTÓW
  * ============================================ */
 #define PLIK_RAPORT         "output/raport_dzienny.txt"
-#define PLIK_LOG            "output/log_przejsc.txt"
+#define PLIK_LOG            "output/log_przejsc.bin"   // binarny (log_bin.h), CSV: ./logdump
+#define PLIK_PROBKI         "output/probki.bin"        // kolumnowy (probki_bin.h), CSV: ./logdump
 
 /* ============================================
  * UPRAWNIENIA IPC (minimalne)
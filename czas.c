@@ -0,0 +1,58 @@
+#include <stdio.h>
+#include <time.h>
+#include "czas.h"
+#include "ipc.h"
+
+/*
+ * KOLEJ KRZESEŁKOWA - CZAS (monotoniczny + kotwica ściany w SHM)
+ */
+
+static long long odczytaj_ns(clockid_t zegar) {
+    struct timespec ts;
+    clock_gettime(zegar, &ts);
+    return (long long)ts.tv_sec * NS_NA_SEK + ts.tv_nsec;
+}
+
+long long czas_mono_ns(void) {
+    return odczytaj_ns(CLOCK_MONOTONIC);
+}
+
+void czas_kotwica_ustaw(KotwicaCzasu *k) {
+    k->mono_ns = odczytaj_ns(CLOCK_MONOTONIC);
+    k->sciana_ns = odczytaj_ns(CLOCK_REALTIME);
+}
+
+long long czas_na_sciany_ns(long long mono_ns) {
+    /* Własna kotwica: procesy przed attach_ipc, narzędzia bez SHM */
+    static KotwicaCzasu lokalna = {0, 0};
+    const KotwicaCzasu *k;
+
+    if (g_shm != NULL && g_shm->kotwica.mono_ns > 0) {
+        k = &g_shm->kotwica;
+    } else {
+        if (__atomic_load_n(&lokalna.mono_ns, __ATOMIC_ACQUIRE) == 0) {
+            KotwicaCzasu nowa;
+            czas_kotwica_ustaw(&nowa);
+            lokalna.sciana_ns = nowa.sciana_ns;
+            __atomic_store_n(&lokalna.mono_ns, nowa.mono_ns, __ATOMIC_RELEASE);
+        }
+        k = &lokalna;
+    }
+    return k->sciana_ns + (mono_ns - k->mono_ns);
+}
+
+time_t czas_na_sciany_sek(long long mono_ns) {
+    return (time_t)(czas_na_sciany_ns(mono_ns) / NS_NA_SEK);
+}
+
+void czas_formatuj_ms(long long mono_ns, char *bufor, size_t rozmiar) {
+    long long sciana = czas_na_sciany_ns(mono_ns);
+    time_t sek = (time_t)(sciana / NS_NA_SEK);
+    int ms = (int)((sciana % NS_NA_SEK) / NS_NA_MS);
+    struct tm tm_info;
+    char hms[16];
+
+    localtime_r(&sek, &tm_info);
+    strftime(hms, sizeof(hms), "%H:%M:%S", &tm_info);
+    snprintf(bufor, rozmiar, "%s.%03d", hms, ms);
+}
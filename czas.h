@@ -0,0 +1,47 @@
+#ifndef CZAS_H
+#define CZAS_H
+
+#include <stddef.h>
+#include <time.h>
+#include "types.h"
+
+/*
+ * KOLEJ KRZESEŁKOWA - CZAS
+ * Odstępy i terminy (ważność karnetów, koniec dnia, wpisy logu przejść,
+ * zdarzenia dziennika): CLOCK_MONOTONIC w nanosekundach.
+ * Wyświetlanie: jedna kotwica ściany w SHM (g_shm->kotwica), ustawiana
+ * przez main w init_ipc - wszystkie procesy przeliczają tak samo, a zmiana
+ * zegara systemowego w trakcie dnia nie rusza terminów.
+ */
+
+#define NS_NA_SEK   1000000000LL
+#define NS_NA_MS    1000000LL
+
+/*
+ * Bieżący czas monotoniczny (ns)
+ */
+long long czas_mono_ns(void);
+
+/*
+ * Zapisuje do k oba zegary odczytane w tej samej chwili (main, init_ipc)
+ */
+void czas_kotwica_ustaw(KotwicaCzasu *k);
+
+/*
+ * Czas ściany (ns od epoki) odpowiadający chwili monotonicznej mono_ns.
+ * Kotwica z SHM, a przed attach_ipc - własna kotwica procesu.
+ */
+long long czas_na_sciany_ns(long long mono_ns);
+
+/*
+ * Sekundy ściany (do formatuj_czas) dla chwili monotonicznej
+ */
+time_t czas_na_sciany_sek(long long mono_ns);
+
+/*
+ * Formatuje chwilę monotoniczną jako "HH:MM:SS.mmm"
+ * Bufor musi mieć min. 13 znaków
+ */
+void czas_formatuj_ms(long long mono_ns, char *bufor, size_t rozmiar);
+
+#endif /* CZAS_H */
@@ -0,0 +1,202 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <signal.h>
+#include <errno.h>
+#include <string.h>
+#include <poll.h>
+#include <time.h>
+#include <fcntl.h>
+#include <sys/file.h>
+
+#include "config.h"
+#include "types.h"
+#include "ipc.h"
+#include "utils.h"
+#include "czas.h"
+#include "zdarzenia.h"
+
+/*
+ * KOLEJ KRZESEŁKOWA - PROCES DZIENNIKA (tryb ENV_LOG_DZIENNIK=1)
+ *
+ * Jedyny konsument pierścienia zdarzeń:
+ * 1. Wyjmuje rekordy (czas monotoniczny, PID, kod, argumenty)
+ * 2. Składa wiersze w formacie loguj() "[HH:MM:SS.mmm][PID n] ..."
+ * 3. Dopisuje je paczkami do output/<kanał>.log (flock jak loguj())
+ *
+ * Po SIGTERM nie kończy od razu: opróżnia pierścień, dopóki przez
+ * DZIENNIK_CISZA_MS nic nie przyjdzie (max DZIENNIK_LIMIT_MS), potem
+ * zdejmuje dziennik_aktywny - późniejsze zdarzenia idą przez loguj().
+ */
+
+static volatile sig_atomic_t g_koniec = 0;
+
+static void handler_sigterm(int sig) {
+    (void)sig;
+    g_koniec = 1;
+}
+
+/* Bufor wierszy jednego kanału */
+typedef struct {
+    int fd;
+    size_t zajete;
+    char dane[LOG_BUFOR_ROZMIAR];
+} BuforKanalu;
+
+static BuforKanalu g_kanaly[KANAL_LICZBA];
+static unsigned long g_zapisane = 0;
+
+static void kanal_oproznij(BuforKanalu *k) {
+    size_t pos = 0;
+
+    if (k->zajete == 0) return;
+    if (k->fd < 0) {
+        k->zajete = 0;
+        return;
+    }
+
+    int locked = (flock(k->fd, LOCK_EX) == 0);
+    while (pos < k->zajete) {
+        ssize_t w = write(k->fd, k->dane + pos, k->zajete - pos);
+        if (w < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        pos += (size_t)w;
+    }
+    if (locked) (void)flock(k->fd, LOCK_UN);
+    k->zajete = 0;
+}
+
+static void oproznij_wszystkie(void) {
+    for (int i = 0; i < KANAL_LICZBA; i++) {
+        kanal_oproznij(&g_kanaly[i]);
+    }
+}
+
+/* Prefiks czasu jak w loguj() (HH:MM:SS.mmm): localtime_r tylko przy zmianie sekundy */
+static const char *czas_sciany(long long mono_ns) {
+    static time_t ostatnia = (time_t)-1;
+    static char napis[24];
+    long long sciana = czas_na_sciany_ns(mono_ns);
+    time_t sek = (time_t)(sciana / NS_NA_SEK);
+    int ms = (int)((sciana % NS_NA_SEK) / NS_NA_MS);
+
+    if (sek != ostatnia) {
+        struct tm tm_info;
+        localtime_r(&sek, &tm_info);
+        strftime(napis, sizeof(napis), "%H:%M:%S", &tm_info);
+        ostatnia = sek;
+    }
+    napis[8] = '.';
+    napis[9] = (char)('0' + ms / 100);
+    napis[10] = (char)('0' + ms / 10 % 10);
+    napis[11] = (char)('0' + ms % 10);
+    napis[12] = '\0';
+    return napis;
+}
+
+static void zapisz_zdarzenie(const Zdarzenie *z) {
+    char wiersz[1024];
+    int kanal = zdarzenie_kanal(z->kod);
+    if (kanal < 0) return;
+
+    int n = snprintf(wiersz, sizeof(wiersz), "[%s][PID %d] ", czas_sciany(z->czas_ns), (int)z->pid);
+    int m = zdarzenie_renderuj(z, wiersz + n, sizeof(wiersz) - (size_t)n - 1);
+    if (m < 0) return;
+
+    size_t len = (size_t)n + (size_t)m;
+    if (len > sizeof(wiersz) - 2) len = sizeof(wiersz) - 2;
+    wiersz[len++] = '\n';
+
+    BuforKanalu *k = &g_kanaly[kanal];
+    if (k->zajete + len > sizeof(k->dane)) {
+        kanal_oproznij(k);
+    }
+    memcpy(k->dane + k->zajete, wiersz, len);
+    k->zajete += len;
+    g_zapisane++;
+}
+
+/* Opróżnia pierścień do buforów kanałów. Zwraca: liczba rekordów */
+static unsigned long drenuj(void) {
+    Zdarzenie z;
+    unsigned long n = 0;
+
+    while (zdarzenie_wyjmij(&z) == 0) {
+        zapisz_zdarzenie(&z);
+        n++;
+    }
+    oproznij_wszystkie();
+    return n;
+}
+
+int main(void) {
+    ustaw_smierc_z_rodzicem();
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = handler_sigterm;
+    sigemptyset(&sa.sa_mask);
+    sa.sa_flags = 0;
+    sigaction(SIGTERM, &sa, NULL);
+    sigaction(SIGINT, &sa, NULL);
+
+    if (attach_ipc() != 0) {
+        loguj("DZIENNIK: Błąd dołączania do IPC");
+        return EXIT_FAILURE;
+    }
+    if (g_shm->geometria.pojemnosc_zdarzen <= 0) {
+        loguj("DZIENNIK: segment bez pierścienia zdarzeń - kończę");
+        detach_ipc();
+        return EXIT_FAILURE;
+    }
+
+    for (int i = 0; i < KANAL_LICZBA; i++) {
+        g_kanaly[i].fd = open(zdarzenia_plik_kanalu(i), O_CREAT | O_WRONLY | O_APPEND, 0644);
+        if (g_kanaly[i].fd < 0) {
+            blad_ostrzezenie(zdarzenia_plik_kanalu(i));
+        }
+    }
+
+    __atomic_store_n(&g_shm->dziennik_aktywny, 1, __ATOMIC_RELEASE);
+    loguj("DZIENNIK: Rozpoczynam pracę (pierścień=%d zdarzeń)", g_shm->geometria.pojemnosc_zdarzen);
+
+    int cisza_ms = 0;
+    long long koniec_od_ns = 0;
+    for (;;) {
+        unsigned long n = drenuj();
+        if (n > 0) cisza_ms = 0;
+
+        if (g_koniec) {
+            long long teraz = czas_mono_ns();
+            if (koniec_od_ns == 0) koniec_od_ns = teraz;
+            if (cisza_ms >= DZIENNIK_CISZA_MS ||
+                teraz - koniec_od_ns >= (long long)DZIENNIK_LIMIT_MS * NS_NA_MS) {
+                break;
+            }
+        }
+        if (n == 0) {
+            poll(NULL, 0, DZIENNIK_POLL_MS);
+            if (g_koniec) cisza_ms += DZIENNIK_POLL_MS;
+        }
+    }
+
+    /* Nowe zdarzenia od teraz idą bezpośrednio; dobierz te w locie.
+     * Producent, który zdążył zobaczyć aktywny=1, trzyma zdarzenia_w_locie > 0
+     * aż do włożenia - czekamy na zero (limit: zabity w środku producent). */
+    __atomic_store_n(&g_shm->dziennik_aktywny, 0, __ATOMIC_SEQ_CST);
+    for (int ms = 0; ms < DZIENNIK_CISZA_MS &&
+                     __atomic_load_n(&g_shm->zdarzenia_w_locie, __ATOMIC_SEQ_CST) > 0; ms++) {
+        poll(NULL, 0, 1);
+    }
+    drenuj();
+
+    for (int i = 0; i < KANAL_LICZBA; i++) {
+        if (g_kanaly[i].fd >= 0) close(g_kanaly[i].fd);
+    }
+    loguj("DZIENNIK: Kończę pracę (zapisane zdarzenia=%lu)", g_zapisane);
+
+    detach_ipc();
+    return EXIT_SUCCESS;
+}
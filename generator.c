@@ -10,6 +10,8 @@
 #include "types.h"
 #include "ipc.h"
 #include "utils.h"
+#include "czas.h"
+#include "zdarzenia.h"
 
 /*
  * Guard na "minę" konfiguracyjną:
@@ -52,11 +54,13 @@ static void reap_children_and_maybe_panic(void) {
     pid_t pid;
     while ((pid = waitpid(-1, &status, WNOHANG)) > 0) {
         /* jeśli klient zginął sygnałem w OPEN → PANIC */
-        if (WIFSIGNALED(status) && g_shm && g_shm->faza_dnia == FAZA_OPEN) {
-            g_shm->panic = 1;
-            g_shm->panic_pid = pid;
-            g_shm->panic_sig = WTERMSIG(status);
-            if (g_shm->pid_main > 0) kill(g_shm->pid_main, SIGTERM);
+        if (WIFSIGNALED(status) && g_shm && STAN(faza_dnia) == FAZA_OPEN) {
+            stan_zapis_poczatek();
+            STAN_USTAW(panic, 1);
+            STAN_USTAW(panic_pid, pid);
+            STAN_USTAW(panic_sig, WTERMSIG(status));
+            stan_zapis_koniec();
+            if (STAN(pid_main) > 0) kill(STAN(pid_main), SIGTERM);
             g_koniec = 1;
         }
     }
@@ -82,10 +86,6 @@ static void przekieruj_stdio_do_pliku(const char *sciezka) {
     if (fd > STDERR_FILENO) close(fd);
 }
 
-static const char* nazwa_typu_klienta(int typ) {
-    return (typ == TYP_ROWERZYSTA) ? "ROWER" : "PIESZY";
-}
-
 int main(int argc, char *argv[]) {
     int czas_symulacji = CZAS_SYMULACJI;
     int limit_utworzonych = MAX_WYG_KLIENTOW; /* 0 = bez limitu */
@@ -110,7 +110,7 @@ int main(int argc, char *argv[]) {
     ustaw_smierc_z_rodzicem();
     
     /* Inicjalizacja */
-    inicjalizuj_losowanie();
+    inicjalizuj_losowanie(LOS_SOL_GENERATOR);
     
     /* Obsługa sygnałów - sigaction BEZ SA_RESTART */
     struct sigaction sa;
@@ -134,13 +134,13 @@ int main(int argc, char *argv[]) {
     loguj("GENERATOR: Start (czas=%d sek, limit_utworzonych=%d, limit_aktywnych=%d)",
           czas_symulacji, limit_utworzonych, limit_aktywnych);
     
-    time_t czas_startu = g_shm->czas_startu;
+    long long czas_startu = g_shm->kotwica.mono_ns;
     int id_klienta = 0;
     int wygenerowano = 0;
     int limit_zalogowany = 0;
     
     /* Główna pętla generowania - TYLKO gdy FAZA_OPEN */
-    while (!g_koniec && g_shm->faza_dnia == FAZA_OPEN) {
+    while (!g_koniec && STAN(faza_dnia) == FAZA_OPEN) {
         reap_children_and_maybe_panic();
         /* Sprawdź czas */
         if (czy_koniec_symulacji(czas_startu, czas_symulacji)) {
@@ -148,7 +148,7 @@ int main(int argc, char *argv[]) {
         }
         
         /* Sprawdź czy kolej aktywna */
-        if (g_shm->awaria) {
+        if (STAN(awaria)) {
             poll(NULL, 0, 100);
             continue;
         }
@@ -174,7 +174,7 @@ int main(int argc, char *argv[]) {
         int opoznienie = 0;
         poll(NULL, 0, opoznienie);
         
-        if (g_koniec || g_shm->faza_dnia != FAZA_OPEN) break;
+        if (g_koniec || STAN(faza_dnia) != FAZA_OPEN) break;
         
         /* Generuj parametry klienta */
         int next_id = id_klienta + 1;
@@ -237,14 +237,8 @@ int main(int argc, char *argv[]) {
         if (pid > 0) {
             id_klienta = next_id;
             wygenerowano++;
-            if (liczba_dzieci == 0) {
-                loguj("GENERATOR: utworzono klienta id=%d pid=%d wiek=%d typ=%s vip=%d dzieci=0",
-                      id_klienta, (int)pid, wiek, nazwa_typu_klienta(typ), vip);
-            } else {
-                loguj("GENERATOR: utworzono klienta id=%d pid=%d wiek=%d typ=%s vip=%d dzieci=%d (wiek:%d,%d)",
-                      id_klienta, (int)pid, wiek, nazwa_typu_klienta(typ), vip,
-                      liczba_dzieci, wiek_dzieci[0], wiek_dzieci[1]);
-            }
+            LOG_ZDARZENIE(ZD_GENERATOR_KLIENT, id_klienta, (int)pid, wiek, typ, vip,
+                          liczba_dzieci, wiek_dzieci[0], wiek_dzieci[1]);
         }
         
         /* Proces rodzica kontynuuje */
@@ -0,0 +1,230 @@
+#include <stdio.h>
+#include <string.h>
+#include "histogram.h"
+#include "ipc.h"
+
+/*
+ * KOLEJ KRZESEŁKOWA - HISTOGRAMY CZASÓW ETAPÓW (log-liniowe)
+ *
+ * Indeks kubełka dla v µs:
+ *   v < 2*HIST_POD             -> v (kubełki dokładne)
+ *   dalej przesuniecie = msb(v) - HIST_BITY_POD,
+ *         indeks = przesuniecie * HIST_POD + (v >> przesuniecie)
+ * czyli HIST_POD równych kubełków na każdą kolejną potęgę dwójki.
+ */
+
+_Static_assert(HIST_BITY < 64, "histogram: HIST_BITY poza zakresem unsigned long");
+
+static int kubelek(unsigned long v) {
+    if (v >= (1UL << HIST_BITY)) v = (1UL << HIST_BITY) - 1;
+    if (v < (unsigned long)(2 * HIST_POD)) return (int)v;
+
+    int msb = 63 - __builtin_clzl(v);
+    int przesuniecie = msb - HIST_BITY_POD;
+    return przesuniecie * HIST_POD + (int)(v >> przesuniecie);
+}
+
+/* Największa wartość trafiająca do kubełka i */
+static unsigned long gora_kubelka(int i) {
+    if (i < 2 * HIST_POD) return (unsigned long)i;
+
+    int przesuniecie = i / HIST_POD - 1;
+    unsigned long mantysa = (unsigned long)(i % HIST_POD + HIST_POD);
+    return ((mantysa + 1) << przesuniecie) - 1;
+}
+
+int histogram_klasa(TypKlienta typ, int vip) {
+    if (vip) return KLASA_VIP;
+    return (typ == TYP_ROWERZYSTA) ? KLASA_ROWER : KLASA_PIESZY;
+}
+
+void histogram_dodaj(Histogram *h, long long czas_ns) {
+    if (czas_ns < 0) czas_ns = 0;
+    unsigned long us = (unsigned long)(czas_ns / 1000);
+
+    __atomic_fetch_add(&h->kubelki[kubelek(us)], 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&h->suma_us, us, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&h->liczba, 1, __ATOMIC_RELAXED);
+
+    unsigned long max = __atomic_load_n(&h->max_us, __ATOMIC_RELAXED);
+    while (us > max &&
+           !__atomic_compare_exchange_n(&h->max_us, &max, us, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+}
+
+void histogram_kopiuj(const Histogram *h, Histogram *kopia) {
+    kopia->liczba = __atomic_load_n(&h->liczba, __ATOMIC_RELAXED);
+    kopia->suma_us = __atomic_load_n(&h->suma_us, __ATOMIC_RELAXED);
+    kopia->max_us = __atomic_load_n(&h->max_us, __ATOMIC_RELAXED);
+    for (int i = 0; i < HIST_KUBELKI; i++) {
+        kopia->kubelki[i] = __atomic_load_n(&h->kubelki[i], __ATOMIC_RELAXED);
+    }
+}
+
+void histogram_zapisz(EtapKlienta etap, int klasa, long long czas_ns) {
+    if (g_shm == NULL || etap < 0 || etap >= ETAP_LICZBA || klasa < 0 || klasa >= KLASA_LICZBA) return;
+    histogram_dodaj(&g_shm->hist[etap][klasa], czas_ns);
+}
+
+void histogram_odczytaj(EtapKlienta etap, int klasa, Histogram *kopia) {
+    memset(kopia, 0, sizeof(*kopia));
+    if (g_shm == NULL || etap < 0 || etap >= ETAP_LICZBA || klasa < 0 || klasa >= KLASA_LICZBA) return;
+    histogram_kopiuj(&g_shm->hist[etap][klasa], kopia);
+}
+
+unsigned long histogram_percentyl(const Histogram *h, double p) {
+    unsigned long w_kubelkach = 0;
+    for (int i = 0; i < HIST_KUBELKI; i++) w_kubelkach += h->kubelki[i];
+    if (w_kubelkach == 0) return 0;
+
+    /* Ranga liczona z sumy kubełków: kopia w trakcie zapisu może się minąć z h->liczba */
+    unsigned long ranga = (unsigned long)(p * (double)w_kubelkach + 0.999999);
+    if (ranga < 1) ranga = 1;
+    if (ranga > w_kubelkach) ranga = w_kubelkach;
+
+    unsigned long narastajaco = 0;
+    for (int i = 0; i < HIST_KUBELKI; i++) {
+        narastajaco += h->kubelki[i];
+        if (narastajaco >= ranga) {
+            unsigned long v = gora_kubelka(i);
+            return (h->max_us > 0 && v > h->max_us) ? h->max_us : v;
+        }
+    }
+    return h->max_us;
+}
+
+const char *nazwa_etapu(EtapKlienta etap) {
+    switch (etap) {
+        case ETAP_KASA:     return "KASA";
+        case ETAP_BRAMKA1:  return "BRAMKA1";
+        case ETAP_PERON:    return "PERON";
+        case ETAP_BOARD:    return "BOARD";
+        case ETAP_PRZEJAZD: return "PRZEJAZD";
+        default:            return "?";
+    }
+}
+
+const char *nazwa_nadrabiania(int tryb) {
+    switch (tryb) {
+        case NADRABIANIE_SERIA:   return "seria";
+        case NADRABIANIE_POMIN:   return "pomin";
+        case NADRABIANIE_PRZESUN: return "przesun";
+        default:                  return "?";
+    }
+}
+
+const char *nazwa_pakowania(int polityka) {
+    switch (polityka) {
+        case PAKOWANIE_ZACHLANNA: return "zachlanna";
+        case PAKOWANIE_FFD:       return "ffd";
+        case PAKOWANIE_DOKLADNA:  return "dokladna";
+        default:                  return "?";
+    }
+}
+
+const char *nazwa_klasy(int klasa) {
+    switch (klasa) {
+        case KLASA_PIESZY: return "PIESZY";
+        case KLASA_ROWER:  return "ROWER";
+        case KLASA_VIP:    return "VIP";
+        default:           return "?";
+    }
+}
+
+void histogramy_wypisz(FILE *f) {
+    static Histogram h;     // ~4 KB - nie na stosie
+    int wierszy = 0;
+
+    fprintf(f, "%-9s %-7s %8s %9s %9s %9s %9s %9s %9s\n",
+            "ETAP", "KLASA", "LICZBA", "srednia", "p50", "p90", "p99", "p99.9", "max");
+    for (int e = 0; e < ETAP_LICZBA; e++) {
+        for (int k = 0; k < KLASA_LICZBA; k++) {
+            histogram_odczytaj((EtapKlienta)e, k, &h);
+            if (h.liczba == 0) continue;
+
+            fprintf(f, "%-9s %-7s %8lu %9.3f %9.3f %9.3f %9.3f %9.3f %9.3f\n",
+                    nazwa_etapu((EtapKlienta)e), nazwa_klasy(k), h.liczba,
+                    (double)h.suma_us / (double)h.liczba / 1000.0,
+                    histogram_percentyl(&h, 0.50) / 1000.0,
+                    histogram_percentyl(&h, 0.90) / 1000.0,
+                    histogram_percentyl(&h, 0.99) / 1000.0,
+                    histogram_percentyl(&h, 0.999) / 1000.0,
+                    h.max_us / 1000.0);
+            wierszy++;
+        }
+    }
+    if (wierszy == 0) {
+        fprintf(f, "(brak pomiarów)\n");
+    }
+}
+
+void zegar_wyciagu_wypisz(FILE *f) {
+    static Histogram opoznienie, praca;     // ~4 KB każdy - nie na stosie
+    const ZegarWyciagu *z = (g_shm != NULL) ? &g_shm->zegar_wyciagu : NULL;
+
+    long long start = z ? __atomic_load_n(&z->start_ns, __ATOMIC_RELAXED) : 0;
+    if (start == 0) {
+        fprintf(f, "(wyciąg nie ruszył)\n");
+        return;
+    }
+    long long ostatni = __atomic_load_n(&z->ostatni_ns, __ATOMIC_RELAXED);
+    unsigned long ticki = __atomic_load_n(&z->ticki, __ATOMIC_RELAXED);
+    histogram_kopiuj(&z->opoznienie, &opoznienie);
+    histogram_kopiuj(&z->praca, &praca);
+
+    /* Tempo realne vs nominalne (od pierwszego do ostatniego ticka) */
+    double sekundy = (double)(ostatni - start) / 1e9;
+    /* Linie tykają niezależnie, ticki są sumą linii */
+    int interwal_ms = g_shm->wyciag.interwal_ms;
+    int linie = g_shm->wyciag.linie;
+    double nominalne = linie * 1000.0 / interwal_ms;
+    double realne = (sekundy > 0.0 && ticki > 1) ? (double)(ticki - 1) / sekundy : 0.0;
+
+    fprintf(f, "Tryb nadrabiania:    %s (interwał %d ms, linie %d)\n",
+            nazwa_nadrabiania(__atomic_load_n(&z->tryb, __ATOMIC_RELAXED)), interwal_ms, linie);
+    fprintf(f, "Ticki:               %lu w %.3f s (%.1f/s, nominalnie %.1f/s = %.1f%%)\n",
+            ticki, sekundy, realne, nominalne, realne * 100.0 / nominalne);
+    fprintf(f, "Zaległe / pominięte: %lu / %lu\n",
+            __atomic_load_n(&z->zalegle, __ATOMIC_RELAXED), __atomic_load_n(&z->pominiete, __ATOMIC_RELAXED));
+    fprintf(f, "%-10s %8s %9s %9s %9s %9s %9s\n", "TICK (ms)", "LICZBA", "srednia", "p50", "p99", "p99.9", "max");
+    const Histogram *h[2] = {&opoznienie, &praca};
+    const char *nazwy[2] = {"opoznienie", "praca"};
+    for (int i = 0; i < 2; i++) {
+        if (h[i]->liczba == 0) continue;
+        fprintf(f, "%-10s %8lu %9.3f %9.3f %9.3f %9.3f %9.3f\n",
+                nazwy[i], h[i]->liczba,
+                (double)h[i]->suma_us / (double)h[i]->liczba / 1000.0,
+                histogram_percentyl(h[i], 0.50) / 1000.0,
+                histogram_percentyl(h[i], 0.99) / 1000.0,
+                histogram_percentyl(h[i], 0.999) / 1000.0,
+                h[i]->max_us / 1000.0);
+    }
+}
+
+void pakowanie_wypisz(FILE *f) {
+    if (g_shm == NULL) return;
+    const PakowanieWyciagu *p = &g_shm->pakowanie;
+    unsigned long rzedy = __atomic_load_n(&p->rzedy, __ATOMIC_RELAXED);
+    unsigned long sloty = __atomic_load_n(&p->sloty, __ATOMIC_RELAXED);
+
+    fprintf(f, "Polityka:            %s (okno %d, max wyprzedzeń %d)\n",
+            nazwa_pakowania(__atomic_load_n(&p->polityka, __ATOMIC_RELAXED)),
+            PAKOWANIE_OKNO, PAKOWANIE_MAX_WYPRZEDZEN);
+    fprintf(f, "Rzędy z kolejki:     %lu, sloty %lu (wykorzystanie %.1f%%)\n",
+            rzedy, sloty, rzedy ? (double)sloty * 100.0 / ((double)rzedy * g_shm->wyciag.krzesla_w_rzedzie) : 0.0);
+    fprintf(f, "Grupy:               %lu\n", __atomic_load_n(&p->grupy, __ATOMIC_RELAXED));
+    fprintf(f, "Wyprzedzenia:        %lu (max na grupę %d, wymuszone wejścia %lu)\n",
+            __atomic_load_n(&p->wyprzedzenia, __ATOMIC_RELAXED),
+            __atomic_load_n(&p->wyprzedzenia_max, __ATOMIC_RELAXED),
+            __atomic_load_n(&p->wymuszone, __ATOMIC_RELAXED));
+}
+
+void linie_wypisz(FILE *f) {
+    if (g_shm == NULL) return;
+    for (int l = 0; l < g_shm->wyciag.linie; l++) {
+        const LiniaWyciagu *lw = &g_shm->linie[l];
+        fprintf(f, "Linia %d:             grupy %lu, zajęte sloty peronu %d\n", l + 1,
+                __atomic_load_n(&lw->grupy, __ATOMIC_RELAXED),
+                linia_peron_zajety(l + 1));
+    }
+}
@@ -0,0 +1,82 @@
+#ifndef HISTOGRAM_H
+#define HISTOGRAM_H
+
+#include <stdio.h>
+#include "types.h"
+
+/*
+ * KOLEJ KRZESEŁKOWA - HISTOGRAMY CZASÓW ETAPÓW
+ * Klient mierzy każdy etap (czas_mono_ns) i dokłada pomiar do
+ * g_shm->hist[etap][klasa]: kilka atomowych addów, bez mutexa.
+ * Raport dzienny i monitor pokazują p50/p90/p99/p99.9/max.
+ * Te same kubełki mierzą ticki wyciągu (g_shm->zegar_wyciagu).
+ */
+
+/*
+ * Dokłada pomiar czas_ns do dowolnego histogramu (atomowo, wielu piszących)
+ */
+void histogram_dodaj(Histogram *h, long long czas_ns);
+
+/*
+ * Kopia dowolnego histogramu (odczyt relaxed)
+ */
+void histogram_kopiuj(const Histogram *h, Histogram *kopia);
+
+/*
+ * Klasa klienta do histogramu (VIP ma własną niezależnie od typu)
+ */
+int histogram_klasa(TypKlienta typ, int vip);
+
+/*
+ * Dokłada pomiar czas_ns do histogramu etapu
+ */
+void histogram_zapisz(EtapKlienta etap, int klasa, long long czas_ns);
+
+/*
+ * Kopia histogramu (odczyt relaxed - wystarczy do raportu / monitora)
+ */
+void histogram_odczytaj(EtapKlienta etap, int klasa, Histogram *kopia);
+
+/*
+ * Percentyl p (0..1) w µs: górna granica kubełka, nie więcej niż max
+ * Zwraca: 0 przy pustym histogramie
+ */
+unsigned long histogram_percentyl(const Histogram *h, double p);
+
+/*
+ * Nazwa etapu / klasy do raportów
+ */
+const char *nazwa_etapu(EtapKlienta etap);
+const char *nazwa_klasy(int klasa);
+
+/*
+ * Nazwa trybu nadrabiania zegara wyciągu (NADRABIANIE_*)
+ */
+const char *nazwa_nadrabiania(int tryb);
+
+/*
+ * Nazwa polityki pakowania rzędu (PAKOWANIE_*)
+ */
+const char *nazwa_pakowania(int polityka);
+
+/*
+ * Tabela percentyli wszystkich niepustych histogramów (ms)
+ */
+void histogramy_wypisz(FILE *f);
+
+/*
+ * Zegar wyciągu: tempo ticków, zaległe / pominięte, opóźnienie i praca ticka (ms)
+ */
+void zegar_wyciagu_wypisz(FILE *f);
+
+/*
+ * Pakowanie rzędów: polityka, wykorzystanie slotów, wyprzedzenia
+ */
+void pakowanie_wypisz(FILE *f);
+
+/*
+ * Linie wyciągu: grupy przewiezione i zajęte sloty peronu każdej linii
+ */
+void linie_wypisz(FILE *f);
+
+#endif /* HISTOGRAM_H */
@@ -12,8 +12,15 @@
 #include <sys/msg.h>
 #include <sys/prctl.h>
 #include <signal.h>
+#include <poll.h>
+#include <sched.h>
+#include <pthread.h>
 #include "ipc.h"
 #include "utils.h"
+#include "czas.h"
+#include "kolejki_shm.h"
+#include "statystyki.h"
+#include "zdarzenia.h"
 
 /*
  * KOLEJ KRZESEŁKOWA - IMPLEMENTACJA IPC
@@ -25,6 +32,12 @@
 int g_sem_id = -1;
 int g_shm_id = -1;
 SharedMemory *g_shm = NULL;
+
+/* Pierścień logu przejść (region 4 segmentu, patrz geometria) */
+static Pierscien *g_logi = NULL;
+
+/* Chunki karnetów podpięte w tym procesie (leniwie, patrz chunk_karnetow) */
+static Karnet *g_chunki_karnetow[KARNETY_MAX_CHUNKOW];
 int g_mq_kasa = -1;
 int g_mq_kasa_odp = -1;
 int g_mq_bramka = -1;
@@ -35,6 +48,11 @@ int g_mq_wyciag_odp = -1;  /* odpowiedzi wyciągu */
 int g_mq_peron = -1;      /* kolejka klient->pracownik1 */
 int g_mq_peron_odp = -1;  /* odpowiedzi pracownik1->klient */
 
+/* Segment pierścieni (tylko TRANSPORT_SHM) */
+static int g_shmq_id = -1;
+static void *g_shmq = NULL;
+int g_skrzynka = -1;      /* skrzynka odpowiedzi tego procesu */
+
 /* Klucz bazowy (ustawiany przy init) */
 static key_t g_klucz_bazowy = -1;
 
@@ -74,11 +92,11 @@ void ustaw_smierc_z_rodzicem(void) {
 
 int czy_rodzic_zyje(void) {
     /* Sprawdź czy główny proces (main) jeszcze żyje */
-    /* Używamy g_shm->pid_main zamiast getppid() bo niektóre procesy */
+    /* Używamy STAN(pid_main) zamiast getppid() bo niektóre procesy */
     /* są dziećmi generatora, nie maina */
     if (g_shm == NULL) return 0;
     
-    pid_t main_pid = g_shm->pid_main;
+    pid_t main_pid = STAN(pid_main);
     if (main_pid <= 0) return 0;
     
     /* kill z sygnałem 0 sprawdza tylko czy proces istnieje */
@@ -118,7 +136,182 @@ static key_t generuj_klucz(int offset) {
  * INICJALIZACJA IPC (tylko main)
  * ============================================ */
 
-int init_ipc(int N) {
+/* Tworzy segment pierścieni i podmienia g_mq_* gorącej ścieżki na uchwyty SHM */
+static int init_kolejki_shm(void) {
+    size_t rozmiar = kolejki_shm_rozmiar();
+
+    g_shmq_id = shmget(generuj_klucz(IPC_KEY_SHM_KOLEJKI), rozmiar, IPC_CREAT | IPC_EXCL | IPC_PERMS);
+    if (g_shmq_id == -1 && errno == EEXIST) {
+        g_shmq_id = shmget(generuj_klucz(IPC_KEY_SHM_KOLEJKI), 1, IPC_PERMS);
+        if (g_shmq_id != -1) shmctl(g_shmq_id, IPC_RMID, NULL);
+        g_shmq_id = shmget(generuj_klucz(IPC_KEY_SHM_KOLEJKI), rozmiar, IPC_CREAT | IPC_EXCL | IPC_PERMS);
+    }
+    if (g_shmq_id == -1) {
+        blad_ostrzezenie("shmget kolejki");
+        return -1;
+    }
+
+    g_shmq = shmat(g_shmq_id, NULL, 0);
+    if (g_shmq == (void *)-1) {
+        blad_ostrzezenie("shmat kolejki");
+        g_shmq = NULL;
+        return -1;
+    }
+
+    kolejki_shm_init(g_shmq);
+    g_mq_kasa = SHMQ_UCHWYT(SHMQ_KASA);
+    g_mq_bramka = SHMQ_UCHWYT(SHMQ_BRAMKA);
+    g_mq_peron = SHMQ_UCHWYT(SHMQ_PERON);
+    g_mq_wyciag_req = SHMQ_UCHWYT(SHMQ_WYCIAG_REQ);
+
+    loguj("Kolejki SHM utworzone (id=%d, size=%zu)", g_shmq_id, rozmiar);
+    return 0;
+}
+
+/* Podpina istniejący segment pierścieni (procesy potomne) */
+static int attach_kolejki_shm(void) {
+    g_shmq_id = shmget(generuj_klucz(IPC_KEY_SHM_KOLEJKI), kolejki_shm_rozmiar(), 0);
+    if (g_shmq_id == -1) {
+        blad_ostrzezenie("shmget kolejki (attach)");
+        return -1;
+    }
+
+    g_shmq = shmat(g_shmq_id, NULL, 0);
+    if (g_shmq == (void *)-1) {
+        blad_ostrzezenie("shmat kolejki (attach)");
+        g_shmq = NULL;
+        return -1;
+    }
+
+    if (kolejki_shm_dolacz(g_shmq) != 0) {
+        fprintf(stderr, "attach: segment kolejek SHM ma inną wersję/rozmiar\n");
+        shmdt(g_shmq);
+        g_shmq = NULL;
+        return -1;
+    }
+
+    g_mq_kasa = SHMQ_UCHWYT(SHMQ_KASA);
+    g_mq_bramka = SHMQ_UCHWYT(SHMQ_BRAMKA);
+    g_mq_peron = SHMQ_UCHWYT(SHMQ_PERON);
+    g_mq_wyciag_req = SHMQ_UCHWYT(SHMQ_WYCIAG_REQ);
+    return 0;
+}
+
+/* ============================================
+ * GEOMETRIA SEGMENTU SHM
+ * ============================================ */
+
+static size_t zaokraglij_do_strony(size_t n) {
+    return (n + SHM_STRONA - 1) & ~(size_t)(SHM_STRONA - 1);
+}
+
+static long z_zapasem(long oczekiwane, int zapas_proc) {
+    long p = oczekiwane + oczekiwane * zapas_proc / 100;
+    return p < 1 ? 1 : p;
+}
+
+void geometria_shm_oblicz(GeometriaShm *geo, int limit_klientow, int zapas_proc, int pojemnosc_zdarzen) {
+    if (zapas_proc < 0) zapas_proc = 0;
+
+    if (limit_klientow > 0) {
+        long karnety = z_zapasem((long)limit_klientow * KARNETY_NA_KLIENTA, zapas_proc);
+        long chunki = (karnety + KARNETY_W_CHUNKU - 1) / KARNETY_W_CHUNKU;
+        geo->chunki_karnetow_start = chunki > KARNETY_MAX_CHUNKOW ? KARNETY_MAX_CHUNKOW : (int)chunki;
+    } else {
+        /* Bez limitu klientów nie da się oszacować: karnety dorosną same */
+        geo->chunki_karnetow_start = 1;
+    }
+
+    /* Log przejść nie zależy od długości dnia: main drenuje pierścień na bieżąco */
+    geo->pojemnosc_logow = LOGI_PIERSCIEN;
+    geo->offset_logow = zaokraglij_do_strony(sizeof(SharedMemory));
+    geo->offset_zdarzen = zaokraglij_do_strony(geo->offset_logow +
+                                               pierscien_rozmiar(LOGI_PIERSCIEN, sizeof(LogEntry)));
+    geo->pojemnosc_zdarzen = pojemnosc_zdarzen > 0 ? pojemnosc_zdarzen : 0;
+    geo->rozmiar_segmentu = zaokraglij_do_strony(geo->offset_zdarzen +
+                                                 zdarzenia_rozmiar(geo->pojemnosc_zdarzen));
+}
+
+/* Ustawia g_logi z geometrii w nagłówku segmentu */
+static void podepnij_magazyny(void) {
+    g_logi = (Pierscien *)((char *)g_shm + g_shm->geometria.offset_logow);
+}
+
+/* ============================================
+ * MAGAZYN KARNETÓW - CHUNKI
+ * Chunk = osobny segment (klucz IPC_KEY_SHM_KARNETY + nr) na KARNETY_W_CHUNKU
+ * karnetów. Brakujący chunk tworzy utworz_karnet (kasjer, pod mutexem SHM):
+ * najpierw shmid do id_chunkow_karnetow[nr], potem publikacja chunki_karnetow.
+ * Czytelnicy podpinają chunk przy pierwszym dostępie; id -> (chunk, offset)
+ * to przesunięcie i maska, więc pobierz_karnet() zostaje O(1).
+ * ============================================ */
+
+/* Tworzy i publikuje chunk nr (main przed fork albo pod mutexem SHM). 0=OK, -1=błąd */
+static int utworz_chunk_karnetow(int nr) {
+    size_t rozmiar = (size_t)KARNETY_W_CHUNKU * sizeof(Karnet);
+    key_t klucz = generuj_klucz(IPC_KEY_SHM_KARNETY + nr);
+
+    int id = shmget(klucz, rozmiar, IPC_CREAT | IPC_EXCL | IPC_PERMS);
+    if (id == -1 && errno == EEXIST) {
+        /* Pozostałość po poprzednim uruchomieniu */
+        int stary = shmget(klucz, 1, IPC_PERMS);
+        if (stary != -1) shmctl(stary, IPC_RMID, NULL);
+        id = shmget(klucz, rozmiar, IPC_CREAT | IPC_EXCL | IPC_PERMS);
+    }
+    if (id == -1) {
+        blad_ostrzezenie("shmget chunk karnetów");
+        return -1;
+    }
+
+    g_shm->id_chunkow_karnetow[nr] = id;
+    __atomic_store_n(&g_shm->chunki_karnetow, nr + 1, __ATOMIC_RELEASE);
+    return 0;
+}
+
+/* Chunk nr w przestrzeni tego procesu (podpina przy pierwszym użyciu). NULL = brak */
+static Karnet *chunk_karnetow(int nr) {
+    Karnet *c = __atomic_load_n(&g_chunki_karnetow[nr], __ATOMIC_ACQUIRE);
+    if (c != NULL) return c;
+    if (nr >= __atomic_load_n(&g_shm->chunki_karnetow, __ATOMIC_ACQUIRE)) return NULL;
+
+    void *p = shmat(g_shm->id_chunkow_karnetow[nr], NULL, 0);
+    if (p == (void *)-1) return NULL;
+
+    /* Wątki klienta mogą podpinać równolegle - zostaje pierwszy, reszta odpina swój */
+    Karnet *oczekiwany = NULL;
+    if (!__atomic_compare_exchange_n(&g_chunki_karnetow[nr], &oczekiwany, (Karnet *)p,
+                                     0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        shmdt(p);
+        return oczekiwany;
+    }
+    return (Karnet *)p;
+}
+
+static Karnet *karnet_po_indeksie(int idx) {
+    Karnet *c = chunk_karnetow(idx >> KARNETY_CHUNK_BITY);
+    return c != NULL ? &c[idx & (KARNETY_W_CHUNKU - 1)] : NULL;
+}
+
+/* Odpina chunki w tym procesie (segmenty zostają) */
+static void odlacz_chunki_karnetow(void) {
+    for (int i = 0; i < KARNETY_MAX_CHUNKOW; i++) {
+        if (g_chunki_karnetow[i] != NULL) {
+            shmdt(g_chunki_karnetow[i]);
+            g_chunki_karnetow[i] = NULL;
+        }
+    }
+}
+
+void geometria_wyciagu_domyslna(GeometriaWyciagu *w) {
+    w->rzedy = LICZBA_RZEDOW;
+    w->krzesla_w_rzedzie = KRZESLA_W_RZEDZIE;
+    w->peron_sloty = PERON_SLOTY;
+    w->interwal_ms = INTERWAL_KRZESELKA_MS;
+    w->pozycja_gorna = LICZBA_RZEDOW / 2;
+    w->linie = 1;
+}
+
+int init_ipc(int N, int transport, const GeometriaShm *geo, const GeometriaWyciagu *wyciag) {
     loguj("Inicjalizacja IPC (N=%d)...", N);
     
     /* 1. Generuj klucz bazowy */
@@ -153,7 +346,7 @@ int init_ipc(int N) {
         [SEM_MUTEX_SHM]      = 1,    // mutex
         [SEM_MUTEX_KASA]     = 1,    // mutex
         [SEM_MUTEX_LOG]      = 1,    // mutex
-        [SEM_PERON]          = KRZESLA_W_RZEDZIE, // miejsca w rzędzie
+        [SEM_PERON]          = (unsigned short)wyciag->peron_sloty, // sloty peronu
         [SEM_PRACOWNIK1]     = 0,    // sygnalizacja
         [SEM_PRACOWNIK2]     = 0,    // sygnalizacja
         [SEM_GOTOWY_P1]      = 0,    // gotowość
@@ -162,6 +355,11 @@ int init_ipc(int N) {
         [SEM_BARIERA_AWARIA] = 0     // bariera awarii (procesy czekają tu)
     };
     
+    /* Perony dalszych linii (nieużywane linie zostają z 0) */
+    for (int l = 2; l <= wyciag->linie; l++) {
+        sem_init_vals[SEM_PERON_LINII(l)] = (unsigned short)wyciag->peron_sloty;
+    }
+
     union semun arg;
     arg.array = sem_init_vals;
     if (semctl(g_sem_id, 0, SETALL, arg) == -1) {
@@ -171,15 +369,16 @@ int init_ipc(int N) {
     loguj("Semafory utworzone (id=%d)", g_sem_id);
     
     /* 3. Utwórz pamięć współdzieloną */
-    g_shm_id = shmget(generuj_klucz(IPC_KEY_SHM), sizeof(SharedMemory), IPC_CREAT | IPC_EXCL | IPC_PERMS);
+    g_shm_id = shmget(generuj_klucz(IPC_KEY_SHM), geo->rozmiar_segmentu, IPC_CREAT | IPC_EXCL | IPC_PERMS);
     if (g_shm_id == -1) {
         if (errno == EEXIST) {
             loguj("Pamięć współdzielona już istnieje - próba usunięcia...");
-            g_shm_id = shmget(generuj_klucz(IPC_KEY_SHM), sizeof(SharedMemory), IPC_PERMS);
+            /* rozmiar 1: stary segment może mieć inną geometrię */
+            g_shm_id = shmget(generuj_klucz(IPC_KEY_SHM), 1, IPC_PERMS);
             if (g_shm_id != -1) {
                 shmctl(g_shm_id, IPC_RMID, NULL);
             }
-            g_shm_id = shmget(generuj_klucz(IPC_KEY_SHM), sizeof(SharedMemory), IPC_CREAT | IPC_EXCL | IPC_PERMS);
+            g_shm_id = shmget(generuj_klucz(IPC_KEY_SHM), geo->rozmiar_segmentu, IPC_CREAT | IPC_EXCL | IPC_PERMS);
         }
         if (g_shm_id == -1) {
             blad_ostrzezenie("shmget");
@@ -194,15 +393,50 @@ int init_ipc(int N) {
         return -1;
     }
     
-    /* Wyzeruj pamięć */
+    /* Wyzeruj część stałą (magazyny są zerowe ze shmget, nie dotykamy ich stron) */
     memset(g_shm, 0, sizeof(SharedMemory));
-    g_shm->kolej_aktywna = 1;
-    g_shm->czas_startu = time(NULL);
+
+    /* Mutex SHM: współdzielony między procesami + odporny na śmierć właściciela */
+    {
+        pthread_mutexattr_t attr;
+        pthread_mutexattr_init(&attr);
+        pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+        pthread_mutexattr_setrobust(&attr, PTHREAD_MUTEX_ROBUST);
+        int r = pthread_mutex_init(&g_shm->mutex_shm, &attr);
+        pthread_mutexattr_destroy(&attr);
+        if (r != 0) {
+            errno = r;
+            blad_ostrzezenie("pthread_mutex_init mutex_shm");
+            return -1;
+        }
+    }
+    STAN_USTAW(kolej_aktywna, 1);
+    czas_kotwica_ustaw(&g_shm->kotwica);
     g_shm->nastepny_id_karnetu = 1;
     g_shm->nastepny_id_klienta = 1;
-    g_shm->pid_main = getpid();
+    STAN_USTAW(pid_main, getpid());
+    g_shm->transport = transport;
+
+    /* Nagłówek układu na końcu: segment jest gotowy dla attach_ipc */
+    g_shm->magic = SHM_MAGIC;
+    g_shm->wersja_ukladu = SHM_WERSJA_UKLADU;
+    g_shm->rozmiar = sizeof(SharedMemory);
+    g_shm->geometria = *geo;
+    g_shm->wyciag = *wyciag;
+    podepnij_magazyny();
+    pierscien_init(g_logi, (unsigned int)geo->pojemnosc_logow, sizeof(LogEntry));
+    zdarzenia_init();
+
+    /* Początkowe chunki karnetów (kolejne dołoży kasjer, gdy zabraknie) */
+    for (int i = 0; i < geo->chunki_karnetow_start; i++) {
+        if (utworz_chunk_karnetow(i) != 0) {
+            return -1;
+        }
+    }
     
-    loguj("Pamięć współdzielona utworzona (id=%d, size=%zu)", g_shm_id, sizeof(SharedMemory));
+    loguj("Pamięć współdzielona utworzona (id=%d, size=%zu, układ v%d, logi=%d, chunki karnetów=%d x %d, zdarzenia=%d)",
+          g_shm_id, geo->rozmiar_segmentu, SHM_WERSJA_UKLADU,
+          geo->pojemnosc_logow, geo->chunki_karnetow_start, KARNETY_W_CHUNKU, geo->pojemnosc_zdarzen);
     
     /* 4. Utwórz kolejki komunikatów */
     g_mq_kasa = msgget(generuj_klucz(IPC_KEY_MQ_KASA), IPC_CREAT | IPC_EXCL | IPC_PERMS);
@@ -309,6 +543,16 @@ int init_ipc(int N) {
     }
     
     loguj("Kolejki komunikatów utworzone");
+
+    /* 5. Pierścienie SHM zamiast kolejek SysV na gorącej ścieżce.
+     * Kolejki SysV o tych samych kluczach i tak istnieją (puste) -
+     * cleanup i sprzątacz działają bez zmian. */
+    if (transport == TRANSPORT_SHM) {
+        if (init_kolejki_shm() != 0) {
+            return -1;
+        }
+    }
+    loguj("Transport komunikatów: %s", transport == TRANSPORT_SHM ? "shm" : "sysv");
     
     loguj("Inicjalizacja IPC zakończona pomyślnie");
     return 0;
@@ -320,13 +564,35 @@ int init_ipc(int N) {
 
 void cleanup_ipc(void) {
     loguj("Czyszczenie zasobów IPC...");
+
+    /* Pierścienie SHM: najpierw obudź wszystkich czekających (dostaną -2) */
+    if (g_shmq != NULL) {
+        kolejki_shm_zamknij();
+        kolejki_shm_odlacz();
+        shmdt(g_shmq);
+        g_shmq = NULL;
+    }
+    if (g_shmq_id != -1) {
+        shmctl(g_shmq_id, IPC_RMID, NULL);
+        g_shmq_id = -1;
+    }
     
+    /* Chunki karnetów: odepnij i usuń (shmid znamy z nagłówka) */
+    odlacz_chunki_karnetow();
+    if (g_shm != NULL) {
+        int chunki = __atomic_load_n(&g_shm->chunki_karnetow, __ATOMIC_ACQUIRE);
+        for (int i = 0; i < chunki; i++) {
+            shmctl(g_shm->id_chunkow_karnetow[i], IPC_RMID, NULL);
+        }
+    }
+
     /* Odłącz pamięć współdzieloną */
     if (g_shm != NULL) {
         if (shmdt(g_shm) == -1) {
             blad_ostrzezenie("shmdt");
         }
         g_shm = NULL;
+        g_logi = NULL;
     }
     
     /* Usuń pamięć współdzieloną */
@@ -347,7 +613,13 @@ void cleanup_ipc(void) {
         g_sem_id = -1;
     }
     
-    /* Usuń kolejki komunikatów */
+    /* Usuń kolejki komunikatów.
+     * Przy TRANSPORT_SHM g_mq_* gorącej ścieżki trzyma uchwyt pierścienia,
+     * a (nieużywana) kolejka SysV jest odszukiwana po kluczu. */
+    if (g_mq_kasa < -1) g_mq_kasa = msgget(generuj_klucz(IPC_KEY_MQ_KASA), 0);
+    if (g_mq_bramka < -1) g_mq_bramka = msgget(generuj_klucz(IPC_KEY_MQ_BRAMKA), 0);
+    if (g_mq_peron < -1) g_mq_peron = msgget(generuj_klucz(IPC_KEY_MQ_PERON), 0);
+    if (g_mq_wyciag_req < -1) g_mq_wyciag_req = msgget(generuj_klucz(IPC_KEY_MQ_WYCIAG_REQ), 0);
     if (g_mq_kasa != -1) {
         msgctl(g_mq_kasa, IPC_RMID, NULL);
         g_mq_kasa = -1;
@@ -401,6 +673,14 @@ void cleanup_ipc_by_keys(void) {
     int shmid = shmget(base + IPC_KEY_SHM, 1, 0);
     if (shmid != -1) shmctl(shmid, IPC_RMID, NULL);
 
+    shmid = shmget(base + IPC_KEY_SHM_KOLEJKI, 1, 0);
+    if (shmid != -1) shmctl(shmid, IPC_RMID, NULL);
+
+    for (int i = 0; i < KARNETY_MAX_CHUNKOW; i++) {
+        shmid = shmget(base + IPC_KEY_SHM_KARNETY + i, 1, 0);
+        if (shmid != -1) shmctl(shmid, IPC_RMID, NULL);
+    }
+
     int semid = semget(base + IPC_KEY_SEM, 1, 0);
     if (semid != -1) semctl(semid, 0, IPC_RMID);
 
@@ -456,7 +736,8 @@ int attach_ipc(void) {
     }
     
     /* Pobierz pamięć współdzieloną */
-    g_shm_id = shmget(generuj_klucz(IPC_KEY_SHM), sizeof(SharedMemory), 0);
+    /* Rozmiar 0: geometrię (i faktyczny rozmiar) zna tylko nagłówek segmentu */
+    g_shm_id = shmget(generuj_klucz(IPC_KEY_SHM), 0, 0);
     if (g_shm_id == -1) {
         blad_ostrzezenie("shmget (attach)");
         return -1;
@@ -469,27 +750,45 @@ int attach_ipc(void) {
         return -1;
     }
 
+    /* Sprawdź układ segmentu zanim dotkniemy jakiegokolwiek pola.
+     * W systemie może wisieć stary segment (np. po crashu / innej wersji):
+     * za mały, z innym rozkładem regionów albo z geometrią niepasującą do rozmiaru.
+     * Nagłówek leży na offsecie 0 (segment ma co najmniej stronę), więc jego odczyt
+     * jest bezpieczny zawsze.
+     */
+    {
+        struct shmid_ds ds;
+        const GeometriaShm *geo = &g_shm->geometria;
+        if (shmctl(g_shm_id, IPC_STAT, &ds) != 0 ||
+            (size_t)ds.shm_segsz < sizeof(SharedMemory) ||
+            g_shm->magic != SHM_MAGIC ||
+            g_shm->wersja_ukladu != SHM_WERSJA_UKLADU ||
+            g_shm->rozmiar != sizeof(SharedMemory) ||
+            geo->rozmiar_segmentu > (size_t)ds.shm_segsz ||
+            geo->offset_logow < sizeof(SharedMemory) ||
+            geo->pojemnosc_logow <= 0 ||
+            geo->offset_logow + pierscien_rozmiar((unsigned int)geo->pojemnosc_logow,
+                                                  sizeof(LogEntry)) > geo->offset_zdarzen ||
+            geo->offset_zdarzen + zdarzenia_rozmiar(geo->pojemnosc_zdarzen) > geo->rozmiar_segmentu) {
+            fprintf(stderr, "attach: niezgodny układ SHM (wersja=%u, oczekiwana=%d, rozmiar=%zu/%zu)\n",
+                    g_shm->wersja_ukladu, SHM_WERSJA_UKLADU,
+                    g_shm->rozmiar, sizeof(SharedMemory));
+            shmdt(g_shm);
+            g_shm = NULL;
+            return -1;
+        }
+        podepnij_magazyny();
+    }
+
     /* Upewnij się, że proces jest w grupie procesu MAIN.
      * To jest kluczowe: sprzątacz zabija całą grupę (kill(-pgid,...)).
      * Jeśli jakiś proces (np. wyciąg/klient) wyląduje w innym PGID, zostanie "persistent" po SIGKILL main.
      */
-    if (g_shm != NULL) {
-        /* UWAGA: w systemie może wisieć stary segment SHM (np. po crashu / innej wersji).
-         * Wtedy rozmiar segmentu może być mniejszy niż sizeof(SharedMemory).
-         * Odczyt pól z końca struktury (np. pid_main) może wtedy skończyć się SIGSEGV.
-         * Zabezpieczamy się, sprawdzając faktyczny rozmiar segmentu.
-         */
-        struct shmid_ds ds;
-        size_t need = offsetof(SharedMemory, pid_main) + sizeof(pid_t);
-
-        if (shmctl(g_shm_id, IPC_STAT, &ds) == 0 && (size_t)ds.shm_segsz >= need) {
-            if (g_shm->pid_main > 1) {
-                if (setpgid(0, g_shm->pid_main) == -1) {
-                    /* EPERM oznacza zwykle inną sesję/grupę; ignorujemy, bo nie możemy tego naprawić tutaj. */
-                    if (errno != EPERM) {
-                        /* nie logujemy w hot-path */
-                    }
-                }
+    if (STAN(pid_main) > 1) {
+        if (setpgid(0, STAN(pid_main)) == -1) {
+            /* EPERM oznacza zwykle inną sesję/grupę; ignorujemy, bo nie możemy tego naprawić tutaj. */
+            if (errno != EPERM) {
+                /* nie logujemy w hot-path */
             }
         }
     }
@@ -512,14 +811,32 @@ int attach_ipc(void) {
         blad_ostrzezenie("msgget (attach)");
         return -1;
     }
+
+    /* Transport SHM: podmień kolejki gorącej ścieżki na pierścienie */
+    if (g_shm->transport == TRANSPORT_SHM) {
+        if (attach_kolejki_shm() != 0) {
+            return -1;
+        }
+    }
     
     return 0;
 }
 
 void detach_ipc(void) {
+    if (g_skrzynka >= 0) {
+        skrzynka_zwolnij(g_skrzynka, getpid());
+        g_skrzynka = -1;
+    }
+    if (g_shmq != NULL) {
+        kolejki_shm_odlacz();
+        shmdt(g_shmq);
+        g_shmq = NULL;
+    }
+    odlacz_chunki_karnetow();
     if (g_shm != NULL) {
         shmdt(g_shm);
         g_shm = NULL;
+        g_logi = NULL;
     }
 }
 
@@ -551,6 +868,26 @@ void mutex_unlock(int sem_num) {
     }
 }
 
+/* Mutex SHM (robust, process-shared) */
+int shm_mutex_lock(void) {
+    if (g_shm == NULL) return -2;
+
+    int r = pthread_mutex_lock(&g_shm->mutex_shm);
+    if (r == 0) return 0;
+    if (r == EOWNERDEAD) {
+        /* Poprzedni właściciel zginął w sekcji krytycznej - przejmujemy mutex.
+         * Liczniki mogą być w połowie aktualizacji (tak samo jak przy SEM_UNDO). */
+        pthread_mutex_consistent(&g_shm->mutex_shm);
+        return 0;
+    }
+    return -2;  /* ENOTRECOVERABLE / EINVAL */
+}
+
+void shm_mutex_unlock(void) {
+    if (g_shm == NULL) return;
+    pthread_mutex_unlock(&g_shm->mutex_shm);
+}
+
 /* Zwraca: 0=OK, -1=przerwane sygnałem, -2=IPC usunięte */
 int sem_wait_ipc(int sem_num) {
     if (g_sem_id == -1) return -2;
@@ -682,6 +1019,8 @@ int sem_getval_ipc(int sem_num) {
  * ============================================ */
 
 int msg_send(int mq_id, void *msg, size_t size) {
+    if (shmq_czy_uchwyt(mq_id)) return shmq_wyslij(mq_id, msg, size, 1);
+
     while (msgsnd(mq_id, msg, size - sizeof(long), 0) == -1) {
         /* BEZ retry na EINTR: pozwól procesom zakończyć się po SIGTERM/SIGINT.
          * Jeśli syscall został przerwany sygnałem, zwróć do wywołującego,
@@ -695,6 +1034,8 @@ int msg_send(int mq_id, void *msg, size_t size) {
 }
 
 int msg_send_nowait(int mq_id, void *msg, size_t size) {
+    if (shmq_czy_uchwyt(mq_id)) return shmq_wyslij(mq_id, msg, size, 0);
+
     if (msgsnd(mq_id, msg, size - sizeof(long), IPC_NOWAIT) == -1) {
         if (errno == EAGAIN) return -1; /* kolejka pełna */
         if (errno == EINTR) return -1;
@@ -706,6 +1047,8 @@ int msg_send_nowait(int mq_id, void *msg, size_t size) {
 }
 
 int msg_recv(int mq_id, void *msg, size_t size, long mtype) {
+    if (shmq_czy_uchwyt(mq_id)) return shmq_odbierz(mq_id, msg, size, mtype, 1);
+
     ssize_t ret;
     while ((ret = msgrcv(mq_id, msg, size - sizeof(long), mtype, 0)) == -1) {
         if (errno == EINTR) return -1; /* Przerwane sygnałem - pozwól sprawdzić g_koniec */
@@ -717,6 +1060,8 @@ int msg_recv(int mq_id, void *msg, size_t size, long mtype) {
 }
 
 int msg_recv_nowait(int mq_id, void *msg, size_t size, long mtype) {
+    if (shmq_czy_uchwyt(mq_id)) return shmq_odbierz(mq_id, msg, size, mtype, 0);
+
     ssize_t ret = msgrcv(mq_id, msg, size - sizeof(long), mtype, IPC_NOWAIT);
     if (ret == -1) {
         if (errno == ENOMSG || errno == EAGAIN) return -1; /* brak wiadomości */
@@ -729,67 +1074,257 @@ int msg_recv_nowait(int mq_id, void *msg, size_t size, long mtype) {
     return (int)ret;
 }
 
+long msg_liczba(int mq_id) {
+    struct msqid_ds ds;
+    if (shmq_czy_uchwyt(mq_id)) return shmq_liczba(mq_id);
+    if (mq_id < 0) return -1;
+    if (msgctl(mq_id, IPC_STAT, &ds) == -1) return -1;
+    return (long)ds.msg_qnum;
+}
+
+/* ============================================
+ * ODPOWIEDZI DO KLIENTÓW
+ * ============================================ */
+
+int zajmij_skrzynke(void) {
+    if (g_shmq == NULL) return -1;
+    if (g_skrzynka < 0) {
+        g_skrzynka = skrzynka_zajmij(getpid());
+    }
+    return g_skrzynka;
+}
+
+int msg_send_odp(int mq_id, int skrzynka, void *msg, size_t size, int czekaj) {
+    if (skrzynka < 0 || g_shmq == NULL) {
+        return czekaj ? msg_send(mq_id, msg, size) : msg_send_nowait(mq_id, msg, size);
+    }
+
+    pid_t pid = (pid_t)*(long *)msg;
+    int backoff = 1;
+    for (;;) {
+        int r = skrzynka_wyslij(skrzynka, pid, msg, size);
+        if (r == -1 && errno == ESRCH) return 0;  /* klient już wyszedł - nie ma komu odpowiadać */
+        if (r != -1 || errno != EAGAIN || !czekaj) return r;
+
+        /* Pełna skrzynka: jak blokujący msgsnd - czekaj, aż klient odbierze,
+         * wyjdzie (ESRCH) albo IPC zniknie; sygnał przerywa (EINTR) */
+        if (poll(NULL, 0, backoff) == -1 && errno == EINTR) return -1;
+        if (backoff < ODP_BACKOFF_MAX_MS) backoff *= 2;
+    }
+}
+
+int msg_send_odp_paczka(int mq_id, int skrzynki[], void *msgs, size_t size, int n) {
+    char *baza = msgs;
+    int zostalo = 0;
+
+    for (int i = 0; i < n; i++) {
+        char *msg = baza + (size_t)i * size;
+        int r = msg_send_odp(mq_id, skrzynki[i], msg, size, 0);
+        if (r == -2) return -2;
+        if (r == -1 && errno == EAGAIN) {
+            /* Brak miejsca - zostaje w paczce (kolejność w paczce zachowana) */
+            if (zostalo != i) {
+                memmove(baza + (size_t)zostalo * size, msg, size);
+                skrzynki[zostalo] = skrzynki[i];
+            }
+            zostalo++;
+        }
+        /* Inne błędy: jak w msg_send_odp bez ponawiania - odpowiedź przepada */
+    }
+    return zostalo;
+}
+
+int msg_recv_odp(int mq_id, void *msg, size_t size, long mtype, int czekaj) {
+    if (g_skrzynka < 0) {
+        return czekaj ? msg_recv(mq_id, msg, size, mtype) : msg_recv_nowait(mq_id, msg, size, mtype);
+    }
+    return skrzynka_odbierz(g_skrzynka, (pid_t)mtype, msg, size, czekaj);
+}
+
+int msg_czekaj_odp(int mq_id, void *msg, size_t size, long mtype,
+                   unsigned int *epoka, int timeout_ms) {
+    if (g_skrzynka >= 0) {
+        return skrzynka_czekaj(g_skrzynka, (pid_t)mtype, msg, size, epoka, timeout_ms);
+    }
+
+    /* SysV: msgrcv nie da się obudzić zmianą stanu - krótki poll jak dawniej */
+    int r = msg_recv_nowait(mq_id, msg, size, mtype);
+    if (r != -1 || errno == EINTR) return r;
+    if (timeout_ms != 0) {
+        int ms = (timeout_ms > 0 && timeout_ms < ODP_POLL_MS) ? timeout_ms : ODP_POLL_MS;
+        poll(NULL, 0, ms);
+    }
+    errno = ETIMEDOUT;
+    return -1;
+}
+
+unsigned int epoka_stanu(void) {
+    return skrzynki_epoka();
+}
+
+/* ============================================
+ * STAN GLOBALNY (seqlock)
+ * ============================================ */
+
+#define STAN_PROBY_PRZED_KONTROLA 1000  // ustąpień CPU zanim sprawdzimy, czy pisarz żyje
+
+/* Słowo seq: licznik w niskich 32 bitach, PID piszącego w wysokich */
+#define STAN_LICZNIK(s)         ((unsigned int)(s))
+#define STAN_PISARZ(s)          ((pid_t)((s) >> 32))
+#define STAN_SLOWO(pid, licz)   (((unsigned long long)(unsigned int)(pid) << 32) | (unsigned int)(licz))
+
+/*
+ * Czeka aż piszący skończy. Jeśli pisarz zginął w środku sekcji
+ * (SIGKILL), zamyka ją za niego - inaczej wszyscy czytelnicy wisieliby.
+ * PID trafia do seq tym samym CAS-em, który otwiera sekcję, więc
+ * nieparzysty licznik zawsze ma właściciela do sprawdzenia.
+ */
+static void stan_czekaj_na_pisarza(unsigned long long seq, int proba) {
+    StanGlobalny *st = &g_shm->stan;
+
+    if ((seq & 1u) && proba > 0 && proba % STAN_PROBY_PRZED_KONTROLA == 0) {
+        pid_t pisarz = STAN_PISARZ(seq);
+        if (pisarz > 0 && kill(pisarz, 0) == -1 && errno == ESRCH) {
+            if (__atomic_compare_exchange_n(&st->seq, &seq, STAN_SLOWO(0, STAN_LICZNIK(seq) + 1), 0,
+                                            __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+                loguj("OSTRZEŻENIE: stan: pisarz PID=%d zginął w sekcji zapisu - przejmuję", (int)pisarz);
+            }
+        }
+    }
+    sched_yield();  /* 1 CPU: kręcenie się nic nie da, pisarz musi dostać czas */
+}
+
+static int stan_wejdz(void) {
+    StanGlobalny *st = &g_shm->stan;
+    unsigned long long seq = __atomic_load_n(&st->seq, __ATOMIC_RELAXED);
+    if (seq & 1u) return -1;
+    if (!__atomic_compare_exchange_n(&st->seq, &seq, STAN_SLOWO(getpid(), STAN_LICZNIK(seq) + 1), 0,
+                                     __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+        return -1;
+    }
+    /* Czytelnicy nie mogą zobaczyć pól sprzed nieparzystego seq */
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    return 0;
+}
+
+void stan_zapis_poczatek(void) {
+    if (g_shm == NULL) return;
+    for (int proba = 0; stan_wejdz() != 0; proba++) {
+        stan_czekaj_na_pisarza(__atomic_load_n(&g_shm->stan.seq, __ATOMIC_RELAXED), proba);
+    }
+}
+
+int stan_zapis_sprobuj(void) {
+    if (g_shm == NULL) return -1;
+    return stan_wejdz();
+}
+
+void stan_zapis_koniec(void) {
+    if (g_shm == NULL) return;
+    int e = errno;
+    StanGlobalny *st = &g_shm->stan;
+    /* Sekcję zmienia tylko jej właściciel - zwykły zapis: licznik + 1, PID = 0 */
+    unsigned long long seq = __atomic_load_n(&st->seq, __ATOMIC_RELAXED);
+    __atomic_store_n(&st->seq, STAN_SLOWO(0, STAN_LICZNIK(seq) + 1), __ATOMIC_RELEASE);
+    skrzynki_powiadom();
+    errno = e;
+}
+
+void stan_odczytaj(StanGlobalny *kopia) {
+    if (g_shm == NULL) { memset(kopia, 0, sizeof(*kopia)); return; }
+    StanGlobalny *st = &g_shm->stan;
+
+    for (int proba = 0;; proba++) {
+        unsigned long long s1 = __atomic_load_n(&st->seq, __ATOMIC_ACQUIRE);
+        if (!(s1 & 1u)) {
+            memcpy(kopia, st, sizeof(*kopia));
+            __atomic_thread_fence(__ATOMIC_ACQUIRE);
+            if (__atomic_load_n(&st->seq, __ATOMIC_RELAXED) == s1) return;
+        }
+        stan_czekaj_na_pisarza(s1, proba);
+    }
+}
+
 /* ============================================
  * FUNKCJE POMOCNICZE DLA KARNETÓW - O(1) dostęp
  * ID karnetu = index + 1 (nigdy nie usuwamy karnetów)
+ * Karnet jest widoczny dla czytelników dopiero po publikacji liczba_karnetow.
  * ============================================ */
 
+static int id_karnetu_poprawne(int id_karnetu) {
+    return id_karnetu > 0 && id_karnetu <= __atomic_load_n(&g_shm->liczba_karnetow, __ATOMIC_ACQUIRE);
+}
+
 int utworz_karnet(TypKarnetu typ, int cena_gr, int vip) {
     MUTEX_SHM_LOCK();
     
-    if (g_shm->liczba_karnetow >= MAX_KARNETOW) {
+    int idx = g_shm->liczba_karnetow;
+    int nr_chunka = idx >> KARNETY_CHUNK_BITY;
+
+    /* Brak miejsca: dołóż chunk (rzadko - raz na KARNETY_W_CHUNKU karnetów) */
+    if (nr_chunka >= g_shm->chunki_karnetow) {
+        if (nr_chunka >= KARNETY_MAX_CHUNKOW || utworz_chunk_karnetow(nr_chunka) != 0) {
+            MUTEX_SHM_UNLOCK();
+            return -1;
+        }
+        loguj("Magazyn karnetów: nowy chunk %d (pojemność %d)",
+              nr_chunka, (nr_chunka + 1) * KARNETY_W_CHUNKU);
+    }
+
+    Karnet *k = karnet_po_indeksie(idx);
+    if (k == NULL) {
         MUTEX_SHM_UNLOCK();
         return -1;  /* Bez logowania w hot-path */
     }
-    
-    int idx = g_shm->liczba_karnetow++;
     int id = idx + 1;  /* ID = index + 1 (O(1) dostęp) */
     
-    Karnet *k = &g_shm->karnety[idx];
     k->id = id;
     k->typ = typ;
     k->czas_waznosci_sek = pobierz_waznosc_karnetu(typ);
-    k->czas_aktywacji = 0;
+    k->aktywacja_ns = 0;
     k->cena_gr = cena_gr;
     k->uzyty = 0;
     k->vip = vip;
     k->aktywny = 1;
-    
-    /* Aktualizuj statystyki */
-    g_shm->stats.sprzedane_karnety[typ - 1]++;
-    g_shm->stats.przychod_gr += cena_gr;
+
+    /* Publikacja: czytelnik, który zobaczy nowe liczba_karnetow, widzi też karnet */
+    __atomic_store_n(&g_shm->liczba_karnetow, idx + 1, __ATOMIC_RELEASE);
     
     MUTEX_SHM_UNLOCK();
     
+    /* Aktualizuj statystyki (shard sprzedającego, bez mutexa) */
+    STAT_INC(sprzedane_karnety[typ - 1]);
+    STAT_DODAJ(przychod_gr, cena_gr);
+    
     return id;
 }
 
 /* O(1) dostęp - idx = id - 1, BEZ mutexa (tylko odczyt) */
 Karnet* pobierz_karnet(int id_karnetu) {
-    if (id_karnetu <= 0 || id_karnetu > g_shm->liczba_karnetow) return NULL;
-    return &g_shm->karnety[id_karnetu - 1];
+    if (!id_karnetu_poprawne(id_karnetu)) return NULL;
+    return karnet_po_indeksie(id_karnetu - 1);
 }
 
 /* O(1) dostęp - mutex tylko przy zapisie */
 void aktywuj_karnet(int id_karnetu) {
-    if (id_karnetu <= 0 || id_karnetu > g_shm->liczba_karnetow) return;
+    if (!id_karnetu_poprawne(id_karnetu)) return;
     
-    int idx = id_karnetu - 1;
-    Karnet *k = &g_shm->karnety[idx];
+    Karnet *k = karnet_po_indeksie(id_karnetu - 1);
+    if (k == NULL) return;
     
     /* Sprawdź bez mutexa czy już aktywowany */
-    if (k->czas_aktywacji != 0) return;
+    if (k->aktywacja_ns != 0) return;
     
     MUTEX_SHM_LOCK();
     
     /* Double-check po wzięciu mutexa */
-    if (k->czas_aktywacji == 0) {
-        time_t teraz = time(NULL);
-        k->czas_aktywacji = teraz;
+    if (k->aktywacja_ns == 0) {
+        long long teraz = czas_mono_ns();
+        k->aktywacja_ns = teraz;
         
-        /* UCINANIE DO KOŃCA DNIA */
-        if (g_shm->czas_konca_dnia > 0 && k->typ != KARNET_JEDNORAZOWY) {
-            int pozostalo = (int)(g_shm->czas_konca_dnia - teraz);
+        /* UCINANIE DO KOŃCA DNIA (w dół do pełnej sekundy) */
+        if (STAN(koniec_dnia_ns) > 0 && k->typ != KARNET_JEDNORAZOWY) {
+            int pozostalo = (int)((STAN(koniec_dnia_ns) - teraz) / NS_NA_SEK);
             if (pozostalo < 0) pozostalo = 0;
             
             if (pozostalo < k->czas_waznosci_sek) {
@@ -803,8 +1338,9 @@ void aktywuj_karnet(int id_karnetu) {
 
 /* O(1) dostęp */
 void uzyj_karnet_jednorazowy(int id_karnetu) {
-    if (id_karnetu <= 0 || id_karnetu > g_shm->liczba_karnetow) return;
-    g_shm->karnety[id_karnetu - 1].uzyty = 1;  /* Atomic write, bez mutexa */
+    if (!id_karnetu_poprawne(id_karnetu)) return;
+    Karnet *k = karnet_po_indeksie(id_karnetu - 1);
+    if (k != NULL) k->uzyty = 1;  /* Atomic write, bez mutexa */
 }
 
 /* ============================================
@@ -812,17 +1348,36 @@ void uzyj_karnet_jednorazowy(int id_karnetu) {
  * ============================================ */
 
 void dodaj_log(int id_karnetu, TypLogu typ, int numer_bramki) {
-    /* Atomowe indeksowanie - BEZ mutexa (unika thundering herd) */
-    int idx = __sync_fetch_and_add(&g_shm->liczba_logow, 1);
-    
-    if (idx < MAX_LOGOW) {
-        LogEntry *log = &g_shm->logi[idx];
-        log->id_karnetu = id_karnetu;
-        log->typ_bramki = typ;
-        log->numer_bramki = numer_bramki;
-        log->czas = time(NULL);
-    }
-    /* Jeśli idx >= MAX_LOGOW, log jest "zgubiony" - to OK przy przepełnieniu */
+    LogEntry log;
+    log.id_karnetu = id_karnetu;
+    log.typ_bramki = (unsigned char)typ;
+    log.numer_bramki = (unsigned char)numer_bramki;
+    log.zarezerwowane = 0;
+    log.czas_ns = czas_mono_ns();
+
+    if (g_logi == NULL) return;
+
+    /* Pierścień MPMC - BEZ mutexa (jeden CAS na kursorze zapisu) */
+    if (pierscien_wloz(g_logi, 1, &log, sizeof(log)) == 0) return;
+
+    /* Pełny: main nie nadąża z drenażem - krótko poczekaj (backpressure),
+     * dopiero potem porzuć wpis. Oba zdarzenia liczone dla monitora / raportu. */
+    __atomic_fetch_add(&g_shm->logi_opoznione, 1, __ATOMIC_RELAXED);
+    for (int ms = 0; ms < LOGI_CZEKANIE_MS; ms++) {
+        poll(NULL, 0, 1);
+        if (pierscien_wloz(g_logi, 1, &log, sizeof(log)) == 0) return;
+    }
+    __atomic_fetch_add(&g_shm->logi_zgubione, 1, __ATOMIC_RELAXED);
+}
+
+int pobierz_log(LogEntry *log) {
+    long mtype;
+    if (g_logi == NULL) return -1;
+    return (pierscien_wyjmij(g_logi, &mtype, log, sizeof(*log)) == (int)sizeof(*log)) ? 0 : -1;
+}
+
+unsigned long logi_oczekujace(void) {
+    return (g_logi != NULL) ? pierscien_liczba(g_logi) : 0;
 }
 
 /* ============================================
@@ -855,3 +1410,43 @@ void odblokuj_czekajacych(void) {
         sem_signal_n(SEM_BARIERA_AWARIA, ile);
     }
 }
+
+/* ============================================
+ * LINIE WYCIĄGU
+ * ============================================ */
+
+int linia_najkrotsza(void) {
+    static unsigned int rotacja = 0;
+    int linie = g_shm->wyciag.linie;
+    if (linie <= 1) return 1;
+
+    int start = (int)(rotacja++ % (unsigned int)linie);
+    int najlepsza = start;
+    int najkrotsza = linia_peron_zajety(start + 1);
+    for (int k = 1; k < linie; k++) {
+        int i = (start + k) % linie;
+        int dl = linia_peron_zajety(i + 1);
+        if (dl < najkrotsza) {
+            najkrotsza = dl;
+            najlepsza = i;
+        }
+    }
+    return najlepsza + 1;
+}
+
+int linia_peron_zajety(int linia) {
+    /* Sloty trzymane z SEM_UNDO: klient, który zginął, oddaje je sam */
+    int wolne = sem_getval_ipc(SEM_PERON_LINII(linia));
+    if (wolne < 0) return 0;
+    return g_shm->wyciag.peron_sloty - wolne;
+}
+
+int peron_wolne_sloty(void) {
+    int suma = 0;
+    for (int l = 1; l <= g_shm->wyciag.linie; l++) {
+        int v = sem_getval_ipc(SEM_PERON_LINII(l));
+        if (v < 0) return -1;
+        suma += v;
+    }
+    return suma;
+}
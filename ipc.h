@@ -32,6 +32,7 @@ extern int g_mq_wyciag_req;     // kolejka peron->wyciąg
 extern int g_mq_wyciag_odp;     // odpowiedzi wyciągu
 extern int g_mq_peron;          // kolejka klient->pracownik1 (peron)
 extern int g_mq_peron_odp;      // kolejka odpowiedzi peron
+extern int g_skrzynka;          // skrzynka odpowiedzi tego procesu (-1 = brak, kolejki SysV)
 
 /* ============================================
  * OCHRONA PROCESÓW POTOMNYCH
@@ -53,13 +54,29 @@ int czy_rodzic_zyje(void);
  * INICJALIZACJA I CLEANUP (tylko main)
  * ============================================ */
 
+/*
+ * Liczy geometrię segmentu SHM z parametrów uruchomienia
+ * limit_klientow - limit_utworzonych (0 = bez limitu -> MAX_LOGOW, 1 chunk karnetów na start)
+ * zapas_proc - zapas ponad oczekiwane zużycie (%)
+ * pojemnosc_zdarzen - rekordów pierścienia dziennika (0 = bez dziennika, inaczej potęga 2)
+ */
+void geometria_shm_oblicz(GeometriaShm *geo, int limit_klientow, int zapas_proc, int pojemnosc_zdarzen);
+
+/*
+ * Geometria wyciągu z config.h (LICZBA_RZEDOW, KRZESLA_W_RZEDZIE, ...)
+ */
+void geometria_wyciagu_domyslna(GeometriaWyciagu *w);
+
 /*
  * Tworzy wszystkie zasoby IPC
  * Wywołać TYLKO w procesie main!
  * N - limit osób na terenie (wartość początkowa semafora SEM_TEREN)
+ * transport - TRANSPORT_SYSV / TRANSPORT_SHM (kolejki gorącej ścieżki)
+ * geo - geometria segmentu SHM (geometria_shm_oblicz)
+ * wyciag - geometria ringu i liczba linii (start SEM_PERON_LINII = wyciag->peron_sloty)
  * Zwraca: 0=OK, -1=błąd
  */
-int init_ipc(int N);
+int init_ipc(int N, int transport, const GeometriaShm *geo, const GeometriaWyciagu *wyciag);
 
 /*
  * Usuwa wszystkie zasoby IPC
@@ -96,7 +113,7 @@ void detach_ipc(void);
 
 /*
  * Mutex z SEM_UNDO - automatyczne odkręcenie przy śmierci procesu
- * Używaj dla SEM_MUTEX_SHM i SEM_MUTEX_LOG
+ * Używaj dla SEM_MUTEX_LOG / SEM_MUTEX_KASA (SHM ma własny mutex, patrz niżej)
  */
 int mutex_lock(int sem_num);
 void mutex_unlock(int sem_num);
@@ -158,6 +175,12 @@ int sem_getval_ipc(int sem_num);
  * OPERACJE NA KOLEJKACH KOMUNIKATÓW
  * ============================================ */
 
+/*
+ * Kolejki kasa/bramka/peron/wyciag_req mogą być pierścieniami SHM
+ * (TRANSPORT_SHM, patrz kolejki_shm.h) - funkcje poniżej same wybierają
+ * transport po mq_id, więc wywołujący nie muszą nic zmieniać.
+ */
+
 /*
  * Wysyła komunikat do kolejki
  * Blokuje jeśli kolejka pełna
@@ -182,16 +205,124 @@ int msg_recv(int mq_id, void *msg, size_t size, long mtype);
  */
 int msg_recv_nowait(int mq_id, void *msg, size_t size, long mtype);
 
+/*
+ * Liczba komunikatów czekających w kolejce (monitor, próbkowanie)
+ * Zwraca: >=0 liczba, -1=brak kolejki / błąd
+ */
+long msg_liczba(int mq_id);
+
+/* ============================================
+ * ODPOWIEDZI DO KLIENTÓW (skrzynki / kolejki *_odp)
+ * ============================================ */
+
+/*
+ * Zajmuje skrzynkę odpowiedzi dla bieżącego procesu (TRANSPORT_SHM)
+ * Wynik trafia do g_skrzynka; zwalnia ją detach_ipc().
+ * Zwraca: indeks skrzynki lub -1 (zostajemy przy kolejkach SysV)
+ */
+int zajmij_skrzynke(void);
+
+/*
+ * Wysyła odpowiedź do klienta
+ * skrzynka >= 0: zapis do skrzynki klienta (mtype komunikatu = pid klienta)
+ * skrzynka < 0:  msgsnd na mq_id (jak msg_send / msg_send_nowait)
+ * czekaj=1: pełna skrzynka / kolejka = czekanie (skrzynka: backoff do
+ * ODP_BACKOFF_MAX_MS, aż klient odbierze lub wyjdzie); czekaj=0: -1/EAGAIN.
+ * Odpowiedź do klienta, który już wyszedł, jest po cichu pomijana (zwraca 0).
+ * Zwraca: 0=OK, -1=pełna/przerwane, -2=IPC usunięte
+ */
+int msg_send_odp(int mq_id, int skrzynka, void *msg, size_t size, int czekaj);
+
+/*
+ * Wysyła paczkę n odpowiedzi bez czekania (msgs: n komunikatów po size bajtów,
+ * skrzynki[i] = skrzynka adresata msgs[i]). Jedno przejście po paczce:
+ * dostarczone i te bez adresata wypadają, te bez miejsca (pełna skrzynka /
+ * kolejka) zostają zsunięte na początek tablic - do ponowienia.
+ * To nadal jeden msg_send_odp na odpowiedź (każda idzie do innej skrzynki /
+ * msgsnd), paczka oszczędza tylko ponawianie i backoff po stronie nadawcy.
+ * Zwraca: >=0 liczba niedostarczonych, -2=IPC usunięte
+ */
+int msg_send_odp_paczka(int mq_id, int skrzynki[], void *msgs, size_t size, int n);
+
+/*
+ * Odbiera odpowiedź z własnej skrzynki (g_skrzynka) albo z kolejki mq_id po mtype
+ * Zwraca: >=0 rozmiar, -1=brak/przerwane, -2=IPC usunięte
+ */
+int msg_recv_odp(int mq_id, void *msg, size_t size, long mtype, int czekaj);
+
+/*
+ * Czeka na odpowiedź max timeout_ms albo do zmiany stanu globalnego
+ * (każdy stan_zapis_koniec budzi czekających).
+ * epoka: wartość z epoka_stanu() sprzed ostatniego sprawdzenia stanu, aktualizowana przy zmianie
+ * Ze skrzynką śpi na futexie (zero CPU); na SysV to msgrcv NOWAIT + poll(ODP_POLL_MS).
+ * Zwraca: >=0 rozmiar, -1 (errno: EAGAIN=zmiana stanu, ETIMEDOUT, EINTR), -2=IPC usunięte
+ */
+int msg_czekaj_odp(int mq_id, void *msg, size_t size, long mtype,
+                   unsigned int *epoka, int timeout_ms);
+
+/*
+ * Epoka stanu globalnego (zmienia ją stan_zapis_koniec; 0 na SysV)
+ */
+unsigned int epoka_stanu(void);
+
+/* ============================================
+ * STAN GLOBALNY (seqlock w g_shm->stan)
+ * ============================================ */
+
+/*
+ * Odczyt jednego pola bez blokady (np. STAN(faza_dnia), STAN(pid_bramki1[i]))
+ * Pojedyncze pole jest zawsze spójne; kilka pól naraz -> stan_odczytaj().
+ */
+#define STAN(pole)          __atomic_load_n(&g_shm->stan.pole, __ATOMIC_ACQUIRE)
+
+/*
+ * Zapis pola - tylko między stan_zapis_poczatek() a stan_zapis_koniec()
+ */
+#define STAN_USTAW(pole, v) __atomic_store_n(&g_shm->stan.pole, (v), __ATOMIC_RELAXED)
+
+/*
+ * Otwiera sekcję zapisu (wyklucza innych piszących, czytelnicy ponawiają)
+ * Sekcja ma być krótka: bez blokujących wywołań, bez MUTEX_SHM_LOCK w środku
+ * (kolejność blokad: mutex SHM -> stan).
+ */
+void stan_zapis_poczatek(void);
+
+/*
+ * Wersja dla handlerów sygnałów: nie czeka, gdy sekcja jest zajęta
+ * Zwraca: 0=sekcja otwarta, -1=zajęta (pomiń zapis)
+ */
+int stan_zapis_sprobuj(void);
+
+/*
+ * Zamyka sekcję zapisu i budzi czekających w msg_czekaj_odp
+ * (bezpieczne w handlerze sygnału, zachowuje errno)
+ */
+void stan_zapis_koniec(void);
+
+/*
+ * Spójna kopia całego stanu (bez blokad, ponawia przy równoległym zapisie)
+ */
+void stan_odczytaj(StanGlobalny *kopia);
+
 /* ============================================
  * BEZPIECZNY DOSTĘP DO PAMIĘCI WSPÓŁDZIELONEJ
  * ============================================ */
 
+/*
+ * Mutex SHM: pthread_mutex w SharedMemory (PROCESS_SHARED + ROBUST)
+ * - bez rywalizacji: samo CAS w przestrzeni użytkownika (zero syscalli)
+ * - śmierć właściciela: następny lock dostaje EOWNERDEAD i przejmuje
+ *   mutex (odpowiednik SEM_UNDO z poprzedniej wersji na semaforze)
+ * Zwraca: 0=OK, -2=brak SHM / mutex nie do odzyskania
+ */
+int shm_mutex_lock(void);
+void shm_mutex_unlock(void);
+
 /*
  * Blokuje mutex SHM, wykonuje operację, odblokowuje
- * Używa SEM_UNDO - automatyczne odkręcenie przy śmierci procesu
  */
-#define MUTEX_SHM_LOCK()   mutex_lock(SEM_MUTEX_SHM)
-#define MUTEX_SHM_UNLOCK() mutex_unlock(SEM_MUTEX_SHM)
+#define MUTEX_SHM_LOCK()   shm_mutex_lock()
+#define MUTEX_SHM_UNLOCK() shm_mutex_unlock()
 
 /*
  * Bezpieczny odczyt zmiennej z shm
@@ -235,19 +366,19 @@ int msg_recv_nowait(int mq_id, void *msg, size_t size, long mtype);
  * ============================================ */
 
 /*
- * Tworzy nowy karnet w pamięci współdzielonej
+ * Tworzy nowy karnet w pamięci współdzielonej (dokłada chunk, gdy brak miejsca)
  * Zwraca: ID karnetu lub -1 przy błędzie
  */
 int utworz_karnet(TypKarnetu typ, int cena_gr, int vip);
 
 /*
- * Pobiera wskaźnik do karnetu (bezpieczne)
+ * Pobiera wskaźnik do karnetu (bezpieczne, O(1); podpina chunk przy pierwszym użyciu)
  * Zwraca: wskaźnik lub NULL
  */
 Karnet* pobierz_karnet(int id_karnetu);
 
 /*
- * Aktywuje karnet (ustawia czas_aktywacji)
+ * Aktywuje karnet (ustawia aktywacja_ns)
  */
 void aktywuj_karnet(int id_karnetu);
 
@@ -261,10 +392,22 @@ void uzyj_karnet_jednorazowy(int id_karnetu);
  * ============================================ */
 
 /*
- * Dodaje wpis do logu przejść
+ * Dodaje wpis do logu przejść (pierścień w SHM)
+ * Pełny pierścień: czeka do LOGI_CZEKANIE_MS (logi_opoznione), potem porzuca (logi_zgubione)
  */
 void dodaj_log(int id_karnetu, TypLogu typ, int numer_bramki);
 
+/*
+ * Wyjmuje najstarszy wpis logu przejść (drenaż w main)
+ * Zwraca: 0=OK, -1=pusty
+ */
+int pobierz_log(LogEntry *log);
+
+/*
+ * Przybliżona liczba wpisów czekających na drenaż (do monitora)
+ */
+unsigned long logi_oczekujace(void);
+
 /* ============================================
  * OBSŁUGA AWARII
  * ============================================ */
@@ -282,4 +425,26 @@ void czekaj_na_wznowienie(const char *kto);
  */
 void odblokuj_czekajacych(void);
 
+/* ============================================
+ * LINIE WYCIĄGU
+ * ============================================ */
+
+/*
+ * Linia (1..g_shm->wyciag.linie) z najkrótszą kolejką (najmniej zajętym peronem)
+ * Remis rozstrzyga rotacja, żeby przy pustych kolejkach nie zapychać linii 1.
+ */
+int linia_najkrotsza(void);
+
+/*
+ * Zajęte sloty peronu linii: peron_sloty - wartość SEM_PERON_LINII(linia)
+ * Bez osobnego licznika - SEM_UNDO oddaje sloty klienta, który odszedł
+ * dowolną ścieżką (także zabity), więc wartość nie dryfuje.
+ */
+int linia_peron_zajety(int linia);
+
+/*
+ * Suma wolnych slotów peronów wszystkich linii (monitor / próbki)
+ */
+int peron_wolne_sloty(void);
+
 #endif /* IPC_H */
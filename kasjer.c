@@ -9,6 +9,8 @@
 #include "types.h"
 #include "ipc.h"
 #include "utils.h"
+#include "statystyki.h"
+#include "zdarzenia.h"
 
 /*
  * KOLEJ KRZESEŁKOWA - PROCES KASJERA
@@ -53,7 +55,7 @@ int main(int argc, char *argv[]) {
     ustaw_smierc_z_rodzicem();
     
     /* Inicjalizacja */
-    inicjalizuj_losowanie();
+    inicjalizuj_losowanie(LOS_SOL_KASJER);
     
     /* Obsługa sygnałów - sigaction BEZ SA_RESTART żeby SIGTERM przerwał msg_recv */
     struct sigaction sa;
@@ -69,6 +71,7 @@ int main(int argc, char *argv[]) {
         loguj("KASJER: Błąd dołączania do IPC");
         return EXIT_FAILURE;
     }
+    statystyki_shard_roli(STAT_ROLA_KASJER);
     
     {
         char desc[128];
@@ -90,20 +93,18 @@ int main(int argc, char *argv[]) {
         }
         
         /* Sprawdź fazę dnia - w CLOSING/DRAINING odmawiaj nowym klientom */
-        if (g_shm->faza_dnia != FAZA_OPEN) {
+        if (STAN(faza_dnia) != FAZA_OPEN) {
             /* Odmów i kontynuuj (wyczyść kolejkę) */
             odp.mtype = msg.pid_klienta;
             odp.sukces = 0;
             odp.id_karnetu = -1;
-            msg_send(g_mq_kasa_odp, &odp, sizeof(odp));  /* BLOKUJĄCE - gwarantuje dostarczenie */
+            msg_send_odp(g_mq_kasa_odp, msg.skrzynka, &odp, sizeof(odp), 1);  /* BLOKUJĄCE - gwarantuje dostarczenie */
             continue;
         }
 
         /* Log wejścia klienta do kasy */
-        loguj("KASJER: klient id=%d pid=%d wiek=%d typ=%s vip=%d dzieci=%d (%d,%d)",
-              msg.id_klienta, (int)msg.pid_klienta, msg.wiek,
-              (msg.typ == TYP_ROWERZYSTA) ? "ROWER" : "PIESZY",
-              msg.vip, msg.liczba_dzieci, msg.wiek_dzieci[0], msg.wiek_dzieci[1]);
+        LOG_ZDARZENIE(ZD_KASJER_KLIENT, msg.id_klienta, (int)msg.pid_klienta, msg.wiek, msg.typ,
+                      msg.vip, msg.liczba_dzieci, msg.wiek_dzieci[0], msg.wiek_dzieci[1]);
         
         /* Domyślna odpowiedź */
         odp.mtype = msg.pid_klienta;
@@ -114,8 +115,8 @@ int main(int argc, char *argv[]) {
         
         /* Sprawdź czy dziecko <8 bez opiekuna */
         if (msg.wiek < WIEK_WYMAGA_OPIEKI && msg.liczba_dzieci == 0) {
-            SHM_INC(stats.liczba_dzieci_odrzuconych);
-            msg_send(g_mq_kasa_odp, &odp, sizeof(odp));
+            STAT_INC(liczba_dzieci_odrzuconych);
+            msg_send_odp(g_mq_kasa_odp, msg.skrzynka, &odp, sizeof(odp), 1);
             continue;
         }
         
@@ -129,28 +130,18 @@ int main(int argc, char *argv[]) {
         /* Utwórz karnet */
         int id = utworz_karnet(typ, cena, msg.vip);
         if (id < 0) {
-            msg_send(g_mq_kasa_odp, &odp, sizeof(odp));
+            msg_send_odp(g_mq_kasa_odp, msg.skrzynka, &odp, sizeof(odp), 1);
             continue;
         }
 
-        {
-            char kwota[32];
-            formatuj_kwote(cena, kwota);
-            loguj("KASJER: SPRZEDAŻ id_klienta=%d pid=%d -> karnet=%d typ=%s cena=%s vip=%d",
-                  msg.id_klienta, (int)msg.pid_klienta, id, nazwa_karnetu(typ), kwota, msg.vip);
-        }
+        LOG_ZDARZENIE(ZD_KASJER_SPRZEDAZ, msg.id_klienta, (int)msg.pid_klienta, id, typ, cena, msg.vip);
         
         odp.sukces = 1;
         odp.id_karnetu = id;
         odp.typ_karnetu = typ;
 
-        /* Log sprzedaży */
-        {
-            char kwota[32];
-            formatuj_kwote(cena, kwota);
-            loguj("KASJER: sprzedano karnet id_karnetu=%d typ=%s cena=%s dla klienta id=%d (pid=%d)",
-                  id, nazwa_karnetu(typ), kwota, msg.id_klienta, (int)msg.pid_klienta);
-        }
+        /* Log sprzedaży (kwotę formatuje dziennik / zdarzenie_zapisz) */
+        LOG_ZDARZENIE(ZD_KASJER_SPRZEDANO, id, typ, cena, msg.id_klienta, (int)msg.pid_klienta);
         
         /* Karnety dla dzieci */
         for (int i = 0; i < msg.liczba_dzieci; i++) {
@@ -160,23 +151,21 @@ int main(int argc, char *argv[]) {
         }
         
         /* Aktualizuj statystyki */
-        MUTEX_SHM_LOCK();
-        g_shm->stats.laczna_liczba_klientow++;
+        STAT_INC(laczna_liczba_klientow);
         if (msg.typ == TYP_PIESZY) {
-            g_shm->stats.liczba_pieszych++;
+            STAT_INC(liczba_pieszych);
         } else {
-            g_shm->stats.liczba_rowerzystow++;
+            STAT_INC(liczba_rowerzystow);
         }
         if (msg.vip) {
-            g_shm->stats.liczba_vip++;
+            STAT_INC(liczba_vip);
         }
         if (msg.liczba_dzieci > 0) {
-            g_shm->stats.liczba_grup_rodzinnych++;
+            STAT_INC(liczba_grup_rodzinnych);
         }
-        MUTEX_SHM_UNLOCK();
         
         /* Wyślij odpowiedź */
-        msg_send(g_mq_kasa_odp, &odp, sizeof(odp));
+        msg_send_odp(g_mq_kasa_odp, msg.skrzynka, &odp, sizeof(odp), 1);
     }
     
     loguj("KASJER: Kończę pracę");
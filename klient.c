@@ -11,6 +11,11 @@
 #include "types.h"
 #include "ipc.h"
 #include "utils.h"
+#include "czas.h"
+#include "obecnosc.h"
+#include "statystyki.h"
+#include "zdarzenia.h"
+#include "histogram.h"
 
 /*
  * KOLEJ KRZESEŁKOWA - PROCES KLIENTA (v3.0 UPROSZCZONY)
@@ -28,6 +33,8 @@
 static volatile sig_atomic_t g_koniec = 0;
 static Klient g_klient;
 static int g_waga_peronu = 0;  /* ile slotów peronu zajmujemy */
+static int g_linia = 1;        /* linia wyciągu przydzielona przez pracownika1 */
+static int g_klasa = KLASA_PIESZY;  /* histogram_klasa() - do pomiarów etapów */
 
 /* ============================================
  * DZIECI JAKO WĄTKI (pthread) – "realne" dzieci zawsze z opiekunem
@@ -62,7 +69,7 @@ static pthread_t g_tid_dzieci[2];
 static void loguj_dzieci_etap(const char *etap_txt) {
     if (g_dzieci.liczba_watkow <= 0) return;
     for (int i = 0; i < g_dzieci.liczba_watkow; i++) {
-        loguj("DZIECKO %d: razem z opiekunem -> %s", i + 1, etap_txt);
+        LOG_DEBUG("DZIECKO %d: razem z opiekunem -> %s", i + 1, etap_txt);
     }
 }
 
@@ -169,11 +176,6 @@ static void dzieci_stop_join(void) {
     g_dzieci.liczba_watkow = 0;
 }
 
-
-static const char* nazwa_typu_klienta(int typ) {
-    return (typ == TYP_ROWERZYSTA) ? "ROWER" : "PIESZY";
-}
-
 typedef enum {
     STAN_KASA,
     STAN_PRZED_BRAMKA1,
@@ -221,7 +223,7 @@ static int wyslij_z_backoff(int mq_id, void *msg, size_t size, int allow_in_clos
          *   żeby osoby już na terenie dokończyły przejazd.
          */
         if (!allow_in_closing && g_shm != NULL) {
-            if (g_shm->koniec_dnia || g_shm->faza_dnia != FAZA_OPEN) {
+            if (STAN(koniec_dnia) || STAN(faza_dnia) != FAZA_OPEN) {
                 return -1;
             }
         }
@@ -255,25 +257,19 @@ static void bezpieczne_zakonczenie(void) {
         case STAN_NA_TERENIE:
             /* Na terenie - zwolnij SEM_TEREN */
             sem_signal_n(SEM_TEREN, g_klient.rozmiar_grupy);
-            MUTEX_SHM_LOCK();
-            g_shm->osoby_na_terenie -= g_klient.rozmiar_grupy;
-            MUTEX_SHM_UNLOCK();
+            obecnosc_przenies(STREFA_TEREN, STREFA_POZA, g_klient.rozmiar_grupy);
             break;
             
         case STAN_NA_PERONIE:
-            /* Na peronie - zwolnij SEM_PERON i SEM_TEREN */
+            /* Na peronie - zwolnij SEM_PERON linii i SEM_TEREN */
             if (g_waga_peronu > 0) {
-                sem_signal_n_undo(SEM_PERON, g_waga_peronu);
+                sem_signal_n_undo(SEM_PERON_LINII(g_linia), g_waga_peronu);
                 g_waga_peronu = 0;
             }
-            MUTEX_SHM_LOCK();
-            g_shm->osoby_na_peronie -= g_klient.rozmiar_grupy;
-            MUTEX_SHM_UNLOCK();
+            obecnosc_przenies(STREFA_PERON, STREFA_POZA, g_klient.rozmiar_grupy);
             if (g_wpuszczony_na_teren) {
                 sem_signal_n(SEM_TEREN, g_klient.rozmiar_grupy);
-                MUTEX_SHM_LOCK();
-                g_shm->osoby_na_terenie -= g_klient.rozmiar_grupy;
-                MUTEX_SHM_UNLOCK();
+                obecnosc_przenies(STREFA_TEREN, STREFA_POZA, g_klient.rozmiar_grupy);
             }
             break;
             
@@ -313,8 +309,9 @@ int main(int argc, char *argv[]) {
     if (argc >= 8) g_klient.wiek_dzieci[1] = atoi(argv[7]);
     
     g_klient.rozmiar_grupy = oblicz_miejsca_krzeselko(g_klient.typ, g_klient.liczba_dzieci);
+    g_klasa = histogram_klasa(g_klient.typ, g_klient.vip);
     
-    inicjalizuj_losowanie();
+    inicjalizuj_losowanie(g_klient.id);
     
     /* Obsługa sygnałów - sigaction BEZ SA_RESTART */
     struct sigaction sa;
@@ -329,10 +326,14 @@ int main(int argc, char *argv[]) {
         return EXIT_FAILURE;
     }
 
-    loguj("KLIENT %d: start pid=%d wiek=%d typ=%s vip=%d dzieci=%d (%d,%d) rozmiar_grupy=%d",
-          g_klient.id, (int)g_klient.pid, g_klient.wiek, nazwa_typu_klienta(g_klient.typ),
-          g_klient.vip, g_klient.liczba_dzieci, g_klient.wiek_dzieci[0], g_klient.wiek_dzieci[1],
-          g_klient.rozmiar_grupy);
+    /* Własna skrzynka odpowiedzi (TRANSPORT_SHM); bez niej -> kolejki SysV z mtype=pid */
+    zajmij_skrzynke();
+    statystyki_shard_klienta(g_klient.id);
+
+    LOG_ZDARZENIE(ZD_KLIENT_START,
+                  g_klient.id, (int)g_klient.pid, g_klient.wiek, g_klient.typ,
+                  g_klient.vip, g_klient.liczba_dzieci, g_klient.wiek_dzieci[0], g_klient.wiek_dzieci[1],
+                  g_klient.rozmiar_grupy);
     
     /* WAŻNE: Zarejestruj cleanup PRZED inkrementacją licznika */
     atexit(bezpieczne_zakonczenie);
@@ -348,7 +349,7 @@ int main(int argc, char *argv[]) {
     g_stan = STAN_KASA;
     
     /* CHECK #1: Przed kasą - czy stacja przyjmuje nowych? */
-    if (g_shm->faza_dnia != FAZA_OPEN) {
+    if (STAN(faza_dnia) != FAZA_OPEN) {
         return EXIT_SUCCESS;  /* atexit() wywoła bezpieczne_zakonczenie() */
     }
 
@@ -357,8 +358,7 @@ int main(int argc, char *argv[]) {
     if (PROC_NIE_KORZYSTA > 0) {
         int r = rand() % 100;
         if (r < PROC_NIE_KORZYSTA) {
-            loguj("KLIENT %d: odchodzi - dziś nie korzysta z kolei (los=%d < %d%%)",
-                  g_klient.id, r, PROC_NIE_KORZYSTA);
+            LOG_ZDARZENIE(ZD_KLIENT_NIE_KORZYSTA, g_klient.id, r, PROC_NIE_KORZYSTA);
             dzieci_set_etap(DZ_ETAP_KONIEC, "ODCHODZI");
             return EXIT_SUCCESS;
         }
@@ -374,31 +374,32 @@ int main(int argc, char *argv[]) {
     msg_kasa.liczba_dzieci = g_klient.liczba_dzieci;
     msg_kasa.wiek_dzieci[0] = g_klient.wiek_dzieci[0];
     msg_kasa.wiek_dzieci[1] = g_klient.wiek_dzieci[1];
+    msg_kasa.skrzynka = g_skrzynka;
     
     /* Nie blokuj się na zapchanej kolejce - backoff + szybkie wyjście w CLOSING */
+    long long t_etapu = czas_mono_ns();
     if (wyslij_z_backoff(g_mq_kasa, &msg_kasa, sizeof(msg_kasa), 0) < 0) {
         return EXIT_SUCCESS;  /* atexit() zrobi cleanup */
     }
     
     /* Czekaj na odpowiedź BLOKUJĄCO (kasjer ZAWSZE odpowiada) */
     MsgKasaOdp odp_kasa;
-    int ret = msg_recv(g_mq_kasa_odp, &odp_kasa, sizeof(odp_kasa), g_klient.pid);
+    int ret = msg_recv_odp(g_mq_kasa_odp, &odp_kasa, sizeof(odp_kasa), g_klient.pid, 1);
     
     if (ret < 0 || !odp_kasa.sukces) {
         return EXIT_SUCCESS;  /* atexit() zrobi cleanup */
     }
     
     g_klient.id_karnetu = odp_kasa.id_karnetu;
+    histogram_zapisz(ETAP_KASA, g_klasa, czas_mono_ns() - t_etapu);
 
     {
         Karnet *k = pobierz_karnet(g_klient.id_karnetu);
         if (k != NULL) {
-            loguj("KLIENT %d: kupił karnet id_karnetu=%d typ=%s czas_waznosci=%ds vip=%d",
-                  g_klient.id, g_klient.id_karnetu, nazwa_karnetu(k->typ),
-                  k->czas_waznosci_sek, k->vip);
+            LOG_ZDARZENIE(ZD_KLIENT_KARNET, g_klient.id, g_klient.id_karnetu, k->typ,
+                          k->czas_waznosci_sek, k->vip);
         } else {
-            loguj("KLIENT %d: kupił karnet id_karnetu=%d",
-                  g_klient.id, g_klient.id_karnetu);
+            LOG_ZDARZENIE(ZD_KLIENT_KARNET_KROTKO, g_klient.id, g_klient.id_karnetu);
         }
     }
     
@@ -416,7 +417,7 @@ int main(int argc, char *argv[]) {
         
         /* CHECK #2: Przed bramką - czy karnet ważny? (karnet ucięty do końca dnia) */
         Karnet *karnet = pobierz_karnet(g_klient.id_karnetu);
-        if (karnet == NULL || !czy_karnet_wazny(karnet, time(NULL))) {
+        if (karnet == NULL || !czy_karnet_wazny(karnet, czas_mono_ns())) {
             break;
         }
         
@@ -431,27 +432,30 @@ int main(int argc, char *argv[]) {
         msg_bramka.mtype = nr_bramki1;      /* routing do konkretnej bramki */
         msg_bramka.vip = g_klient.vip;
         msg_bramka.numer_bramki = nr_bramki1;
+        msg_bramka.skrzynka = g_skrzynka;
 
         dzieci_set_etap(DZ_ETAP_BRAMKA1, "BRAMKA1");
-        loguj("KLIENT %d: id_karnetu=%d -> BRAMKA1 nr=%d (vip=%d, grupa=%d)",
-              g_klient.id, g_klient.id_karnetu, nr_bramki1, g_klient.vip, g_klient.rozmiar_grupy);
+        LOG_ZDARZENIE(ZD_KLIENT_BRAMKA1,
+                      g_klient.id, g_klient.id_karnetu, nr_bramki1, g_klient.vip, g_klient.rozmiar_grupy);
         
         /* Nie blokuj się na zapchanej kolejce - backoff + szybkie wyjście w CLOSING */
+        t_etapu = czas_mono_ns();
         if (wyslij_z_backoff(g_mq_bramka, &msg_bramka, sizeof(msg_bramka), 0) < 0) break;
         
         /* Czekaj na bramkę BLOKUJĄCO - osobna kolejka odpowiedzi */
         MsgBramkaOdp odp_bramka;
-        ret = msg_recv(g_mq_bramka_odp, &odp_bramka, sizeof(odp_bramka), g_klient.pid);
+        ret = msg_recv_odp(g_mq_bramka_odp, &odp_bramka, sizeof(odp_bramka), g_klient.pid, 1);
         
         if (ret < 0 || !odp_bramka.sukces) {
-            loguj("KLIENT %d: BRAMKA1 odmówiła (nr=%d) - kończę", g_klient.id, nr_bramki1);
+            LOG_INFO("KLIENT %d: BRAMKA1 odmówiła (nr=%d) - kończę", g_klient.id, nr_bramki1);
             break;
         }
         
         g_stan = STAN_NA_TERENIE;
         g_wpuszczony_na_teren = 1;
+        histogram_zapisz(ETAP_BRAMKA1, g_klasa, czas_mono_ns() - t_etapu);
 
-        loguj("KLIENT %d: BRAMKA1 OK (nr=%d) - jestem na terenie", g_klient.id, nr_bramki1);
+        LOG_ZDARZENIE(ZD_KLIENT_BRAMKA1_OK, g_klient.id, nr_bramki1);
         
         /* ========================================
          * BRAMKA2 -> PERON -> WYCIĄG
@@ -465,27 +469,24 @@ int main(int argc, char *argv[]) {
          */
         g_waga_peronu = g_klient.rozmiar_grupy;
         
-        /* Sprawdź czy w ogóle zmieścimy się na krzesełko (max 4 sloty) */
-        if (g_waga_peronu > PERON_SLOTY) {
+        /* Sprawdź czy w ogóle zmieścimy się na peron i do jednego rzędu */
+        if (g_waga_peronu > g_shm->wyciag.peron_sloty || g_waga_peronu > g_shm->wyciag.krzesla_w_rzedzie) {
             /* Grupa za duża - nie wejdziemy (np. pieszy + 4 dzieci = 5 > 4) */
             sem_signal_n(SEM_TEREN, g_klient.rozmiar_grupy);
-            MUTEX_SHM_LOCK();
-            g_shm->osoby_na_terenie -= g_klient.rozmiar_grupy;
-            MUTEX_SHM_UNLOCK();
+            obecnosc_przenies(STREFA_TEREN, STREFA_POZA, g_klient.rozmiar_grupy);
             g_wpuszczony_na_teren = 0;
             g_waga_peronu = 0;
             break;
         }
         
         /* Czekaj na awarii jeśli aktywna */
-        if (g_shm->awaria && !g_koniec) {
+        if (STAN(awaria) && !g_koniec) {
             char buf[32];
             snprintf(buf, sizeof(buf), "KLIENT %d (przed peronem)", g_klient.id);
             czekaj_na_wznowienie(buf);
         }
 
-        loguj("KLIENT %d: czekam na peron (sloty=%d, bramka2=%d)",
-              g_klient.id, g_waga_peronu, nr_bramki2);
+        LOG_ZDARZENIE(ZD_KLIENT_CZEKA_PERON, g_klient.id, g_waga_peronu, nr_bramki2);
         
 
         /* PROSI_P1_PERON: Pracownik1 kontroluje wejście na peron (bramki2).
@@ -496,92 +497,98 @@ int main(int argc, char *argv[]) {
         msg_peron.id_karnetu = g_klient.id_karnetu;
         msg_peron.miejsca = g_waga_peronu;
         msg_peron.numer_bramki2 = nr_bramki2;
+        msg_peron.skrzynka = g_skrzynka;
 
-        loguj("KLIENT %d: prosi PRACOWNIK1 o wejście na peron (bramka2=%d sloty=%d)",
-              g_klient.id, nr_bramki2, g_waga_peronu);
+        LOG_ZDARZENIE(ZD_KLIENT_PROSI_P1, g_klient.id, nr_bramki2, g_waga_peronu);
+        t_etapu = czas_mono_ns();
 
         if (wyslij_z_backoff(g_mq_peron, &msg_peron, sizeof(msg_peron), 1) < 0) {
             break;
         }
 
         /* Czekaj na odpowiedź od pracownika1.
-         * Używamy pętli NOWAIT + poll, żeby móc szybko wyjść w CLOSING/PANIC. */
+         * msg_czekaj_odp śpi do odpowiedzi albo zmiany stanu (PANIC/CLOSING/awaria),
+         * więc szybkie wyjście nie wymaga odpytywania. Epokę bierzemy PRZED
+         * sprawdzeniem panic - zmiana po sprawdzeniu przerwie sen. */
         MsgPeronOdp odp_peron;
         int got_peron = 0;
+        unsigned int epoka = epoka_stanu();
         while (!g_koniec && !got_peron) {
-            int r = msg_recv_nowait(g_mq_peron_odp, &odp_peron, sizeof(odp_peron), (long)g_klient.pid);
+            if (STAN(panic)) {
+                goto koniec_petli;
+            }
+
+            int r = msg_czekaj_odp(g_mq_peron_odp, &odp_peron, sizeof(odp_peron),
+                                   (long)g_klient.pid, &epoka, CZEKANIE_ODP_MS);
             if (r >= 0) {
                 if (!odp_peron.sukces) {
-                    loguj("KLIENT %d: PRACOWNIK1 odmówił wejścia na peron", g_klient.id);
+                    LOG_INFO("KLIENT %d: PRACOWNIK1 odmówił wejścia na peron", g_klient.id);
                     goto koniec_petli;
                 }
                 got_peron = 1;
                 break;
             }
-
-            /* jeśli pracownik1 umarł, nie czekaj bez końca */
-            pid_t pid_p1 = 0;
-            int panic = 0;
-            MUTEX_SHM_LOCK();
-            pid_p1 = g_shm->pid_pracownik1;
-            panic = g_shm->panic;
-            MUTEX_SHM_UNLOCK();
-
-            if (panic) {
-                goto koniec_petli;
-            }
-            if (pid_p1 > 0 && kill(pid_p1, 0) < 0 && errno == ESRCH) {
-                loguj("KLIENT %d: PRACOWNIK1 nie żyje - rezygnuję", g_klient.id);
+            if (r == -2) {
                 goto koniec_petli;
             }
 
-            poll(NULL, 0, 20);
+            /* Cisza przez cały timeout - jeśli pracownik1 umarł, nie czekaj bez końca */
+            if (errno == ETIMEDOUT) {
+                pid_t pid_p1 = STAN(pid_pracownik1);
+                if (pid_p1 > 0 && kill(pid_p1, 0) < 0 && errno == ESRCH) {
+                    LOG_WARN("KLIENT %d: PRACOWNIK1 nie żyje - rezygnuję", g_klient.id);
+                    goto koniec_petli;
+                }
+            }
         }
 
         if (!got_peron) {
             goto koniec_petli;
         }
 
-        loguj("KLIENT %d: PRACOWNIK1 pozwolił wejść na peron", g_klient.id);
+        LOG_ZDARZENIE(ZD_KLIENT_P1_POZWOLIL, g_klient.id);
+
+        /* Linia z odpowiedzi (stary/błędny numer = linia 1) */
+        g_linia = odp_peron.linia;
+        if (g_linia < 1 || g_linia > g_shm->wyciag.linie) g_linia = 1;
 
-        /* Czekaj na miejsce na peronie (semafor slotów) */
-        if (sem_wait_n_undo(SEM_PERON, g_waga_peronu) != 0) {
+        /* Czekaj na miejsce na peronie linii (semafor slotów) */
+        if (sem_wait_n_undo(SEM_PERON_LINII(g_linia), g_waga_peronu) != 0) {
             /* Przerwane - muszę się ewakuować */
             sem_signal_n(SEM_TEREN, g_klient.rozmiar_grupy);
-            MUTEX_SHM_LOCK();
-            g_shm->osoby_na_terenie -= g_klient.rozmiar_grupy;
-            MUTEX_SHM_UNLOCK();
+            obecnosc_przenies(STREFA_TEREN, STREFA_POZA, g_klient.rozmiar_grupy);
             g_wpuszczony_na_teren = 0;
             g_waga_peronu = 0;
             break;
         }
         
         g_stan = STAN_NA_PERONIE;
-        loguj("KLIENT %d: NA_PERONIE (sloty=%d) - czekam na BOARD", g_klient.id, g_waga_peronu);
+        {
+            long long teraz = czas_mono_ns();
+            histogram_zapisz(ETAP_PERON, g_klasa, teraz - t_etapu);
+            t_etapu = teraz;
+        }
+        LOG_ZDARZENIE(ZD_KLIENT_NA_PERONIE, g_klient.id, g_waga_peronu);
         
         /* Zwolnij teren (ale jeszcze trzymamy peron) */
         sem_signal_n(SEM_TEREN, g_klient.rozmiar_grupy);
-        MUTEX_SHM_LOCK();
-        g_shm->osoby_na_terenie -= g_klient.rozmiar_grupy;
-        g_shm->osoby_na_peronie += g_klient.rozmiar_grupy;
-        MUTEX_SHM_UNLOCK();
+        obecnosc_przenies(STREFA_TEREN, STREFA_PERON, g_klient.rozmiar_grupy);
         g_wpuszczony_na_teren = 0;
         
         /* Wyślij request do wyciągu */
         MsgWyciagReq req;
-        req.mtype = g_klient.vip ? MSG_TYP_VIP : MSG_TYP_NORMALNY;
+        req.mtype = g_linia;  /* klasę niesie pole vip */
         req.pid_klienta = g_klient.pid;
         req.typ_klienta = g_klient.typ;
         req.vip = g_klient.vip;
         req.rozmiar_grupy = g_klient.rozmiar_grupy;
         req.waga_slotow = g_waga_peronu;
+        req.skrzynka = g_skrzynka;
         
         if (wyslij_z_backoff(g_mq_wyciag_req, &req, sizeof(req), 1) != 0) {
             /* Nie udało się wysłać - ewakuacja */
-            sem_signal_n_undo(SEM_PERON, g_waga_peronu);
-            MUTEX_SHM_LOCK();
-            g_shm->osoby_na_peronie -= g_klient.rozmiar_grupy;
-            MUTEX_SHM_UNLOCK();
+            sem_signal_n_undo(SEM_PERON_LINII(g_linia), g_waga_peronu);
+            obecnosc_przenies(STREFA_PERON, STREFA_POZA, g_klient.rozmiar_grupy);
             g_waga_peronu = 0;
             break;
         }
@@ -590,54 +597,54 @@ int main(int argc, char *argv[]) {
         MsgWyciagOdp odp;
         int got_board = 0;
         while (!g_koniec && !got_board) {
-            int r = msg_recv_nowait(g_mq_wyciag_odp, &odp, sizeof(odp), (long)g_klient.pid);
+            /* Wyciąg obsłuży nas także w CLOSING/DRAINING (odpowie BOARD albo KONIEC) */
+            int r = msg_czekaj_odp(g_mq_wyciag_odp, &odp, sizeof(odp), (long)g_klient.pid,
+                                   NULL, CZEKANIE_ODP_MS);
             if (r > 0) {
                 if (odp.typ == WYCIAG_ODP_BOARD) {
                     got_board = 1;
                 } else if (odp.typ == WYCIAG_ODP_KONIEC) {
                     /* Wyciąg kazał wyjść */
-                    sem_signal_n_undo(SEM_PERON, g_waga_peronu);
-                    MUTEX_SHM_LOCK();
-                    g_shm->osoby_na_peronie -= g_klient.rozmiar_grupy;
-                    MUTEX_SHM_UNLOCK();
+                    sem_signal_n_undo(SEM_PERON_LINII(g_linia), g_waga_peronu);
+                    obecnosc_przenies(STREFA_PERON, STREFA_POZA, g_klient.rozmiar_grupy);
                     g_waga_peronu = 0;
                     g_stan = STAN_KASA;  /* reset stanu */
                     goto koniec_petli;
                 }
-            } else {
-                poll(NULL, 0, 10);
-            }
-            if (g_shm->koniec_dnia && g_shm->faza_dnia != FAZA_OPEN) {
-                poll(NULL, 0, 50);  /* Cierpliwość - wyciąg nas obsłuży */
+            } else if (r == -2) {
+                break;
             }
         }
         
         if (!got_board) {
             /* Przerwane sygnałem */
-            sem_signal_n_undo(SEM_PERON, g_waga_peronu);
-            MUTEX_SHM_LOCK();
-            g_shm->osoby_na_peronie -= g_klient.rozmiar_grupy;
-            MUTEX_SHM_UNLOCK();
+            sem_signal_n_undo(SEM_PERON_LINII(g_linia), g_waga_peronu);
+            obecnosc_przenies(STREFA_PERON, STREFA_POZA, g_klient.rozmiar_grupy);
             g_waga_peronu = 0;
             break;
         }
 
-        loguj("KLIENT %d: BOARD - wsiadam na krzesełko (sloty=%d)",
-              g_klient.id, req.waga_slotow);
+        {
+            long long teraz = czas_mono_ns();
+            histogram_zapisz(ETAP_BOARD, g_klasa, teraz - t_etapu);
+            t_etapu = teraz;
+        }
+        LOG_ZDARZENIE(ZD_KLIENT_BOARD, g_klient.id, req.waga_slotow);
         
         /* BOARD - od tego momentu jesteśmy "w krzesełku".
          * Ustaw stan PRZED zwolnieniem peronu: jeśli dostaniemy sygnał w środku,
          * SEM_UNDO odda sloty peronu automatycznie przy wyjściu procesu.
          */
         g_stan = STAN_W_KRZESLE;
-        sem_signal_n_undo(SEM_PERON, g_waga_peronu);
+        sem_signal_n_undo(SEM_PERON_LINII(g_linia), g_waga_peronu);
         /* Liczniki SHM przenosi WYCIĄG przy BOARD/ARRIVE (jedno źródło prawdy). */
         g_waga_peronu = 0;
         
         /* Czekaj na ARRIVE od wyciągu */
         int got_arrive = 0;
         while (!g_koniec && !got_arrive) {
-            int r = msg_recv_nowait(g_mq_wyciag_odp, &odp, sizeof(odp), (long)g_klient.pid);
+            int r = msg_czekaj_odp(g_mq_wyciag_odp, &odp, sizeof(odp), (long)g_klient.pid,
+                                   NULL, CZEKANIE_ODP_MS);
             if (r > 0) {
                 if (odp.typ == WYCIAG_ODP_ARRIVE) {
                     got_arrive = 1;
@@ -648,8 +655,8 @@ int main(int argc, char *argv[]) {
                     g_stan = STAN_KASA;
                     goto koniec_petli;
                 }
-            } else {
-                poll(NULL, 0, 10);
+            } else if (r == -2) {
+                break;
             }
         }
         
@@ -659,7 +666,8 @@ int main(int argc, char *argv[]) {
         }
 
         przejazdy++;
-        loguj("KLIENT %d: ARRIVE - jestem na górze (przejazd=%d)", g_klient.id, przejazdy);
+        histogram_zapisz(ETAP_PRZEJAZD, g_klasa, czas_mono_ns() - t_etapu);
+        LOG_ZDARZENIE(ZD_KLIENT_ARRIVE, g_klient.id, przejazdy);
         
         /* ARRIVE - jesteśmy na górze (wyciąg już zaktualizował liczniki) */
         g_stan = STAN_NA_GORZE;
@@ -685,21 +693,19 @@ int main(int argc, char *argv[]) {
         }
         
         int czas_trasy = pobierz_czas_trasy(trasa);
-        loguj("KLIENT %d: zjazd trasą %s (czas=%ds)", g_klient.id, nazwa_trasy(trasa), czas_trasy);
+        LOG_ZDARZENIE(ZD_KLIENT_ZJAZD, g_klient.id, trasa, czas_trasy);
         symuluj_czas_ms(czas_trasy * 1000);
 
-        loguj("KLIENT %d: wróciłem na dół po trasie %s", g_klient.id, nazwa_trasy(trasa));
+        LOG_ZDARZENIE(ZD_KLIENT_POWROT, g_klient.id, trasa);
         
-        MUTEX_SHM_LOCK();
-        g_shm->osoby_na_gorze -= g_klient.rozmiar_grupy;
-        g_shm->stats.uzycia_tras[trasa]++;
-        MUTEX_SHM_UNLOCK();
+        obecnosc_przenies(STREFA_GORA, STREFA_POZA, g_klient.rozmiar_grupy);
+        STAT_INC(uzycia_tras[trasa]);
         
         g_stan = STAN_PRZED_BRAMKA1;
         
         /* CHECK #3: Czy kontynuować? */
         karnet = pobierz_karnet(g_klient.id_karnetu);
-        if (karnet == NULL || !czy_karnet_wazny(karnet, time(NULL))) {
+        if (karnet == NULL || !czy_karnet_wazny(karnet, czas_mono_ns())) {
             break;
         }
         
@@ -712,6 +718,6 @@ int main(int argc, char *argv[]) {
     
 koniec_petli:
     dzieci_set_etap(DZ_ETAP_KONIEC, "KONIEC");
-    loguj("KLIENT %d: koniec (przejazdy=%d)", g_klient.id, przejazdy);
+    LOG_ZDARZENIE(ZD_KLIENT_KONIEC, g_klient.id, przejazdy);
     return EXIT_SUCCESS;  /* atexit() wywoła bezpieczne_zakonczenie() */
 }
@@ -0,0 +1,657 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <unistd.h>
+#include <signal.h>
+#include <time.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include "kolejki_shm.h"
+
+/*
+ * KOLEJ KRZESEŁKOWA - KOLEJKI W PAMIĘCI WSPÓŁDZIELONEJ
+ *
+ * Każda kolejka SysV z gorącej ścieżki (kasa, bramki, peron, wyciąg)
+ * ma tu swój odpowiednik: 1..SHMQ_MAX_KANALOW pierścieni MPMC (Vyukov).
+ * Kanał wybierany jest po mtype, więc msg_recv(mtype>0) dalej działa
+ * dla bramek (mtype = numer bramki).
+ *
+ * Odpowiedzi (kasa/bramka/peron/wyciąg -> klient) idą do skrzynek:
+ * klient zajmuje skrzynkę po attach i podaje jej indeks w żądaniu.
+ *
+ * Blokowanie: futex na licznikach zmian (dane / miejsce).
+ * Producent budzi tylko gdy ktoś faktycznie czeka (licznik czekających),
+ * więc w stanie ustalonym send/recv nie robi żadnego syscalla.
+ */
+
+/* ============================================
+ * STRUKTURY SEGMENTU
+ * ============================================ */
+#define SHMQ_MAGIC          0x4B514D53u     // "KQMS"
+#define SHMQ_WERSJA         5
+#define SHMQ_MAX_KANALOW    (LICZBA_BRAMEK1 > LINIE_MAX ? LICZBA_BRAMEK1 : LINIE_MAX)
+#define SHMQ_TIMEOUT_MS     1000            // co ile czekający sprawdza zamknięcie
+#define SHMQ_SLOWA_SPIACYCH ((SHMQ_SKRZYNKI + 63) / 64)
+
+/* Największy komunikat przenoszony pierścieniem (rozmiar slotu) */
+typedef union {
+    MsgKasa kasa;
+    MsgBramka1 bramka;
+    MsgPeron peron;
+    MsgWyciagReq wyciag;
+} ShmqKomunikat;
+
+/* Największa odpowiedź przenoszona skrzynką */
+typedef union {
+    MsgKasaOdp kasa;
+    MsgBramkaOdp bramka;
+    MsgPeronOdp peron;
+    MsgWyciagOdp wyciag;
+} ShmqOdpowiedz;
+
+/* Nagłówek slotu pierścienia */
+typedef struct {
+    unsigned long seq;          // numer sekwencyjny (protokół Vyukova)
+    long mtype;                 // typ komunikatu
+    int dlugosc;                // bajtów w dane[]
+} SlotPierscienia;
+
+/* Kanał = jeden pierścień + futex dla odbiorców tego kanału */
+typedef struct {
+    size_t offset;              // offset pierścienia od początku segmentu
+    int futex_dane;             // licznik włożeń (słowo futex)
+    int czekajacy;              // ilu odbiorców śpi na tym kanale
+} __attribute__((aligned(64))) KanalShm;
+
+typedef struct {
+    int kanaly;                         // liczba kanałów (1 = zwykła FIFO)
+    int futex_dane;                     // licznik włożeń (dla odbioru "dowolny")
+    int czekajacy_dowolny;              // odbiorcy z mtype <= 0
+    int futex_miejsce;                  // licznik wyjęć (dla pełnej kolejki)
+    int czekajacy_nadawcy;              // nadawcy czekający na miejsce
+    KanalShm kanal[SHMQ_MAX_KANALOW];
+} __attribute__((aligned(64))) KolejkaShm;
+
+/* Skrzynka odpowiedzi jednego klienta (pierścień leży zaraz za nagłówkiem) */
+typedef struct {
+    pid_t wlasciciel;                   // 0 = wolna
+    int zainicjowana;                   // pierścień przygotowany (raz na segment)
+    int futex;                          // licznik dostarczeń (słowo futex)
+    int czeka;                          // 1 = właściciel śpi na futexie
+} __attribute__((aligned(64))) SkrzynkaKlienta;
+
+typedef struct {
+    unsigned int magic;
+    unsigned int wersja;
+    size_t rozmiar;                     // rozmiar całego segmentu
+    int zamkniety;                      // 1 = main sprząta, wszyscy wychodzą
+    KolejkaShm kolejki[SHMQ_LICZBA_KOLEJEK];
+
+    size_t offset_skrzynek;             // początek tablicy skrzynek
+    unsigned int nastepna_skrzynka;     // round-robin przy przydziale
+    int zajete_skrzynki;                // licznik do monitora
+    unsigned int epoka_stanu;           // ++ przy każdej zmianie panic/faza_dnia/awaria
+    unsigned long spiace[SHMQ_SLOWA_SPIACYCH];  // bit idx = skrzynka ma czeka=1 (budzenie bez skanu 60k skrzynek)
+} NaglowekKolejek;
+
+/* Liczba kanałów dla każdej kolejki */
+static const int g_kanaly[SHMQ_LICZBA_KOLEJEK] = {
+    [SHMQ_KASA]       = 1,
+    [SHMQ_BRAMKA]     = LICZBA_BRAMEK1,
+    [SHMQ_PERON]      = 1,
+    [SHMQ_WYCIAG_REQ] = LINIE_MAX       // kanał = linia wyciągu (mtype)
+};
+
+/* Segment podpięty w tym procesie (NULL = transport SysV) */
+static NaglowekKolejek *g_seg = NULL;
+
+/* ============================================
+ * FUTEX
+ * ============================================ */
+
+int futex_czekaj(int *adres, int wartosc, int timeout_ms) {
+    struct timespec ts;
+    struct timespec *pts = NULL;
+
+    if (timeout_ms >= 0) {
+        ts.tv_sec = timeout_ms / 1000;
+        ts.tv_nsec = (long)(timeout_ms % 1000) * 1000000L;
+        pts = &ts;
+    }
+
+    /* FUTEX_WAIT (nie PRIVATE) - słowo leży w SHM dzielonym między procesami */
+    if (syscall(SYS_futex, adres, FUTEX_WAIT, wartosc, pts, NULL, 0) == -1) {
+        if (errno == EAGAIN) return 0;  /* wartość już inna - nie ma na co czekać */
+        return -1;
+    }
+    return 0;
+}
+
+void futex_obudz(int *adres, int n) {
+    syscall(SYS_futex, adres, FUTEX_WAKE, n, NULL, NULL, 0);
+}
+
+/* ============================================
+ * PIERŚCIEŃ MPMC
+ * ============================================ */
+
+static unsigned int krok_slotu(unsigned int rozmiar_slotu) {
+    size_t k = sizeof(SlotPierscienia) + rozmiar_slotu;
+    return (unsigned int)((k + 7) & ~(size_t)7);
+}
+
+static SlotPierscienia *slot(Pierscien *p, unsigned long pozycja) {
+    return (SlotPierscienia *)((char *)p + sizeof(Pierscien) +
+                               (size_t)(pozycja & p->maska) * p->krok);
+}
+
+size_t pierscien_rozmiar(unsigned int pojemnosc, unsigned int rozmiar_slotu) {
+    /* Zaokrąglenie do linii cache: kolejne bloki zaczynają się wyrównane */
+    size_t r = sizeof(Pierscien) + (size_t)pojemnosc * krok_slotu(rozmiar_slotu);
+    return (r + 63) & ~(size_t)63;
+}
+
+void pierscien_init(Pierscien *p, unsigned int pojemnosc, unsigned int rozmiar_slotu) {
+    memset(p, 0, sizeof(*p));
+    p->pojemnosc = pojemnosc;
+    p->maska = pojemnosc - 1;
+    p->rozmiar_slotu = rozmiar_slotu;
+    p->krok = krok_slotu(rozmiar_slotu);
+
+    for (unsigned int i = 0; i < pojemnosc; i++) {
+        slot(p, i)->seq = i;
+    }
+}
+
+int pierscien_wloz(Pierscien *p, long mtype, const void *dane, int dlugosc) {
+    if (dlugosc < 0 || (unsigned int)dlugosc > p->rozmiar_slotu) return -1;
+
+    unsigned long poz = __atomic_load_n(&p->zapis, __ATOMIC_RELAXED);
+    SlotPierscienia *s;
+
+    for (;;) {
+        s = slot(p, poz);
+        unsigned long seq = __atomic_load_n(&s->seq, __ATOMIC_ACQUIRE);
+        long roznica = (long)(seq - poz);
+
+        if (roznica == 0) {
+            /* Slot wolny - zarezerwuj pozycję */
+            if (__atomic_compare_exchange_n(&p->zapis, &poz, poz + 1, 1,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                break;
+            }
+            /* CAS nieudany: poz zaktualizowane, próbuj dalej */
+        } else if (roznica < 0) {
+            return -1;  /* pełny */
+        } else {
+            poz = __atomic_load_n(&p->zapis, __ATOMIC_RELAXED);
+        }
+    }
+
+    s->mtype = mtype;
+    s->dlugosc = dlugosc;
+    memcpy((char *)(s + 1), dane, (size_t)dlugosc);
+
+    /* Publikacja: od teraz konsument może czytać slot */
+    __atomic_store_n(&s->seq, poz + 1, __ATOMIC_RELEASE);
+    return 0;
+}
+
+int pierscien_wyjmij(Pierscien *p, long *mtype, void *dane, int max) {
+    unsigned long poz = __atomic_load_n(&p->odczyt, __ATOMIC_RELAXED);
+    SlotPierscienia *s;
+
+    for (;;) {
+        s = slot(p, poz);
+        unsigned long seq = __atomic_load_n(&s->seq, __ATOMIC_ACQUIRE);
+        long roznica = (long)(seq - (poz + 1));
+
+        if (roznica == 0) {
+            if (__atomic_compare_exchange_n(&p->odczyt, &poz, poz + 1, 1,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                break;
+            }
+        } else if (roznica < 0) {
+            return -1;  /* pusty (albo producent jeszcze nie opublikował) */
+        } else {
+            poz = __atomic_load_n(&p->odczyt, __ATOMIC_RELAXED);
+        }
+    }
+
+    int dlugosc = s->dlugosc;
+    if (dlugosc > max) dlugosc = max;
+    if (mtype) *mtype = s->mtype;
+    memcpy(dane, (char *)(s + 1), (size_t)dlugosc);
+
+    /* Zwolnij slot dla producenta z następnego okrążenia */
+    __atomic_store_n(&s->seq, poz + p->maska + 1, __ATOMIC_RELEASE);
+    return dlugosc;
+}
+
+unsigned long pierscien_liczba(const Pierscien *p) {
+    unsigned long z = __atomic_load_n(&p->zapis, __ATOMIC_RELAXED);
+    unsigned long o = __atomic_load_n(&p->odczyt, __ATOMIC_RELAXED);
+    return (z > o) ? (z - o) : 0;
+}
+
+/* ============================================
+ * SEGMENT KOLEJEK
+ * ============================================ */
+
+static size_t rozmiar_kanalu(void) {
+    return pierscien_rozmiar(SHMQ_POJEMNOSC, sizeof(ShmqKomunikat));
+}
+
+static size_t rozmiar_skrzynki(void) {
+    return sizeof(SkrzynkaKlienta) + pierscien_rozmiar(SKRZYNKA_GLEBOKOSC, sizeof(ShmqOdpowiedz));
+}
+
+size_t kolejki_shm_rozmiar(void) {
+    size_t r = sizeof(NaglowekKolejek);
+    for (int q = 0; q < SHMQ_LICZBA_KOLEJEK; q++) {
+        r += (size_t)g_kanaly[q] * rozmiar_kanalu();
+    }
+    r += (size_t)SHMQ_SKRZYNKI * rozmiar_skrzynki();
+    return r;
+}
+
+static Pierscien *pierscien_kanalu(KolejkaShm *q, int k) {
+    return (Pierscien *)((char *)g_seg + q->kanal[k].offset);
+}
+
+void kolejki_shm_init(void *segment) {
+    NaglowekKolejek *n = (NaglowekKolejek *)segment;
+    memset(n, 0, sizeof(*n));
+    n->magic = SHMQ_MAGIC;
+    n->wersja = SHMQ_WERSJA;
+    n->rozmiar = kolejki_shm_rozmiar();
+
+    size_t offset = sizeof(NaglowekKolejek);
+    for (int q = 0; q < SHMQ_LICZBA_KOLEJEK; q++) {
+        KolejkaShm *kol = &n->kolejki[q];
+        kol->kanaly = g_kanaly[q];
+        for (int k = 0; k < kol->kanaly; k++) {
+            kol->kanal[k].offset = offset;
+            pierscien_init((Pierscien *)((char *)n + offset), SHMQ_POJEMNOSC, sizeof(ShmqKomunikat));
+            offset += rozmiar_kanalu();
+        }
+    }
+
+    /* Skrzynki: tylko offset - pierścień inicjuje pierwszy właściciel
+     * (nie dotykamy kilkudziesięciu MB, których może nikt nie użyć) */
+    n->offset_skrzynek = offset;
+
+    g_seg = n;
+}
+
+int kolejki_shm_dolacz(void *segment) {
+    NaglowekKolejek *n = (NaglowekKolejek *)segment;
+    if (n->magic != SHMQ_MAGIC || n->wersja != SHMQ_WERSJA || n->rozmiar != kolejki_shm_rozmiar()) {
+        return -1;
+    }
+    g_seg = n;
+    return 0;
+}
+
+static SkrzynkaKlienta *skrzynka(int idx) {
+    return (SkrzynkaKlienta *)((char *)g_seg + g_seg->offset_skrzynek +
+                               (size_t)idx * rozmiar_skrzynki());
+}
+
+/* czeka w skrzynce + bit w spiace[] (ustawiany razem, przed sprawdzeniami) */
+static void ustaw_czeka(int idx, SkrzynkaKlienta *sk, int czeka) {
+    unsigned long bit = 1UL << (idx % 64);
+    __atomic_store_n(&sk->czeka, czeka, __ATOMIC_SEQ_CST);
+    if (czeka) {
+        __atomic_fetch_or(&g_seg->spiace[idx / 64], bit, __ATOMIC_SEQ_CST);
+    } else {
+        __atomic_fetch_and(&g_seg->spiace[idx / 64], ~bit, __ATOMIC_SEQ_CST);
+    }
+}
+
+/*
+ * Budzi właścicieli skrzynek śpiących na futexie.
+ * Czekający ogłasza czeka=1 (i bit w spiace[]) PRZED sprawdzeniem
+ * zamkniety/epoka_stanu, więc po zapisie tych pól wystarczy obudzić tych,
+ * którzy już śpią. Przegląd bitmapy: ~1k słów zamiast 60k skrzynek.
+ */
+static void obudz_spiace_skrzynki(void) {
+    for (int w = 0; w < SHMQ_SLOWA_SPIACYCH; w++) {
+        unsigned long bity = __atomic_load_n(&g_seg->spiace[w], __ATOMIC_SEQ_CST);
+        while (bity != 0) {
+            int idx = w * 64 + __builtin_ctzl(bity);
+            bity &= bity - 1;
+            SkrzynkaKlienta *sk = skrzynka(idx);
+            if (__atomic_load_n(&sk->czeka, __ATOMIC_SEQ_CST)) {
+                __atomic_fetch_add(&sk->futex, 1, __ATOMIC_SEQ_CST);
+                futex_obudz(&sk->futex, INT_MAX);
+            }
+        }
+    }
+}
+
+void kolejki_shm_zamknij(void) {
+    if (g_seg == NULL) return;
+
+    __atomic_store_n(&g_seg->zamkniety, 1, __ATOMIC_SEQ_CST);
+    obudz_spiace_skrzynki();
+
+    /* Obudź wszystkich (kolejne czekanie zobaczy zamkniety=1) */
+    for (int q = 0; q < SHMQ_LICZBA_KOLEJEK; q++) {
+        KolejkaShm *kol = &g_seg->kolejki[q];
+        __atomic_fetch_add(&kol->futex_dane, 1, __ATOMIC_SEQ_CST);
+        __atomic_fetch_add(&kol->futex_miejsce, 1, __ATOMIC_SEQ_CST);
+        futex_obudz(&kol->futex_dane, INT_MAX);
+        futex_obudz(&kol->futex_miejsce, INT_MAX);
+        for (int k = 0; k < kol->kanaly; k++) {
+            __atomic_fetch_add(&kol->kanal[k].futex_dane, 1, __ATOMIC_SEQ_CST);
+            futex_obudz(&kol->kanal[k].futex_dane, INT_MAX);
+        }
+    }
+}
+
+void kolejki_shm_odlacz(void) {
+    g_seg = NULL;
+}
+
+/* ============================================
+ * OPERACJE NA KOLEJKACH
+ * ============================================ */
+
+int shmq_czy_uchwyt(int mq_id) {
+    int idx = SHMQ_INDEKS(mq_id);
+    return g_seg != NULL && idx >= 0 && idx < SHMQ_LICZBA_KOLEJEK;
+}
+
+static int kanal_dla_mtype(const KolejkaShm *q, long mtype) {
+    if (q->kanaly <= 1 || mtype < 1) return 0;
+    return (int)((mtype - 1) % q->kanaly);
+}
+
+/* Jedna próba włożenia + obudzenie odbiorców jeśli śpią */
+static int sprobuj_wyslac(KolejkaShm *q, const void *msg, int dlugosc, long mtype) {
+    int k = kanal_dla_mtype(q, mtype);
+    if (pierscien_wloz(pierscien_kanalu(q, k), mtype, msg, dlugosc) != 0) return -1;
+
+    KanalShm *kan = &q->kanal[k];
+    __atomic_fetch_add(&kan->futex_dane, 1, __ATOMIC_SEQ_CST);
+    __atomic_fetch_add(&q->futex_dane, 1, __ATOMIC_SEQ_CST);
+
+    if (__atomic_load_n(&kan->czekajacy, __ATOMIC_SEQ_CST) > 0) {
+        futex_obudz(&kan->futex_dane, 1);
+    }
+    if (__atomic_load_n(&q->czekajacy_dowolny, __ATOMIC_SEQ_CST) > 0) {
+        /* Odbiorcy "dowolny" mogą filtrować różne podzbiory kanałów */
+        futex_obudz(&q->futex_dane, q->kanaly > 1 ? INT_MAX : 1);
+    }
+    return 0;
+}
+
+/* Jedna próba odbioru wg reguł msgrcv (mtype 0 / >0 / <0) */
+static int sprobuj_odebrac(KolejkaShm *q, void *msg, int max, long mtype) {
+    int od = 0, do_ = q->kanaly - 1;
+
+    if (mtype > 0) {
+        od = do_ = kanal_dla_mtype(q, mtype);
+    } else if (mtype < 0 && q->kanaly > 1) {
+        /* Najniższy typ <= |mtype|: przeglądamy kanały rosnąco */
+        long limit = -mtype;
+        if (limit < q->kanaly) do_ = (int)limit - 1;
+    }
+
+    for (int k = od; k <= do_; k++) {
+        int r = pierscien_wyjmij(pierscien_kanalu(q, k), NULL, msg, max);
+        if (r >= 0) {
+            __atomic_fetch_add(&q->futex_miejsce, 1, __ATOMIC_SEQ_CST);
+            if (__atomic_load_n(&q->czekajacy_nadawcy, __ATOMIC_SEQ_CST) > 0) {
+                futex_obudz(&q->futex_miejsce, 1);
+            }
+            return r;
+        }
+    }
+    return -1;
+}
+
+int shmq_wyslij(int uchwyt, const void *msg, size_t size, int czekaj) {
+    if (!shmq_czy_uchwyt(uchwyt)) { errno = EINVAL; return -2; }
+    if (size > sizeof(ShmqKomunikat)) { errno = EINVAL; return -1; }
+
+    KolejkaShm *q = &g_seg->kolejki[SHMQ_INDEKS(uchwyt)];
+    long mtype = *(const long *)msg;
+
+    for (;;) {
+        if (__atomic_load_n(&g_seg->zamkniety, __ATOMIC_ACQUIRE)) { errno = EIDRM; return -2; }
+
+        if (sprobuj_wyslac(q, msg, (int)size, mtype) == 0) return 0;
+        if (!czekaj) { errno = EAGAIN; return -1; }
+
+        /* Pełna: zarejestruj się i śpij do pierwszego wyjęcia */
+        int v = __atomic_load_n(&q->futex_miejsce, __ATOMIC_SEQ_CST);
+        __atomic_fetch_add(&q->czekajacy_nadawcy, 1, __ATOMIC_SEQ_CST);
+        if (sprobuj_wyslac(q, msg, (int)size, mtype) == 0) {
+            __atomic_fetch_sub(&q->czekajacy_nadawcy, 1, __ATOMIC_SEQ_CST);
+            return 0;
+        }
+        int w = futex_czekaj(&q->futex_miejsce, v, SHMQ_TIMEOUT_MS);
+        int e = errno;
+        __atomic_fetch_sub(&q->czekajacy_nadawcy, 1, __ATOMIC_SEQ_CST);
+        if (w == -1 && e == EINTR) { errno = EINTR; return -1; }
+    }
+}
+
+int shmq_odbierz(int uchwyt, void *msg, size_t size, long mtype, int czekaj) {
+    if (!shmq_czy_uchwyt(uchwyt)) { errno = EINVAL; return -2; }
+
+    KolejkaShm *q = &g_seg->kolejki[SHMQ_INDEKS(uchwyt)];
+    int max = (int)size;
+
+    /* Odbiór z jednego kanału śpi na futexie kanału, reszta na wspólnym */
+    int *futex_slowo = &q->futex_dane;
+    int *czekajacy = &q->czekajacy_dowolny;
+    if (mtype > 0 || q->kanaly == 1) {
+        KanalShm *kan = &q->kanal[kanal_dla_mtype(q, mtype)];
+        futex_slowo = &kan->futex_dane;
+        czekajacy = &kan->czekajacy;
+    }
+
+    for (;;) {
+        int r = sprobuj_odebrac(q, msg, max, mtype);
+        if (r >= 0) return r - (int)sizeof(long);
+
+        if (__atomic_load_n(&g_seg->zamkniety, __ATOMIC_ACQUIRE)) { errno = EIDRM; return -2; }
+        if (!czekaj) { errno = ENOMSG; return -1; }
+
+        /* Pusta: zarejestruj się, sprawdź jeszcze raz, śpij do zmiany licznika */
+        int v = __atomic_load_n(futex_slowo, __ATOMIC_SEQ_CST);
+        __atomic_fetch_add(czekajacy, 1, __ATOMIC_SEQ_CST);
+        r = sprobuj_odebrac(q, msg, max, mtype);
+        if (r >= 0) {
+            __atomic_fetch_sub(czekajacy, 1, __ATOMIC_SEQ_CST);
+            return r - (int)sizeof(long);
+        }
+        int w = futex_czekaj(futex_slowo, v, SHMQ_TIMEOUT_MS);
+        int e = errno;
+        __atomic_fetch_sub(czekajacy, 1, __ATOMIC_SEQ_CST);
+        if (w == -1 && e == EINTR) { errno = EINTR; return -1; }
+    }
+}
+
+long shmq_liczba(int uchwyt) {
+    if (!shmq_czy_uchwyt(uchwyt)) return -1;
+
+    KolejkaShm *q = &g_seg->kolejki[SHMQ_INDEKS(uchwyt)];
+    long suma = 0;
+    for (int k = 0; k < q->kanaly; k++) {
+        suma += (long)pierscien_liczba(pierscien_kanalu(q, k));
+    }
+    return suma;
+}
+
+long shmq_pojemnosc_bajtow(int uchwyt) {
+    if (!shmq_czy_uchwyt(uchwyt)) return -1;
+
+    KolejkaShm *q = &g_seg->kolejki[SHMQ_INDEKS(uchwyt)];
+    return (long)q->kanaly * SHMQ_POJEMNOSC * (long)sizeof(ShmqKomunikat);
+}
+
+/* ============================================
+ * SKRZYNKI ODPOWIEDZI
+ * ============================================ */
+
+static Pierscien *pierscien_skrzynki(SkrzynkaKlienta *sk) {
+    return (Pierscien *)(sk + 1);
+}
+
+static void oproznij_skrzynke(SkrzynkaKlienta *sk) {
+    ShmqOdpowiedz smieci;
+    while (pierscien_wyjmij(pierscien_skrzynki(sk), NULL, &smieci, (int)sizeof(smieci)) >= 0) {
+    }
+}
+
+int skrzynka_zajmij(pid_t pid) {
+    if (g_seg == NULL || pid <= 0) return -1;
+
+    unsigned int start = __atomic_fetch_add(&g_seg->nastepna_skrzynka, 1, __ATOMIC_RELAXED);
+
+    /* Przebieg 0: wolne skrzynki; przebieg 1: przejmij skrzynki martwych (SIGKILL) */
+    for (int przebieg = 0; przebieg < 2; przebieg++) {
+        for (int i = 0; i < SHMQ_SKRZYNKI; i++) {
+            int idx = (int)((start + (unsigned int)i) % SHMQ_SKRZYNKI);
+            SkrzynkaKlienta *sk = skrzynka(idx);
+            pid_t stary = __atomic_load_n(&sk->wlasciciel, __ATOMIC_ACQUIRE);
+
+            if (stary != 0) {
+                if (przebieg == 0) continue;
+                if (kill(stary, 0) == 0 || errno != ESRCH) continue;
+            }
+            if (!__atomic_compare_exchange_n(&sk->wlasciciel, &stary, pid, 0,
+                                             __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+                continue;
+            }
+
+            if (!sk->zainicjowana) {
+                /* Pierwsze użycie: nikt inny nie zna jeszcze tego indeksu */
+                pierscien_init(pierscien_skrzynki(sk), SKRZYNKA_GLEBOKOSC, sizeof(ShmqOdpowiedz));
+                sk->zainicjowana = 1;
+            } else {
+                oproznij_skrzynke(sk);
+            }
+            if (stary == 0) {
+                __atomic_fetch_add(&g_seg->zajete_skrzynki, 1, __ATOMIC_RELAXED);
+            }
+            return idx;
+        }
+    }
+    return -1;
+}
+
+void skrzynka_zwolnij(int idx, pid_t pid) {
+    if (g_seg == NULL || idx < 0 || idx >= SHMQ_SKRZYNKI) return;
+
+    SkrzynkaKlienta *sk = skrzynka(idx);
+    if (__atomic_load_n(&sk->wlasciciel, __ATOMIC_ACQUIRE) != pid) return;
+
+    oproznij_skrzynke(sk);
+    pid_t oczekiwany = pid;
+    if (__atomic_compare_exchange_n(&sk->wlasciciel, &oczekiwany, 0, 0,
+                                    __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+        __atomic_fetch_sub(&g_seg->zajete_skrzynki, 1, __ATOMIC_RELAXED);
+    }
+}
+
+int skrzynka_wyslij(int idx, pid_t pid, const void *msg, size_t size) {
+    if (g_seg == NULL || idx < 0 || idx >= SHMQ_SKRZYNKI) { errno = EINVAL; return -2; }
+    if (__atomic_load_n(&g_seg->zamkniety, __ATOMIC_ACQUIRE)) { errno = EIDRM; return -2; }
+    if (size > sizeof(ShmqOdpowiedz)) { errno = EINVAL; return -1; }
+
+    SkrzynkaKlienta *sk = skrzynka(idx);
+    if (__atomic_load_n(&sk->wlasciciel, __ATOMIC_ACQUIRE) != pid) {
+        errno = ESRCH;  /* klient już wyszedł - odpowiedź nie ma adresata */
+        return -1;
+    }
+
+    if (pierscien_wloz(pierscien_skrzynki(sk), (long)pid, msg, (int)size) != 0) {
+        errno = EAGAIN;
+        return -1;
+    }
+
+    __atomic_fetch_add(&sk->futex, 1, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&sk->czeka, __ATOMIC_SEQ_CST)) {
+        futex_obudz(&sk->futex, 1);
+    }
+    return 0;
+}
+
+int skrzynka_czekaj(int idx, pid_t pid, void *msg, size_t size, unsigned int *epoka, int timeout_ms) {
+    if (g_seg == NULL || idx < 0 || idx >= SHMQ_SKRZYNKI) { errno = EINVAL; return -2; }
+
+    SkrzynkaKlienta *sk = skrzynka(idx);
+    Pierscien *p = pierscien_skrzynki(sk);
+
+    for (;;) {
+        long mtype = 0;
+        int r = pierscien_wyjmij(p, &mtype, msg, (int)size);
+        if (r >= 0) {
+            /* Resztka po poprzednim właścicielu (wysłana przed przejęciem) */
+            if (mtype != (long)pid) continue;
+            return r - (int)sizeof(long);
+        }
+
+        if (__atomic_load_n(&g_seg->zamkniety, __ATOMIC_ACQUIRE)) { errno = EIDRM; return -2; }
+        if (timeout_ms == 0) { errno = ENOMSG; return -1; }
+
+        /* Kolejność: futex -> czeka=1 (+ bit) -> (pierścień, zamkniety, epoka) -> sen.
+         * Każdy zapis po naszym sprawdzeniu podbije futex, więc sen się nie zgubi. */
+        int v = __atomic_load_n(&sk->futex, __ATOMIC_SEQ_CST);
+        ustaw_czeka(idx, sk, 1);
+        if (pierscien_liczba(p) > 0) {
+            ustaw_czeka(idx, sk, 0);
+            continue;
+        }
+        if (__atomic_load_n(&g_seg->zamkniety, __ATOMIC_SEQ_CST)) {
+            ustaw_czeka(idx, sk, 0);
+            errno = EIDRM;
+            return -2;
+        }
+        if (epoka != NULL) {
+            unsigned int e = __atomic_load_n(&g_seg->epoka_stanu, __ATOMIC_SEQ_CST);
+            if (e != *epoka) {
+                ustaw_czeka(idx, sk, 0);
+                *epoka = e;
+                errno = EAGAIN;
+                return -1;
+            }
+        }
+
+        int w = futex_czekaj(&sk->futex, v, timeout_ms);
+        int e = errno;
+        ustaw_czeka(idx, sk, 0);
+        if (w == -1 && (e == EINTR || e == ETIMEDOUT)) { errno = e; return -1; }
+    }
+}
+
+int skrzynka_odbierz(int idx, pid_t pid, void *msg, size_t size, int czekaj) {
+    for (;;) {
+        int r = skrzynka_czekaj(idx, pid, msg, size, NULL, czekaj ? SHMQ_TIMEOUT_MS : 0);
+        if (r == -1 && errno == ETIMEDOUT) continue;
+        return r;
+    }
+}
+
+unsigned int skrzynki_epoka(void) {
+    if (g_seg == NULL) return 0;
+    return __atomic_load_n(&g_seg->epoka_stanu, __ATOMIC_SEQ_CST);
+}
+
+void skrzynki_powiadom(void) {
+    if (g_seg == NULL) return;
+    __atomic_fetch_add(&g_seg->epoka_stanu, 1, __ATOMIC_SEQ_CST);
+    obudz_spiace_skrzynki();
+}
+
+int skrzynki_zajete(void) {
+    if (g_seg == NULL) return -1;
+    return __atomic_load_n(&g_seg->zajete_skrzynki, __ATOMIC_RELAXED);
+}
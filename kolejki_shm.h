@@ -0,0 +1,201 @@
+#ifndef KOLEJKI_SHM_H
+#define KOLEJKI_SHM_H
+
+#include <stddef.h>
+#include "config.h"
+#include "types.h"
+
+/*
+ * KOLEJ KRZESEŁKOWA - KOLEJKI W PAMIĘCI WSPÓŁDZIELONEJ
+ * Alternatywny transport dla msg_send/msg_recv (TRANSPORT_SHM):
+ * ograniczone pierścienie MPMC o stałych slotach + futex do blokowania.
+ */
+
+/* ============================================
+ * PRYMITYWY FUTEX (między procesami, bez FUTEX_PRIVATE)
+ * ============================================ */
+
+/*
+ * Czeka aż *adres != wartosc (lub timeout / sygnał)
+ * timeout_ms < 0: bez limitu
+ * Zwraca: 0=obudzony/wartość już inna, -1=errno (EINTR, ETIMEDOUT)
+ */
+int futex_czekaj(int *adres, int wartosc, int timeout_ms);
+
+/*
+ * Budzi max n procesów czekających na adresie
+ */
+void futex_obudz(int *adres, int n);
+
+/* ============================================
+ * PIERŚCIEŃ MPMC (lock-free, stałe sloty)
+ * Nagłówek + sloty leżą w jednym bloku pamięci - używamy tylko offsetów,
+ * więc blok może być zmapowany pod różnymi adresami w różnych procesach.
+ * ============================================ */
+typedef struct {
+    unsigned int pojemnosc;         // liczba slotów (potęga 2)
+    unsigned int maska;             // pojemnosc - 1
+    unsigned int rozmiar_slotu;     // bajtów danych w slocie
+    unsigned int krok;              // bajtów na slot (z nagłówkiem slotu)
+
+    /* Kursory na osobnych liniach cache (producenci vs konsumenci) */
+    unsigned long zapis __attribute__((aligned(64)));
+    unsigned long odczyt __attribute__((aligned(64)));
+} __attribute__((aligned(64))) Pierscien;
+
+/*
+ * Rozmiar bloku (nagłówek + sloty) dla danej geometrii
+ */
+size_t pierscien_rozmiar(unsigned int pojemnosc, unsigned int rozmiar_slotu);
+
+/*
+ * Inicjalizuje pierścień w przygotowanym bloku (pojemnosc = potęga 2)
+ */
+void pierscien_init(Pierscien *p, unsigned int pojemnosc, unsigned int rozmiar_slotu);
+
+/*
+ * Wkłada rekord (mtype + dane) bez blokowania
+ * Zwraca: 0=OK, -1=pełny
+ */
+int pierscien_wloz(Pierscien *p, long mtype, const void *dane, int dlugosc);
+
+/*
+ * Wyjmuje rekord bez blokowania
+ * Zwraca: długość danych (>=0) lub -1=pusty
+ */
+int pierscien_wyjmij(Pierscien *p, long *mtype, void *dane, int max);
+
+/*
+ * Przybliżona liczba rekordów w pierścieniu
+ */
+unsigned long pierscien_liczba(const Pierscien *p);
+
+/* ============================================
+ * KOLEJKI SHM (zamienniki kolejek SysV)
+ * ============================================ */
+
+/* Kolejki przeniesione do pierścieni (reszta zostaje na SysV) */
+typedef enum {
+    SHMQ_KASA = 0,
+    SHMQ_BRAMKA,
+    SHMQ_PERON,
+    SHMQ_WYCIAG_REQ,
+    SHMQ_LICZBA_KOLEJEK
+} IndeksKolejkiShm;
+
+/*
+ * Uchwyty kolejek SHM są ujemne (msqid SysV są zawsze >= 0),
+ * więc g_mq_* może trzymać jedno albo drugie, a -1 nadal znaczy "brak".
+ */
+#define SHMQ_UCHWYT(idx)        (-100 - (idx))
+#define SHMQ_INDEKS(uchwyt)     (-100 - (uchwyt))
+
+/*
+ * Rozmiar segmentu kolejek (wszystkie pierścienie)
+ */
+size_t kolejki_shm_rozmiar(void);
+
+/*
+ * Inicjalizuje świeży segment kolejek (tylko main)
+ */
+void kolejki_shm_init(void *segment);
+
+/*
+ * Podpina segment kolejek w procesie (po shmat)
+ * Zwraca: 0=OK, -1=zły segment (inna wersja/rozmiar)
+ */
+int kolejki_shm_dolacz(void *segment);
+
+/*
+ * Zamyka kolejki: budzi wszystkich czekających, kolejne operacje zwracają -2
+ * Wywołać w main przed usunięciem segmentu.
+ */
+void kolejki_shm_zamknij(void);
+
+/*
+ * Odłącza segment w bieżącym procesie (bez usuwania)
+ */
+void kolejki_shm_odlacz(void);
+
+/*
+ * Czy mq_id jest uchwytem kolejki SHM (podpiętej w tym procesie)
+ */
+int shmq_czy_uchwyt(int mq_id);
+
+/*
+ * Wysyła komunikat (ta sama umowa co msg_send / msg_send_nowait)
+ * Zwraca: 0=OK, -1=pełna (errno=EAGAIN) / przerwane (EINTR), -2=zamknięta
+ */
+int shmq_wyslij(int uchwyt, const void *msg, size_t size, int czekaj);
+
+/*
+ * Odbiera komunikat (ta sama umowa co msg_recv / msg_recv_nowait)
+ * mtype: 0=dowolny, >0=konkretny kanał, <0=najniższy kanał <= |mtype|
+ * Zwraca: >=0 rozmiar (bez mtype), -1=brak (ENOMSG) / przerwane (EINTR), -2=zamknięta
+ */
+int shmq_odbierz(int uchwyt, void *msg, size_t size, long mtype, int czekaj);
+
+/*
+ * Liczba komunikatów w kolejce / pojemność w bajtach (do monitora)
+ */
+long shmq_liczba(int uchwyt);
+long shmq_pojemnosc_bajtow(int uchwyt);
+
+/* ============================================
+ * SKRZYNKI ODPOWIEDZI KLIENTÓW
+ * Każdy klient dostaje własną skrzynkę (indeks w tablicy SHMQ_SKRZYNKI),
+ * więc odpowiedź to jeden zapis do pierścienia + futex wake,
+ * a odbiór nie przegląda cudzych komunikatów (jak msgrcv z mtype=pid).
+ * ============================================ */
+
+/*
+ * Zajmuje wolną skrzynkę dla procesu pid (przejmuje skrzynki martwych procesów)
+ * Zwraca: indeks skrzynki lub -1 (brak wolnych / brak segmentu)
+ */
+int skrzynka_zajmij(pid_t pid);
+
+/*
+ * Zwalnia skrzynkę (wyrzuca nieodebrane odpowiedzi)
+ */
+void skrzynka_zwolnij(int skrzynka, pid_t pid);
+
+/*
+ * Wkłada odpowiedź do skrzynki klienta pid (mtype komunikatu = pid)
+ * Zwraca: 0=OK, -1=pełna (EAGAIN) / skrzynka ma innego właściciela (ESRCH), -2=zamknięte
+ */
+int skrzynka_wyslij(int skrzynka, pid_t pid, const void *msg, size_t size);
+
+/*
+ * Odbiera odpowiedź z własnej skrzynki (komunikaty z obcym mtype są odrzucane)
+ * Zwraca: >=0 rozmiar (bez mtype), -1=brak (ENOMSG) / przerwane (EINTR), -2=zamknięte
+ */
+int skrzynka_odbierz(int skrzynka, pid_t pid, void *msg, size_t size, int czekaj);
+
+/*
+ * Czeka na odpowiedź w skrzynce albo na zmianę stanu globalnego
+ * epoka: epoka znana wywołującemu (NULL = ignoruj zmiany stanu), przy zmianie aktualizowana
+ * timeout_ms: 0=bez czekania, <0=bez limitu
+ * Zwraca: >=0 rozmiar (bez mtype),
+ *         -1 = zmiana stanu (EAGAIN) / timeout (ETIMEDOUT) / przerwane (EINTR) / brak (ENOMSG),
+ *         -2 = zamknięte
+ */
+int skrzynka_czekaj(int skrzynka, pid_t pid, void *msg, size_t size,
+                    unsigned int *epoka, int timeout_ms);
+
+/*
+ * Bieżąca epoka stanu globalnego (0 = brak segmentu)
+ */
+unsigned int skrzynki_epoka(void);
+
+/*
+ * Ogłasza zmianę stanu globalnego (panic / faza_dnia / awaria):
+ * nowa epoka + pobudka wszystkich śpiących w skrzynka_czekaj
+ */
+void skrzynki_powiadom(void);
+
+/*
+ * Liczba zajętych skrzynek (do monitora)
+ */
+int skrzynki_zajete(void);
+
+#endif /* KOLEJKI_SHM_H */
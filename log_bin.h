@@ -0,0 +1,31 @@
+#ifndef LOG_BIN_H
+#define LOG_BIN_H
+
+#include <stddef.h>
+#include "types.h"
+
+/*
+ * KOLEJ KRZESEŁKOWA - BINARNY PLIK LOGU PRZEJŚĆ
+ * Nagłówek (64 B) + rekordy LogEntry (16 B) w kolejności drenażu.
+ * Liczby w porządku bajtów maszyny, która plik zapisała (plik nie
+ * opuszcza hosta symulacji); CSV robi narzędzie ./logdump.
+ * Zmiana rekordu = podbicie LOG_BIN_WERSJA.
+ */
+
+#define LOG_BIN_MAGIC       0x42504C4Bu     // "KLPB"
+#define LOG_BIN_WERSJA      2
+#define LOG_BIN_SCHEMAT     "karnet:i32 typ:u8 nr:u8 -:u16 ns:i64"
+
+typedef struct {
+    unsigned int magic;             // LOG_BIN_MAGIC
+    unsigned short wersja;          // LOG_BIN_WERSJA
+    unsigned short rozmiar_rekordu; // sizeof(LogEntry)
+    KotwicaCzasu kotwica;           // g_shm->kotwica: ściana = sciana_ns + (czas_ns - mono_ns)
+    char schemat[40];               // LOG_BIN_SCHEMAT (dla ludzi / hexdump)
+} NaglowekLoguBin;
+
+_Static_assert(sizeof(LogEntry) == 16, "log_bin: rekord LogEntry musi mieć 16 bajtów");
+_Static_assert(sizeof(NaglowekLoguBin) == 64, "log_bin: nagłówek musi mieć 64 bajty");
+_Static_assert(sizeof(LOG_BIN_SCHEMAT) <= 40, "log_bin: schemat za długi");
+
+#endif /* LOG_BIN_H */
@@ -0,0 +1,116 @@
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <signal.h>
+#include <pthread.h>
+#include "log_przejsc.h"
+#include "log_bin.h"
+#include "config.h"
+#include "types.h"
+#include "ipc.h"
+#include "utils.h"
+
+/*
+ * KOLEJ KRZESEŁKOWA - DRENAŻ LOGU PRZEJŚĆ
+ * Jedyny konsument pierścienia logu przejść. Wpisy trafiają do pliku
+ * binarnego (log_bin.h) bez formatowania: paczki po LOGI_BUFOR_ZAPISU
+ * rekordów jednym write(), reszta na końcu każdego opróżnienia.
+ */
+
+static pthread_t g_watek;
+static int g_dziala = 0;
+static int g_stop = 0;
+static int g_fd = -1;
+static unsigned long g_zapisane = 0;
+
+static LogEntry g_bufor[LOGI_BUFOR_ZAPISU];
+static int g_w_buforze = 0;
+
+/* write() całego bloku z obsługą EINTR. 0=OK, -1=błąd */
+static int zapisz_blok(const void *dane, size_t len) {
+    size_t pos = 0;
+    while (pos < len) {
+        ssize_t w = write(g_fd, (const char *)dane + pos, len - pos);
+        if (w < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        pos += (size_t)w;
+    }
+    return 0;
+}
+
+static void zapisz_bufor(void) {
+    if (g_w_buforze == 0) return;
+    if (g_fd >= 0 && zapisz_blok(g_bufor, (size_t)g_w_buforze * sizeof(LogEntry)) == 0) {
+        g_zapisane += (unsigned long)g_w_buforze;
+    }
+    g_w_buforze = 0;
+}
+
+static void drenuj(void) {
+    while (pobierz_log(&g_bufor[g_w_buforze]) == 0) {
+        if (++g_w_buforze == LOGI_BUFOR_ZAPISU) zapisz_bufor();
+    }
+    zapisz_bufor();
+}
+
+static void *watek_drenazu(void *arg) {
+    (void)arg;
+    while (!__atomic_load_n(&g_stop, __ATOMIC_ACQUIRE)) {
+        drenuj();
+        poll(NULL, 0, LOGI_DRENAZ_MS);
+    }
+    return NULL;
+}
+
+int log_przejsc_start(const char *sciezka) {
+    g_fd = open(sciezka, O_CREAT | O_WRONLY | O_TRUNC, 0644);
+    if (g_fd < 0) {
+        blad_ostrzezenie("open log przejść");
+    } else {
+        NaglowekLoguBin n;
+        memset(&n, 0, sizeof(n));
+        n.magic = LOG_BIN_MAGIC;
+        n.wersja = LOG_BIN_WERSJA;
+        n.rozmiar_rekordu = sizeof(LogEntry);
+        n.kotwica = g_shm->kotwica;
+        memcpy(n.schemat, LOG_BIN_SCHEMAT, sizeof(LOG_BIN_SCHEMAT));
+        if (zapisz_blok(&n, sizeof(n)) != 0) {
+            blad_ostrzezenie("write nagłówek logu przejść");
+            close(g_fd);
+            g_fd = -1;
+        }
+    }
+
+    /* Sygnały obsługuje wątek główny (handlery main.c) */
+    sigset_t wszystkie, stare;
+    sigfillset(&wszystkie);
+    pthread_sigmask(SIG_BLOCK, &wszystkie, &stare);
+    int ret = pthread_create(&g_watek, NULL, watek_drenazu, NULL);
+    pthread_sigmask(SIG_SETMASK, &stare, NULL);
+
+    if (ret != 0) {
+        loguj("OSTRZEŻENIE: pthread_create (drenaż logu przejść): %s", strerror(ret));
+        return -1;
+    }
+    g_dziala = 1;
+    return 0;
+}
+
+unsigned long log_przejsc_zakoncz(void) {
+    if (g_dziala) {
+        __atomic_store_n(&g_stop, 1, __ATOMIC_RELEASE);
+        pthread_join(g_watek, NULL);
+        g_dziala = 0;
+    }
+    drenuj();
+    if (g_fd >= 0) {
+        close(g_fd);
+        g_fd = -1;
+    }
+    return g_zapisane;
+}
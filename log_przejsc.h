@@ -0,0 +1,26 @@
+#ifndef LOG_PRZEJSC_H
+#define LOG_PRZEJSC_H
+
+/*
+ * KOLEJ KRZESEŁKOWA - DRENAŻ LOGU PRZEJŚĆ (tylko main)
+ * Wątek main co LOGI_DRENAZ_MS opróżnia pierścień logu przejść
+ * (dodaj_log w bramkach / klientach) i dopisuje wpisy do pliku
+ * binarnego (log_bin.h), więc pamięć jest stała, a raport końcowy
+ * tylko domyka plik. CSV: ./logdump.
+ */
+
+/*
+ * Otwiera plik logu (nagłówek NaglowekLoguBin) i startuje wątek drenujący
+ * Bez pliku wątek i tak drenuje (wpisy przepadają, producenci nie czekają).
+ * Zwraca: 0=OK, -1=nie udało się uruchomić wątku
+ */
+int log_przejsc_start(const char *sciezka);
+
+/*
+ * Zatrzymuje wątek, opróżnia resztę pierścienia, zamyka plik
+ * (można wołać wielokrotnie)
+ * Zwraca: liczba wpisów zapisanych do pliku
+ */
+unsigned long log_przejsc_zakoncz(void);
+
+#endif /* LOG_PRZEJSC_H */
@@ -0,0 +1,288 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "config.h"
+#include "types.h"
+#include "log_bin.h"
+#include "probki_bin.h"
+
+/*
+ * KOLEJ KRZESEŁKOWA - LOGDUMP
+ * Zamienia binarny log przejść (PLIK_LOG, format log_bin.h) na CSV
+ * ID_KARNETU;TYP_BRAMKI;NR_BRAMKI;CZAS - ten sam, który wcześniej
+ * pisał main na koniec dnia.
+ *
+ * Szybka ścieżka: rekordy czytane paczkami, wiersze składane ręcznie
+ * do dużego bufora, a localtime_r + strftime tylko przy zmianie sekundy
+ * (wpisy są prawie posortowane po czasie).
+ *
+ * Plik próbek (PLIK_PROBKI, format probki_bin.h) rozpoznawany po magic:
+ * wiersz na próbkę T_MS;CZAS;<kolumny z nagłówka>, T_MS od startu dnia.
+ *
+ * Użycie: ./logdump [--ms] [plik.bin] [plik.csv]
+ *   --ms      CZAS jako HH:MM:SS.mmm (domyślnie HH:MM:SS jak dotąd; próbki zawsze z ms)
+ *   plik.bin  domyślnie PLIK_LOG
+ *   plik.csv  domyślnie stdout
+ */
+
+_Static_assert(sizeof(NaglowekProbekBin) == sizeof(NaglowekLoguBin), "logdump: nagłówki muszą mieć równy rozmiar");
+
+#define REKORDOW_NA_ODCZYT  4096
+#define BUFOR_WYJSCIA       (1 << 20)
+
+static char g_wyjscie[BUFOR_WYJSCIA];
+static size_t g_zajete = 0;
+static FILE *g_out = NULL;
+
+static void oproznij_wyjscie(void) {
+    if (g_zajete > 0) {
+        fwrite(g_wyjscie, 1, g_zajete, g_out);
+        g_zajete = 0;
+    }
+}
+
+static void dopisz(const char *s, size_t len) {
+    memcpy(g_wyjscie + g_zajete, s, len);
+    g_zajete += len;
+}
+
+static void dopisz_int(long v) {
+    char tmp[24];
+    int n = 0;
+    unsigned long u = (v < 0) ? (unsigned long)(-v) : (unsigned long)v;
+
+    do {
+        tmp[n++] = (char)('0' + u % 10);
+        u /= 10;
+    } while (u > 0);
+    if (v < 0) tmp[n++] = '-';
+    while (n > 0) g_wyjscie[g_zajete++] = tmp[--n];
+}
+
+static const char *nazwa_typu_logu(int typ, size_t *len) {
+    static const char *nazwy[] = {"NIEZNANY", "BRAMKA1", "BRAMKA2", "WYJSCIE_GORA"};
+    if (typ < LOG_BRAMKA1 || typ > LOG_WYJSCIE_GORA) typ = 0;
+    *len = strlen(nazwy[typ]);
+    return nazwy[typ];
+}
+
+/* "HH:MM:SS" dla sekundy sek - przeliczane tylko przy zmianie */
+static const char *czas_sekundy(time_t sek) {
+    static time_t ostatnia = (time_t)-1;
+    static char napis[16];
+
+    if (sek != ostatnia) {
+        struct tm tm_info;
+        localtime_r(&sek, &tm_info);
+        strftime(napis, sizeof(napis), "%H:%M:%S", &tm_info);
+        ostatnia = sek;
+    }
+    return napis;
+}
+
+/* Czas monotoniczny -> ściana w ms przez kotwicę z nagłówka */
+static long long sciana_ms(long long czas_ns, const KotwicaCzasu *k) {
+    return (k->sciana_ns + (czas_ns - k->mono_ns)) / 1000000LL;
+}
+
+/* "HH:MM:SS.mmm" */
+static void dopisz_czas_ms(long long ms) {
+    int reszta = (int)(ms % 1000);
+    dopisz(czas_sekundy((time_t)(ms / 1000)), 8);
+    g_wyjscie[g_zajete++] = '.';
+    g_wyjscie[g_zajete++] = (char)('0' + reszta / 100);
+    g_wyjscie[g_zajete++] = (char)('0' + reszta / 10 % 10);
+    g_wyjscie[g_zajete++] = (char)('0' + reszta % 10);
+}
+
+/* Wpis logu przejść; czas monotoniczny -> ściana przez kotwicę z nagłówka */
+static void zapisz_wiersz(const LogEntry *w, const KotwicaCzasu *k, int z_ms) {
+    size_t len;
+    const char *typ = nazwa_typu_logu(w->typ_bramki, &len);
+    long long ms = sciana_ms(w->czas_ns, k);
+
+    /* Najdłuższy wiersz to ~60 znaków */
+    if (g_zajete + 128 > sizeof(g_wyjscie)) oproznij_wyjscie();
+
+    dopisz_int(w->id_karnetu);
+    g_wyjscie[g_zajete++] = ';';
+    dopisz(typ, len);
+    g_wyjscie[g_zajete++] = ';';
+    dopisz_int(w->numer_bramki);
+    g_wyjscie[g_zajete++] = ';';
+    if (z_ms) {
+        dopisz_czas_ms(ms);
+    } else {
+        dopisz(czas_sekundy((time_t)(ms / 1000)), 8);
+    }
+    g_wyjscie[g_zajete++] = '\n';
+}
+
+/*
+ * Plik próbek: kolumny w pliku -> wiersze CSV
+ * Zwraca: liczba wierszy, -1=plik urwany / błąd pamięci
+ */
+static long zrzuc_probki(FILE *in, const NaglowekProbekBin *n) {
+    int kol = n->liczba_kolumn;
+    size_t ile = n->liczba_probek;
+    char (*nazwy)[PROBKI_NAZWA_KOLUMNY] = calloc((size_t)kol + 1, PROBKI_NAZWA_KOLUMNY);
+    long long *czas = malloc((ile + 1) * sizeof(long long));
+    int *wartosci = malloc(((size_t)kol * ile + 1) * sizeof(int));
+    long wynik = -1;
+
+    if (nazwy == NULL || czas == NULL || wartosci == NULL) goto koniec;
+    if (fread(nazwy, PROBKI_NAZWA_KOLUMNY, (size_t)kol, in) != (size_t)kol ||
+        fread(czas, sizeof(long long), ile, in) != ile ||
+        fread(wartosci, sizeof(int), (size_t)kol * ile, in) != (size_t)kol * ile) {
+        goto koniec;
+    }
+
+    dopisz("T_MS;CZAS", 9);
+    for (int k = 0; k < kol; k++) {
+        nazwy[k][PROBKI_NAZWA_KOLUMNY - 1] = '\0';
+        g_wyjscie[g_zajete++] = ';';
+        dopisz(nazwy[k], strlen(nazwy[k]));
+    }
+    g_wyjscie[g_zajete++] = '\n';
+
+    for (size_t i = 0; i < ile; i++) {
+        /* T_MS + CZAS + do 12 znaków na kolumnę */
+        if (g_zajete + 64 + (size_t)kol * 12 > sizeof(g_wyjscie)) oproznij_wyjscie();
+
+        dopisz_int((long)((czas[i] - n->kotwica.mono_ns) / 1000000LL));
+        g_wyjscie[g_zajete++] = ';';
+        dopisz_czas_ms(sciana_ms(czas[i], &n->kotwica));
+        for (int k = 0; k < kol; k++) {
+            g_wyjscie[g_zajete++] = ';';
+            dopisz_int(wartosci[(size_t)k * ile + i]);
+        }
+        g_wyjscie[g_zajete++] = '\n';
+    }
+    oproznij_wyjscie();
+    wynik = (long)ile;
+
+koniec:
+    free(nazwy);
+    free(czas);
+    free(wartosci);
+    return wynik;
+}
+
+static FILE *otworz_wyjscie(const char *wyjscie) {
+    FILE *f = (wyjscie != NULL) ? fopen(wyjscie, "w") : stdout;
+    if (f == NULL) perror(wyjscie);
+    return f;
+}
+
+static void uzycie(const char *argv0) {
+    fprintf(stderr, "Użycie: %s [--ms] [plik.bin] [plik.csv]\n", argv0);
+    fprintf(stderr, "  plik.bin - binarny log przejść (domyślnie %s) albo plik próbek (%s)\n", PLIK_LOG, PLIK_PROBKI);
+    fprintf(stderr, "  plik.csv - wynik (domyślnie stdout)\n");
+}
+
+int main(int argc, char *argv[]) {
+    const char *wejscie = PLIK_LOG;
+    const char *wyjscie = NULL;
+    int z_ms = 0;
+    int pozycyjne = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--ms") == 0) {
+            z_ms = 1;
+        } else if (strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0) {
+            uzycie(argv[0]);
+            return EXIT_SUCCESS;
+        } else if (pozycyjne == 0) {
+            wejscie = argv[i];
+            pozycyjne++;
+        } else if (pozycyjne == 1) {
+            wyjscie = argv[i];
+            pozycyjne++;
+        } else {
+            uzycie(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    FILE *in = fopen(wejscie, "rb");
+    if (in == NULL) {
+        perror(wejscie);
+        return EXIT_FAILURE;
+    }
+
+    NaglowekLoguBin n;
+    memset(&n, 0, sizeof(n));
+    int naglowek_ok = fread(&n, sizeof(n), 1, in) == 1;
+
+    if (naglowek_ok && n.magic == PROBKI_BIN_MAGIC) {
+        NaglowekProbekBin np;
+        memcpy(&np, &n, sizeof(np));
+        if (np.wersja != PROBKI_BIN_WERSJA) {
+            fprintf(stderr, "logdump: %s - plik próbek w wersji %u (obsługiwana %d)\n",
+                    wejscie, (unsigned)np.wersja, PROBKI_BIN_WERSJA);
+            fclose(in);
+            return EXIT_FAILURE;
+        }
+        g_out = otworz_wyjscie(wyjscie);
+        if (g_out == NULL) {
+            fclose(in);
+            return EXIT_FAILURE;
+        }
+        long wierszy = zrzuc_probki(in, &np);
+        fclose(in);
+        if (wierszy < 0) {
+            fprintf(stderr, "logdump: %s - urwany plik próbek albo brak pamięci\n", wejscie);
+        } else if (g_out != stdout) {
+            fprintf(stderr, "logdump: %ld próbek (%u kolumn, co %u ms) -> %s\n",
+                    wierszy, (unsigned)np.liczba_kolumn, np.interwal_ms, wyjscie);
+        }
+        if (g_out != stdout) fclose(g_out);
+        return (wierszy < 0) ? EXIT_FAILURE : EXIT_SUCCESS;
+    }
+
+    if (!naglowek_ok ||
+        n.magic != LOG_BIN_MAGIC ||
+        n.wersja != LOG_BIN_WERSJA ||
+        n.rozmiar_rekordu != sizeof(LogEntry)) {
+        fprintf(stderr, "logdump: %s nie jest logiem przejść w wersji %d (magic=0x%08X, wersja=%u, rekord=%u)\n",
+                wejscie, LOG_BIN_WERSJA, n.magic, (unsigned)n.wersja, (unsigned)n.rozmiar_rekordu);
+        fclose(in);
+        return EXIT_FAILURE;
+    }
+
+    g_out = otworz_wyjscie(wyjscie);
+    if (g_out == NULL) {
+        fclose(in);
+        return EXIT_FAILURE;
+    }
+
+    static LogEntry rekordy[REKORDOW_NA_ODCZYT];
+    unsigned long wierszy = 0;
+    size_t r;
+
+    {
+        static const char naglowek_csv[] = "ID_KARNETU;TYP_BRAMKI;NR_BRAMKI;CZAS\n";
+        dopisz(naglowek_csv, sizeof(naglowek_csv) - 1);
+    }
+    while ((r = fread(rekordy, sizeof(LogEntry), REKORDOW_NA_ODCZYT, in)) > 0) {
+        for (size_t i = 0; i < r; i++) {
+            zapisz_wiersz(&rekordy[i], &n.kotwica, z_ms);
+        }
+        wierszy += r;
+    }
+    oproznij_wyjscie();
+
+    /* Urwany ostatni rekord = plik z przerwanego zapisu (crash main) */
+    if (!feof(in) || ftell(in) != (long)(sizeof(n) + wierszy * sizeof(LogEntry))) {
+        fprintf(stderr, "logdump: %s - niepełny ostatni rekord albo błąd odczytu (pominięty)\n", wejscie);
+    }
+    fclose(in);
+
+    if (g_out != stdout) {
+        fclose(g_out);
+        fprintf(stderr, "logdump: %lu wpisów -> %s\n", wierszy, wyjscie);
+    }
+    return EXIT_SUCCESS;
+}
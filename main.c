@@ -10,11 +10,18 @@
 #include <errno.h>
 #include <time.h>
 #include <poll.h>
+#include <limits.h>
 
 #include "config.h"
 #include "types.h"
 #include "ipc.h"
 #include "utils.h"
+#include "czas.h"
+#include "statystyki.h"
+#include "obecnosc.h"
+#include "log_przejsc.h"
+#include "probki.h"
+#include "histogram.h"
 
 /*
  * KOLEJ KRZESEŁKOWA - PROCES GŁÓWNY (MAIN)
@@ -39,6 +46,11 @@ static int g_czas_symulacji = CZAS_SYMULACJI;      /* czas symulacji */
 static int g_limit_utworzonych = MAX_WYG_KLIENTOW; /* limit łączny generowania (0=bez limitu) */
 static int g_limit_aktywnych = MAX_KLIENTOW;       /* limit aktywnych klientów (0=bez limitu) */
 static int g_kasjer_ticket_mask = KASJER_TICKET_MASK_DEFAULT; /* maska typów karnetów sprzedawanych przez kasjera */
+static int g_transport = TRANSPORT_SYSV;           /* transport kolejek gorącej ścieżki */
+static int g_probki_ms = PROBKI_MS;                /* odstęp próbkowania kolejek (0=wyłączone) */
+static int g_nadrabianie = NADRABIANIE_SERIA;      /* tryb nadrabiania zegara wyciągu */
+static int g_pakowanie = PAKOWANIE_ZACHLANNA;      /* polityka pakowania rzędu */
+static GeometriaWyciagu g_geometria_wyciagu;       /* ring wyciągu / peron (config.h + ENV_RZEDY...) */
 static int g_ipc_zainicjalizowane = 0;             /* czy IPC zostało utworzone */
 static int g_cleanup_wykonany = 0;                 /* czy cleanup już był */
 
@@ -65,6 +77,7 @@ static void panic_shutdown(const char *powod, pid_t pid, int kod, int przez_sygn
 
 static int uruchom_procesy_stale(void);
 static pid_t fork_exec(const char *program, char *const argv[], const char *log_path);
+static void zapisz_pid(pid_t *pole, pid_t pid);
 static void zakoncz_procesy_potomne(void);
 static void procedura_konca_dnia(void);
 static void generuj_raport_koncowy(void);
@@ -82,7 +95,7 @@ static void awaryjny_cleanup(void) {
     g_cleanup_wykonany = 1;
     
     /* Wypisz ostrzeżenie jeśli to awaryjne zamknięcie */
-    if (g_ipc_zainicjalizowane && g_shm != NULL && !g_shm->koniec_dnia) {
+    if (g_ipc_zainicjalizowane && g_shm != NULL && !STAN(koniec_dnia)) {
         fprintf(stderr, "\n[AWARYJNE ZAMKNIĘCIE] Sprzątanie zasobów IPC...\n");
     }
     
@@ -91,22 +104,27 @@ static void awaryjny_cleanup(void) {
 
     /* Zabij wszystkie procesy potomne */
     if (g_shm != NULL) {
-        if (g_shm->pid_kasjer > 0) kill(g_shm->pid_kasjer, SIGKILL);
-        if (g_shm->pid_pracownik1 > 0) kill(g_shm->pid_pracownik1, SIGKILL);
-        if (g_shm->pid_pracownik2 > 0) kill(g_shm->pid_pracownik2, SIGKILL);
-        if (g_shm->pid_wyciag > 0) kill(g_shm->pid_wyciag, SIGKILL);
+        if (STAN(pid_kasjer) > 0) kill(STAN(pid_kasjer), SIGKILL);
+        if (STAN(pid_pracownik1) > 0) kill(STAN(pid_pracownik1), SIGKILL);
+        if (STAN(pid_pracownik2) > 0) kill(STAN(pid_pracownik2), SIGKILL);
+        for (int i = 0; i < LINIE_MAX; i++) {
+            if (STAN(pid_wyciag[i]) > 0) kill(STAN(pid_wyciag[i]), SIGKILL);
+        }
         for (int i = 0; i < LICZBA_BRAMEK1; i++) {
-            if (g_shm->pid_bramki1[i] > 0) kill(g_shm->pid_bramki1[i], SIGKILL);
+            if (STAN(pid_bramki1[i]) > 0) kill(STAN(pid_bramki1[i]), SIGKILL);
         }
-        if (g_shm->pid_generator > 0) kill(g_shm->pid_generator, SIGKILL);
+        if (STAN(pid_generator) > 0) kill(STAN(pid_generator), SIGKILL);
+        if (STAN(pid_dziennik) > 0) kill(STAN(pid_dziennik), SIGKILL);
     }
     
     /* Zbierz zombie (WNOHANG - nie blokuj) */
     poll(NULL, 0, 200);
     while (waitpid(-1, NULL, WNOHANG) > 0);
     
-    /* Wyczyść IPC */
+    /* Wyczyść IPC (najpierw zatrzymaj wątek drenażu - czyta segment) */
     if (g_ipc_zainicjalizowane) {
+        log_przejsc_zakoncz();
+        probki_zakoncz();
         cleanup_ipc();
     }
 }
@@ -239,7 +257,99 @@ int main(int argc, char *argv[]) {
             if (m >= 0 && m != 0) g_kasjer_ticket_mask = m;
         }
     }
+
+    /* 2b. Transport komunikatów: KOLEJ_TRANSPORT=sysv|shm (domyślnie sysv) */
+    {
+        const char *env = getenv(ENV_TRANSPORT);
+        if (env && *env) {
+            if (strcmp(env, "shm") == 0) {
+                g_transport = TRANSPORT_SHM;
+            } else if (strcmp(env, "sysv") != 0) {
+                fprintf(stderr, "Nieznany %s=%s (dozwolone: sysv | shm)\n", ENV_TRANSPORT, env);
+                return EXIT_FAILURE;
+            }
+        }
+    }
+
+    /* 2c. Zegar wyciągu: KOLEJ_WYCIAG_NADRABIANIE=seria|pomin|przesun (domyślnie seria) */
+    {
+        const char *env = getenv(ENV_WYCIAG_NADRABIANIE);
+        if (env && *env) {
+            if (strcmp(env, "pomin") == 0) {
+                g_nadrabianie = NADRABIANIE_POMIN;
+            } else if (strcmp(env, "przesun") == 0) {
+                g_nadrabianie = NADRABIANIE_PRZESUN;
+            } else if (strcmp(env, "seria") != 0) {
+                fprintf(stderr, "Nieznany %s=%s (dozwolone: seria | pomin | przesun)\n", ENV_WYCIAG_NADRABIANIE, env);
+                return EXIT_FAILURE;
+            }
+        }
+    }
+
+    /* 2d. Pakowanie rzędu: KOLEJ_PAKOWANIE=zachlanna|ffd|dokladna (domyślnie zachlanna) */
+    {
+        const char *env = getenv(ENV_PAKOWANIE);
+        if (env && *env) {
+            if (strcmp(env, "ffd") == 0) {
+                g_pakowanie = PAKOWANIE_FFD;
+            } else if (strcmp(env, "dokladna") == 0) {
+                g_pakowanie = PAKOWANIE_DOKLADNA;
+            } else if (strcmp(env, "zachlanna") != 0) {
+                fprintf(stderr, "Nieznany %s=%s (dozwolone: zachlanna | ffd | dokladna)\n", ENV_PAKOWANIE, env);
+                return EXIT_FAILURE;
+            }
+        }
+    }
+
+    /* 2e. Próbkowanie kolejek / stref: KOLEJ_PROBKI_MS=odstęp (0=wyłączone) */
+    {
+        const char *env = getenv(ENV_PROBKI_MS);
+        if (env && *env) {
+            g_probki_ms = waliduj_liczbe(env, 0, PROBKI_MS_MAX);
+            if (g_probki_ms < 0) {
+                fprintf(stderr, "Nieprawidłowy %s=%s (dozwolone: 0..%d ms)\n", ENV_PROBKI_MS, env, PROBKI_MS_MAX);
+                return EXIT_FAILURE;
+            }
+        }
+    }
     
+    /* 2f. Geometria wyciągu: KOLEJ_RZEDY / KRZESLA / PERON_SLOTY / INTERWAL_MS / LINIE / POZYCJA_GORNA */
+    {
+        GeometriaWyciagu *w = &g_geometria_wyciagu;
+        geometria_wyciagu_domyslna(w);
+        const struct {
+            const char *env;
+            int *pole;
+            int min, max;
+        } parametry[] = {
+            {ENV_RZEDY,       &w->rzedy,             2, RZEDY_MAX},
+            {ENV_KRZESLA,     &w->krzesla_w_rzedzie, 1, KRZESLA_MAX},
+            {ENV_PERON_SLOTY, &w->peron_sloty,       1, PERON_SLOTY_MAX},
+            {ENV_INTERWAL_MS, &w->interwal_ms,       1, INTERWAL_MAX_MS},
+            {ENV_LINIE,       &w->linie,             1, LINIE_MAX},
+        };
+        for (size_t i = 0; i < sizeof(parametry) / sizeof(parametry[0]); i++) {
+            const char *env = getenv(parametry[i].env);
+            if (env == NULL || *env == '\0') continue;
+            *parametry[i].pole = waliduj_liczbe(env, parametry[i].min, parametry[i].max);
+            if (*parametry[i].pole < 0) {
+                fprintf(stderr, "Nieprawidłowy %s=%s (dozwolone: %d..%d)\n",
+                        parametry[i].env, env, parametry[i].min, parametry[i].max);
+                return EXIT_FAILURE;
+            }
+        }
+        /* Stacja górna domyślnie w połowie ringu (także dla zmienionej liczby rzędów) */
+        w->pozycja_gorna = w->rzedy / 2;
+        const char *env = getenv(ENV_POZYCJA_GORNA);
+        if (env && *env) {
+            w->pozycja_gorna = waliduj_liczbe(env, 1, w->rzedy - 1);
+            if (w->pozycja_gorna < 0) {
+                fprintf(stderr, "Nieprawidłowy %s=%s (dozwolone: 1..%d)\n", ENV_POZYCJA_GORNA, env, w->rzedy - 1);
+                return EXIT_FAILURE;
+            }
+        }
+    }
+
     {
         char desc[128];
         format_ticket_mask(g_kasjer_ticket_mask, desc, sizeof(desc));
@@ -247,8 +357,18 @@ int main(int argc, char *argv[]) {
               g_N, g_czas_symulacji, g_limit_utworzonych, g_limit_aktywnych, g_kasjer_ticket_mask, desc);
     }
     
-    /* 3. Inicjalizacja losowania */
-    inicjalizuj_losowanie();
+    /* 3. Inicjalizacja losowania (KOLEJ_SEED: powtarzalny ciąg klientów) */
+    {
+        const char *env = getenv(ENV_SEED);
+        if (env && *env) {
+            if (waliduj_liczbe(env, 0, INT_MAX) < 0) {
+                fprintf(stderr, "Nieprawidłowy %s=%s (dozwolone: 0..%d)\n", ENV_SEED, env, INT_MAX);
+                return EXIT_FAILURE;
+            }
+            loguj("Losowanie: %s=%s", ENV_SEED, env);
+        }
+    }
+    inicjalizuj_losowanie(LOS_SOL_MAIN);
     
     /* 3b. Nowa grupa procesów: umożliwia killpg() całej symulacji */
     if (setpgid(0, 0) == -1 && errno != EPERM) {
@@ -262,23 +382,66 @@ int main(int argc, char *argv[]) {
     /* 4a. Owner lock + ewentualny cleanup po crashu */
     owner_lock_setup_and_maybe_cleanup();
     
-    /* 5. Inicjalizacja IPC */
+    /* 5. Inicjalizacja IPC (magazyny karnetów/logów z limitu klientów) */
     loguj("Inicjalizacja zasobów IPC...");
-    if (init_ipc(g_N) != 0) {
+    GeometriaShm geo;
+    {
+        int zapas = ZAPAS_SHM_PROC;
+        const char *env = getenv(ENV_ZAPAS_SHM);
+        if (env && *env) {
+            zapas = waliduj_liczbe(env, 0, 10000);
+            if (zapas < 0) {
+                fprintf(stderr, "Nieprawidłowy %s=%s (dozwolone: 0..10000 %%)\n", ENV_ZAPAS_SHM, env);
+                return EXIT_FAILURE;
+            }
+        }
+        /* Pierścień zdarzeń tylko w trybie dziennika */
+        int pojemnosc_zdarzen = 0;
+        const char *env_dz = getenv(ENV_LOG_DZIENNIK);
+        if (env_dz != NULL && strcmp(env_dz, "1") == 0) {
+            pojemnosc_zdarzen = DZIENNIK_POJEMNOSC;
+        }
+        geometria_shm_oblicz(&geo, g_limit_utworzonych, zapas, pojemnosc_zdarzen);
+    }
+    if (init_ipc(g_N, g_transport, &geo, &g_geometria_wyciagu) != 0) {
         fprintf(stderr, "BŁĄD: Nie udało się zainicjalizować IPC!\n");
         return EXIT_FAILURE;
     }
     g_ipc_zainicjalizowane = 1;
+
+    /* 5-. Tryb kontroli liczników stref: KOLEJ_KONTROLA_OBECNOSCI=1 (diagnostyka) */
+    {
+        const char *env = getenv(ENV_KONTROLA_OBECNOSCI);
+        if (env && strcmp(env, "1") == 0) {
+            obecnosc_wlacz_kontrole();
+            loguj("Kontrola niezmienników obecności: WŁĄCZONA");
+        }
+    }
     
     /* 5a. Ustaw czas końca dnia (karnet ucięty do tego czasu) */
-    g_shm->czas_konca_dnia = g_shm->czas_startu + g_czas_symulacji;
-    g_shm->faza_dnia = FAZA_OPEN;
+    stan_zapis_poczatek();
+    STAN_USTAW(koniec_dnia_ns, g_shm->kotwica.mono_ns + (long long)g_czas_symulacji * NS_NA_SEK);
+    STAN_USTAW(faza_dnia, FAZA_OPEN);
+    stan_zapis_koniec();
     g_shm->aktywni_klienci = 0;
-    loguj("Czas końca dnia: %ld (za %d sekund)", 
-          (long)g_shm->czas_konca_dnia, g_czas_symulacji);
+    g_shm->zegar_wyciagu.tryb = g_nadrabianie;
+    g_shm->pakowanie.polityka = g_pakowanie;
+    {
+        char koniec_buf[24];
+        czas_formatuj_ms(STAN(koniec_dnia_ns), koniec_buf, sizeof(koniec_buf));
+        loguj("Czas końca dnia: %s (za %d sekund)", koniec_buf, g_czas_symulacji);
+    }
 
     /* 5aa. Przygotuj pliki logów live (podział na terminale) */
     przygotuj_pliki_logow();
+
+    /* 5ab. Log przejść: wątek drenujący pierścień do PLIK_LOG przez cały dzień */
+    log_przejsc_start(PLIK_LOG);
+
+    /* 5ac. Próbkowanie kolejek / semaforów / stref (szereg do PLIK_PROBKI) */
+    if (g_probki_ms > 0) {
+        probki_start(PLIK_PROBKI, g_probki_ms);
+    }
     
     /* 5b. Uruchom strażnika: posprząta IPC nawet po SIGKILL main */
     start_sprzatacz();
@@ -287,6 +450,8 @@ int main(int argc, char *argv[]) {
     loguj("Uruchamianie procesów stałych...");
     if (uruchom_procesy_stale() != 0) {
         fprintf(stderr, "BŁĄD: Nie udało się uruchomić procesów!\n");
+        log_przejsc_zakoncz();
+        probki_zakoncz();
         cleanup_ipc();
         return EXIT_FAILURE;
     }
@@ -363,19 +528,21 @@ static void instaluj_handlery_sygnalow(void) {
 static void handler_sigint(int sig) {
     (void)sig;
     g_zamykanie = 1;
-    /* Bezpiecznie zapisz do shm */
-    if (g_shm != NULL) {
-        g_shm->koniec_dnia = 1;
-        g_shm->faza_dnia = FAZA_CLOSING;
+    /* Bezpiecznie zapisz do shm (zajęta sekcja = main właśnie pisze, CLOSING i tak nastąpi) */
+    if (g_shm != NULL && stan_zapis_sprobuj() == 0) {
+        STAN_USTAW(koniec_dnia, 1);
+        STAN_USTAW(faza_dnia, FAZA_CLOSING);
+        stan_zapis_koniec();
     }
 }
 
 static void handler_sigterm(int sig) {
     (void)sig;
     g_zamykanie = 1;
-    if (g_shm != NULL) {
-        g_shm->koniec_dnia = 1;
-        g_shm->faza_dnia = FAZA_CLOSING;
+    if (g_shm != NULL && stan_zapis_sprobuj() == 0) {
+        STAN_USTAW(koniec_dnia, 1);
+        STAN_USTAW(faza_dnia, FAZA_CLOSING);
+        stan_zapis_koniec();
     }
 }
 
@@ -388,12 +555,12 @@ static void handler_sigusr1(int sig) {
     }
 
     /* Jeśli awaria już aktywna, nie dubluj */
-    if (g_shm->awaria) {
+    if (STAN(awaria)) {
         return;
     }
 
     /* Wymaganie: zatrzymuje PRACOWNIK (nie main). Domyślnie P1, fallback P2. */
-    pid_t target = (g_shm->pid_pracownik1 > 0) ? g_shm->pid_pracownik1 : g_shm->pid_pracownik2;
+    pid_t target = (STAN(pid_pracownik1) > 0) ? STAN(pid_pracownik1) : STAN(pid_pracownik2);
     if (target > 0) {
         kill(target, SIGUSR1);
     }
@@ -407,14 +574,14 @@ static void handler_sigusr2(int sig) {
         return;
     }
 
-    if (!g_shm->awaria) {
+    if (!STAN(awaria)) {
         return;
     }
 
     /* Wymaganie: wznawia pracownik, który zatrzymał */
-    pid_t target = g_shm->pid_awaria_inicjator;
+    pid_t target = STAN(pid_awaria_inicjator);
     if (target <= 0) {
-        target = (g_shm->pid_pracownik1 > 0) ? g_shm->pid_pracownik1 : g_shm->pid_pracownik2;
+        target = (STAN(pid_pracownik1) > 0) ? STAN(pid_pracownik1) : STAN(pid_pracownik2);
     }
 
     if (target > 0) {
@@ -450,15 +617,18 @@ static void start_sprzatacz(void) {
 static int pid_jest_procesem_stalym(pid_t pid) {
     if (g_shm == NULL || pid <= 0) return 0;
 
-    if (pid == g_shm->pid_kasjer) return 1;
-    if (pid == g_shm->pid_generator) return 1;
-    if (pid == g_shm->pid_pracownik1) return 1;
-    if (pid == g_shm->pid_pracownik2) return 1;
-    if (pid == g_shm->pid_wyciag) return 1;
+    if (pid == STAN(pid_kasjer)) return 1;
+    if (pid == STAN(pid_generator)) return 1;
+    if (pid == STAN(pid_pracownik1)) return 1;
+    if (pid == STAN(pid_pracownik2)) return 1;
     if (pid == g_pid_sprzatacz) return 1;
 
+    for (int i = 0; i < LINIE_MAX; i++) {
+        if (pid == STAN(pid_wyciag[i])) return 1;
+    }
+
     for (int i = 0; i < LICZBA_BRAMEK1; i++) {
-        if (pid == g_shm->pid_bramki1[i]) return 1;
+        if (pid == STAN(pid_bramki1[i])) return 1;
     }
     return 0;
 }
@@ -468,14 +638,17 @@ static void panic_shutdown(const char *powod, pid_t pid, int kod, int przez_sygn
     g_zamykanie = 1;
 
     if (g_shm != NULL) {
-        g_shm->panic = 1;
-        g_shm->panic_pid = pid;
-        g_shm->panic_sig = przez_sygnal ? kod : 0;
-        g_shm->faza_dnia = FAZA_CLOSING;
-        g_shm->koniec_dnia = 1;
-        g_shm->czas_konca_dnia = time(NULL);
-        g_shm->kolej_aktywna = 0;
-        g_shm->awaria = 0;
+        long long teraz = czas_mono_ns();
+        stan_zapis_poczatek();
+        STAN_USTAW(panic, 1);
+        STAN_USTAW(panic_pid, pid);
+        STAN_USTAW(panic_sig, przez_sygnal ? kod : 0);
+        STAN_USTAW(faza_dnia, FAZA_CLOSING);
+        STAN_USTAW(koniec_dnia, 1);
+        STAN_USTAW(koniec_dnia_ns, teraz);
+        STAN_USTAW(kolej_aktywna, 0);
+        STAN_USTAW(awaria, 0);
+        stan_zapis_koniec();
     }
 
     if (przez_sygnal) {
@@ -497,10 +670,13 @@ static void panic_shutdown(const char *powod, pid_t pid, int kod, int przez_sygn
 
     if (!g_cleanup_wykonany && g_ipc_zainicjalizowane) {
         g_cleanup_wykonany = 1;
+        log_przejsc_zakoncz();
+        probki_zakoncz();
         cleanup_ipc();
         g_ipc_zainicjalizowane = 0;
     }
 
+    loguj_oproznij();
     _exit(EXIT_FAILURE);
 }
 
@@ -512,8 +688,19 @@ static void reap_children_and_check(void) {
     pid_t pid;
 
     while ((pid = waitpid(-1, &status, WNOHANG)) > 0) {
+        /* Dziennik nie jest krytyczny: bez niego zdarzenia idą przez loguj() */
+        if (g_shm != NULL && pid == STAN(pid_dziennik)) {
+            __atomic_store_n(&g_shm->dziennik_aktywny, 0, __ATOMIC_RELEASE);
+            zapisz_pid(&g_shm->stan.pid_dziennik, 0);
+            if (!STAN(koniec_dnia) && !g_zamykanie) {
+                loguj("UWAGA: dziennik (PID=%d) zakończył się - zdarzenia idą bezpośrednio do plików",
+                      (int)pid);
+            }
+            continue;
+        }
+
         /* Jeśli trwa normalne zamykanie, ignoruj zakończenia */
-        if (g_shm != NULL && (g_shm->koniec_dnia || g_shm->faza_dnia != FAZA_OPEN || g_zamykanie)) {
+        if (g_shm != NULL && (STAN(koniec_dnia) || STAN(faza_dnia) != FAZA_OPEN || g_zamykanie)) {
             continue;
         }
 
@@ -602,47 +789,72 @@ static pid_t fork_exec(const char *program, char *const argv[], const char *log_
     return pid;
 }
 
+/* Publikuje PID procesu stałego w stanie globalnym */
+static void zapisz_pid(pid_t *pole, pid_t pid) {
+    stan_zapis_poczatek();
+    __atomic_store_n(pole, pid, __ATOMIC_RELAXED);
+    stan_zapis_koniec();
+}
+
 static int uruchom_procesy_stale(void) {
     char arg_klucz[32];
     snprintf(arg_klucz, sizeof(arg_klucz), "%d", g_N);
+
+    /* Dziennik pierwszy: opróżnia pierścień zdarzeń, zanim ktoś zacznie logować */
+    if (g_shm->geometria.pojemnosc_zdarzen > 0) {
+        char *argv_dz[] = {PATH_DZIENNIK, NULL};
+        zapisz_pid(&g_shm->stan.pid_dziennik, fork_exec(PATH_DZIENNIK, argv_dz, NULL));
+        if (STAN(pid_dziennik) == -1) {
+            zapisz_pid(&g_shm->stan.pid_dziennik, 0);
+            loguj("UWAGA: nie udało się uruchomić dziennika - zdarzenia idą bezpośrednio do plików");
+        } else {
+            loguj("Dziennik uruchomiony (PID=%d, pierścień=%d zdarzeń)",
+                  STAN(pid_dziennik), g_shm->geometria.pojemnosc_zdarzen);
+        }
+    }
     
     /* Kasjer (opcjonalnie: maska dozwolonych typów karnetów) */
     char arg_karnety_mask[16];
     snprintf(arg_karnety_mask, sizeof(arg_karnety_mask), "%d", g_kasjer_ticket_mask);
     char *argv_kasjer[] = {PATH_KASJER, arg_karnety_mask, NULL};
-    g_shm->pid_kasjer = fork_exec(PATH_KASJER, argv_kasjer, "output/kasa.log");
-    if (g_shm->pid_kasjer == -1) {
+    zapisz_pid(&g_shm->stan.pid_kasjer, fork_exec(PATH_KASJER, argv_kasjer, "output/kasa.log"));
+    if (STAN(pid_kasjer) == -1) {
         loguj("BŁĄD: Nie udało się uruchomić kasjera");
         /* Kontynuuj bez kasjera dla testów */
     } else {
-        loguj("Kasjer uruchomiony (PID=%d)", g_shm->pid_kasjer);
+        loguj("Kasjer uruchomiony (PID=%d)", STAN(pid_kasjer));
     }
     
     /* Pracownik1 */
     char *argv_p1[] = {PATH_PRACOWNIK1, NULL};
-    g_shm->pid_pracownik1 = fork_exec(PATH_PRACOWNIK1, argv_p1, "output/pracownicy.log");
-    if (g_shm->pid_pracownik1 == -1) {
+    zapisz_pid(&g_shm->stan.pid_pracownik1, fork_exec(PATH_PRACOWNIK1, argv_p1, "output/pracownicy.log"));
+    if (STAN(pid_pracownik1) == -1) {
         loguj("BŁĄD: Nie udało się uruchomić pracownika1");
     } else {
-        loguj("Pracownik1 uruchomiony (PID=%d)", g_shm->pid_pracownik1);
+        loguj("Pracownik1 uruchomiony (PID=%d)", STAN(pid_pracownik1));
     }
     
     /* Pracownik2 */
     char *argv_p2[] = {PATH_PRACOWNIK2, NULL};
-    g_shm->pid_pracownik2 = fork_exec(PATH_PRACOWNIK2, argv_p2, "output/pracownicy.log");
-    if (g_shm->pid_pracownik2 == -1) {
+    zapisz_pid(&g_shm->stan.pid_pracownik2, fork_exec(PATH_PRACOWNIK2, argv_p2, "output/pracownicy.log"));
+    if (STAN(pid_pracownik2) == -1) {
         loguj("BŁĄD: Nie udało się uruchomić pracownika2");
     } else {
-        loguj("Pracownik2 uruchomiony (PID=%d)", g_shm->pid_pracownik2);
+        loguj("Pracownik2 uruchomiony (PID=%d)", STAN(pid_pracownik2));
     }
     
-    /* Wyciąg */
-    char *argv_wyciag[] = {PATH_WYCIAG, NULL};
-    g_shm->pid_wyciag = fork_exec(PATH_WYCIAG, argv_wyciag, "output/wyciag.log");
-    if (g_shm->pid_wyciag == -1) {
-        loguj("BŁĄD: Nie udało się uruchomić wyciągu");
-    } else {
-        loguj("Wyciąg uruchomiony (PID=%d)", g_shm->pid_wyciag);
+    /* Wyciąg - jeden proces na linię (numer linii = mtype jego kanału wyciag_req) */
+    for (int i = 0; i < g_geometria_wyciagu.linie; i++) {
+        char arg_linia[16];
+        snprintf(arg_linia, sizeof(arg_linia), "%d", i + 1);
+        char *argv_wyciag[] = {PATH_WYCIAG, arg_linia, NULL};
+
+        zapisz_pid(&g_shm->stan.pid_wyciag[i], fork_exec(PATH_WYCIAG, argv_wyciag, "output/wyciag.log"));
+        if (STAN(pid_wyciag[i]) == -1) {
+            loguj("BŁĄD: Nie udało się uruchomić wyciągu linii %d", i + 1);
+        } else {
+            loguj("Wyciąg uruchomiony (PID=%d) - linia %d/%d", STAN(pid_wyciag[i]), i + 1, g_geometria_wyciagu.linie);
+        }
     }
     
     /* Bramki (4 sztuki) */
@@ -651,11 +863,11 @@ static int uruchom_procesy_stale(void) {
         snprintf(arg_numer, sizeof(arg_numer), "%d", i + 1);
         char *argv_bramka[] = {PATH_BRAMKA, arg_numer, NULL};
         
-        g_shm->pid_bramki1[i] = fork_exec(PATH_BRAMKA, argv_bramka, "output/bramki.log");
-        if (g_shm->pid_bramki1[i] == -1) {
+        zapisz_pid(&g_shm->stan.pid_bramki1[i], fork_exec(PATH_BRAMKA, argv_bramka, "output/bramki.log"));
+        if (STAN(pid_bramki1[i]) == -1) {
             loguj("BŁĄD: Nie udało się uruchomić bramki %d", i + 1);
         } else {
-            loguj("Bramka %d uruchomiona (PID=%d)", i + 1, g_shm->pid_bramki1[i]);
+            loguj("Bramka %d uruchomiona (PID=%d)", i + 1, STAN(pid_bramki1[i]));
         }
     }
     
@@ -668,11 +880,11 @@ static int uruchom_procesy_stale(void) {
     snprintf(arg_limit_akt, sizeof(arg_limit_akt), "%d", g_limit_aktywnych);
     char *argv_gen[] = {PATH_GENERATOR, arg_czas, arg_limit_utw, arg_limit_akt, NULL};
     
-    g_shm->pid_generator = fork_exec(PATH_GENERATOR, argv_gen, "output/generator.log");
-    if (g_shm->pid_generator == -1) {
+    zapisz_pid(&g_shm->stan.pid_generator, fork_exec(PATH_GENERATOR, argv_gen, "output/generator.log"));
+    if (STAN(pid_generator) == -1) {
         loguj("BŁĄD: Nie udało się uruchomić generatora");
     } else {
-        loguj("Generator uruchomiony (PID=%d)", g_shm->pid_generator);
+        loguj("Generator uruchomiony (PID=%d)", STAN(pid_generator));
     }
     
     loguj("Wszystkie procesy stałe uruchomione");
@@ -684,56 +896,69 @@ static int uruchom_procesy_stale(void) {
  * ============================================ */
 
 static void petla_glowna(void) {
-    /* Używamy czasu absolutnego końca dnia (czas_konca_dnia), bo jest
+    /* Używamy monotonicznego końca dnia (koniec_dnia_ns), bo jest
      * współdzielony i jednoznaczny. Dzięki temu unikamy "od razu CLOSING"
-     * przy ewentualnych problemach z czas_startu / starym SHM. */
-    time_t czas_startu = g_shm->czas_startu;
-    time_t czas_konca  = g_shm->czas_konca_dnia;
+     * przy ewentualnych problemach z kotwicą / starym SHM. */
+    long long czas_startu = g_shm->kotwica.mono_ns;
+    long long czas_konca  = STAN(koniec_dnia_ns);
     int ostatni_raport = 0;
 
-    time_t now = time(NULL);
+    long long now = czas_mono_ns();
     if (czas_startu <= 0 || czas_startu > now) {
-        czas_startu = now;
         MUTEX_SHM_LOCK();
-        g_shm->czas_startu = czas_startu;
+        czas_kotwica_ustaw(&g_shm->kotwica);
+        czas_startu = g_shm->kotwica.mono_ns;
         MUTEX_SHM_UNLOCK();
     }
     if (czas_konca <= czas_startu) {
-        czas_konca = czas_startu + g_czas_symulacji;
-        MUTEX_SHM_LOCK();
-        g_shm->czas_konca_dnia = czas_konca;
-        MUTEX_SHM_UNLOCK();
+        czas_konca = czas_startu + (long long)g_czas_symulacji * NS_NA_SEK;
+        stan_zapis_poczatek();
+        STAN_USTAW(koniec_dnia_ns, czas_konca);
+        stan_zapis_koniec();
     }
     
     while (!g_zamykanie) {
         /* Sprawdź czy czas symulacji minął — PRZED reapem, żeby uniknąć fałszywego panic */
-        now = time(NULL);
-        int czas_uplynal = (int)(now - czas_startu);
+        now = czas_mono_ns();
+        int czas_uplynal = (int)((now - czas_startu) / NS_NA_SEK);
 
         if (now >= czas_konca || czas_uplynal >= g_czas_symulacji) {
             loguj("Czas symulacji (%d sek) upłynął (elapsed=%d)", g_czas_symulacji, czas_uplynal);
-            g_shm->koniec_dnia = 1;
-            g_shm->faza_dnia = FAZA_CLOSING;
+            stan_zapis_poczatek();
+            STAN_USTAW(koniec_dnia, 1);
+            STAN_USTAW(faza_dnia, FAZA_CLOSING);
+            stan_zapis_koniec();
             break;
         }
 
         /* Monitoruj dzieci — po sprawdzeniu czasu */
         reap_children_and_check();
-        if (g_shm != NULL && g_shm->panic && !g_shm->koniec_dnia && g_shm->faza_dnia == FAZA_OPEN) {
-            panic_shutdown("PANIC (zgłoszone przez proces potomny)", g_shm->panic_pid, g_shm->panic_sig, 1);
+        if (g_shm != NULL && STAN(panic)) {
+            StanGlobalny st;
+            stan_odczytaj(&st);
+            if (!st.koniec_dnia && st.faza_dnia == FAZA_OPEN) {
+                panic_shutdown("PANIC (zgłoszone przez proces potomny)", st.panic_pid, st.panic_sig, 1);
+            }
         }
         
         /* Raport co 30 sekund */
         if (czas_uplynal - ostatni_raport >= 30) {
             ostatni_raport = czas_uplynal;
+            Statystyki stats;
+            StanObecnosci ob;
+            statystyki_zsumuj(&stats);
+            obecnosc_odczytaj(&ob);
             loguj("Status: czas=%d/%d, teren=%d, góra=%d, klienci=%d, przychód=%.2f zł",
                   czas_uplynal, g_czas_symulacji,
-                  g_shm->osoby_na_terenie,
-                  g_shm->osoby_na_gorze,
-                  g_shm->stats.laczna_liczba_klientow,
-                  g_shm->stats.przychod_gr / 100.0);
+                  ob.teren,
+                  ob.gora,
+                  stats.laczna_liczba_klientow,
+                  stats.przychod_gr / 100.0);
         }
         
+        /* Tryb ENV_LOG_BUFOR: nie trzymaj wierszy main dłużej niż jeden tick */
+        loguj_oproznij();
+
         /* Krótkie czekanie (poll zamiast busy-wait) */
         poll(NULL, 0, 100);  /* 100ms */
     }
@@ -751,31 +976,32 @@ static void procedura_konca_dnia(void) {
      * - Nie wpuszczamy nowych
      * - Generator przestaje generować
      * - Kasjer odmawia
-     * - Karnety "umierają" o czas_konca_dnia
+     * - Karnety "umierają" o koniec_dnia_ns
      * ========================================== */
     loguj("FAZA 1: CLOSING - nie wpuszczamy nowych klientów");
     
-    MUTEX_SHM_LOCK();
-    g_shm->faza_dnia = FAZA_CLOSING;
-    g_shm->koniec_dnia = 1;  /* LEGACY - dla kompatybilności */
+    long long teraz = czas_mono_ns();
+    stan_zapis_poczatek();
+    STAN_USTAW(faza_dnia, FAZA_CLOSING);
+    STAN_USTAW(koniec_dnia, 1);  /* LEGACY - dla kompatybilności */
     
-    /* Ustaw czas_konca_dnia jeśli jeszcze nie ustawiony */
-    if (g_shm->czas_konca_dnia == 0) {
-        g_shm->czas_konca_dnia = time(NULL);
+    /* Ustaw koniec_dnia_ns jeśli jeszcze nie ustawiony */
+    if (STAN(koniec_dnia_ns) == 0) {
+        STAN_USTAW(koniec_dnia_ns, teraz);
     }
-    MUTEX_SHM_UNLOCK();
+    stan_zapis_koniec();
     
     loguj("  faza_dnia = CLOSING");
-    loguj("  czas_konca_dnia = %ld", (long)g_shm->czas_konca_dnia);
+    loguj("  koniec_dnia_ns = %lld", STAN(koniec_dnia_ns));
     loguj("  aktywni_klienci = %d", g_shm->aktywni_klienci);
 
     /* Jeśli kończymy dzień podczas awarii, część procesów (klienci/bramki)
      * może wisieć na SEM_BARIERA_AWARIA. Na koniec dnia chcemy je wypuścić,
      * żeby mogły dokończyć cleanup i wyjść. */
     g_awaria = 0;
-    MUTEX_SHM_LOCK();
-    g_shm->awaria = 0;
-    MUTEX_SHM_UNLOCK();
+    stan_zapis_poczatek();
+    STAN_USTAW(awaria, 0);
+    stan_zapis_koniec();
     odblokuj_czekajacych();
     
     /* NIE zabijaj generatora! Generator sam:
@@ -801,31 +1027,33 @@ static void procedura_konca_dnia(void) {
      * ========================================== */
     loguj("FAZA 2: DRAINING - kończymy transport z peronu (czekam na wyciąg)");
     
-    MUTEX_SHM_LOCK();
-    g_shm->faza_dnia = FAZA_DRAINING;
-    MUTEX_SHM_UNLOCK();
+    stan_zapis_poczatek();
+    STAN_USTAW(faza_dnia, FAZA_DRAINING);
+    stan_zapis_koniec();
     
-    /* Czekaj na zakończenie WYCIĄGU (z timeout).
+    /* Czekaj na zakończenie WYCIĄGÓW wszystkich linii (wspólny timeout).
      * Wyciąg kończy się dopiero gdy przewiezie wszystkich z peronu + odczeka 3s. */
-    if (g_shm->pid_wyciag > 0) {
-        loguj("  Czekam na wyciąg (PID %d)...", g_shm->pid_wyciag);
-        int timeout_ms = 60000; /* 60s na drenowanie + 3s (duży zapas) */
+    int timeout_ms = 60000; /* 60s na drenowanie + 3s (duży zapas) */
+    for (int i = 0; i < LINIE_MAX; i++) {
+        pid_t pid = STAN(pid_wyciag[i]);
+        if (pid <= 0) continue;
+        loguj("  Czekam na wyciąg linii %d (PID %d)...", i + 1, pid);
         pid_t ret = 0;
         int status;
         while (timeout_ms > 0) {
-            ret = waitpid(g_shm->pid_wyciag, &status, WNOHANG);
+            ret = waitpid(pid, &status, WNOHANG);
             if (ret > 0 || (ret == -1 && errno != EINTR)) break;
             poll(NULL, 0, 100);
             timeout_ms -= 100;
         }
         if (ret > 0) {
-            loguj("  Wyciąg zakończył drenowanie i wyłączył się");
+            loguj("  Wyciąg linii %d zakończył drenowanie i wyłączył się", i + 1);
         } else {
-            loguj("  Wyciąg nie zakończył się w czasie - wymuszam");
-            kill(g_shm->pid_wyciag, SIGKILL);
-            waitpid(g_shm->pid_wyciag, NULL, WNOHANG);
+            loguj("  Wyciąg linii %d nie zakończył się w czasie - wymuszam", i + 1);
+            kill(pid, SIGKILL);
+            waitpid(pid, NULL, WNOHANG);
         }
-        g_shm->pid_wyciag = 0;
+        zapisz_pid(&g_shm->stan.pid_wyciag[i], 0);
     }
     
     /* ==========================================
@@ -835,10 +1063,15 @@ static void procedura_konca_dnia(void) {
      * ========================================== */
     loguj("FAZA 3: SHUTDOWN - zamykanie procesów");
     
-    g_shm->kolej_aktywna = 0;
+    stan_zapis_poczatek();
+    STAN_USTAW(kolej_aktywna, 0);
+    stan_zapis_koniec();
     loguj("  Kolej zatrzymana");
     
     zakoncz_procesy_potomne();
+
+    /* Wszyscy wyszli? (loguje tylko w trybie kontroli obecności) */
+    obecnosc_bilans_koncowy();
     
     loguj("=== PROCEDURA KOŃCA DNIA ZAKOŃCZONA ===");
 }
@@ -855,25 +1088,31 @@ static void zakoncz_procesy_potomne(void) {
     }
 
     /* Wyślij SIGTERM do wszystkich procesów stałych */
-    if (g_shm->pid_kasjer > 0) {
-        kill(g_shm->pid_kasjer, SIGTERM);
+    if (STAN(pid_kasjer) > 0) {
+        kill(STAN(pid_kasjer), SIGTERM);
     }
-    if (g_shm->pid_pracownik1 > 0) {
-        kill(g_shm->pid_pracownik1, SIGTERM);
+    if (STAN(pid_pracownik1) > 0) {
+        kill(STAN(pid_pracownik1), SIGTERM);
     }
-    if (g_shm->pid_pracownik2 > 0) {
-        kill(g_shm->pid_pracownik2, SIGTERM);
+    if (STAN(pid_pracownik2) > 0) {
+        kill(STAN(pid_pracownik2), SIGTERM);
     }
-    if (g_shm->pid_wyciag > 0) {
-        kill(g_shm->pid_wyciag, SIGTERM);
+    for (int i = 0; i < LINIE_MAX; i++) {
+        if (STAN(pid_wyciag[i]) > 0) {
+            kill(STAN(pid_wyciag[i]), SIGTERM);
+        }
     }
     for (int i = 0; i < LICZBA_BRAMEK1; i++) {
-        if (g_shm->pid_bramki1[i] > 0) {
-            kill(g_shm->pid_bramki1[i], SIGTERM);
+        if (STAN(pid_bramki1[i]) > 0) {
+            kill(STAN(pid_bramki1[i]), SIGTERM);
         }
     }
-    if (g_shm->pid_generator > 0) {
-        kill(g_shm->pid_generator, SIGTERM);
+    if (STAN(pid_generator) > 0) {
+        kill(STAN(pid_generator), SIGTERM);
+    }
+    /* Dziennik dostaje SIGTERM razem z resztą, ale kończy dopiero po opróżnieniu pierścienia */
+    if (STAN(pid_dziennik) > 0) {
+        kill(STAN(pid_dziennik), SIGTERM);
     }
     
     /* Czekaj na zakończenie dzieci z timeout */
@@ -904,6 +1143,7 @@ if (wait_ms <= 0) {
         /* brak sprzątacza → best-effort: sprzątnij IPC po kluczach */
         cleanup_ipc_by_keys();
     }
+    loguj_oproznij();
     _exit(EXIT_FAILURE);
 }
 
@@ -934,6 +1174,15 @@ static void generuj_raport_koncowy(void) {
         /* Wypisz na stdout */
         f = stdout;
     }
+
+    Statystyki stats;
+    statystyki_zsumuj(&stats);
+
+    /* Log przejść jest już na dysku - dobierz resztę pierścienia i zamknij plik */
+    unsigned long wpisy_logu = log_przejsc_zakoncz();
+    long probki = probki_zakoncz();
+    int logi_opoznione = __atomic_load_n(&g_shm->logi_opoznione, __ATOMIC_RELAXED);
+    int logi_zgubione = __atomic_load_n(&g_shm->logi_zgubione, __ATOMIC_RELAXED);
     
     fprintf(f, "========================================\n");
     fprintf(f, "    RAPORT DZIENNY - KOLEJ KRZESEŁKOWA\n");
@@ -941,48 +1190,69 @@ static void generuj_raport_koncowy(void) {
     
     /* Czas */
     char czas_buf[20];
-    formatuj_czas(g_shm->czas_startu, czas_buf);
+    long long koniec_ns = czas_mono_ns();
+    formatuj_czas(czas_na_sciany_sek(g_shm->kotwica.mono_ns), czas_buf);
     fprintf(f, "Czas rozpoczęcia:    %s\n", czas_buf);
-    formatuj_czas(time(NULL), czas_buf);
+    formatuj_czas(czas_na_sciany_sek(koniec_ns), czas_buf);
     fprintf(f, "Czas zakończenia:    %s\n", czas_buf);
-    fprintf(f, "Czas trwania:        %ld sekund\n\n", 
-            time(NULL) - g_shm->czas_startu);
+    fprintf(f, "Czas trwania:        %.3f sekund\n\n",
+            (double)(koniec_ns - g_shm->kotwica.mono_ns) / NS_NA_SEK);
     
     /* Statystyki klientów */
     fprintf(f, "--- KLIENCI ---\n");
-    fprintf(f, "Łączna liczba klientów: %d\n", g_shm->stats.laczna_liczba_klientow);
-    fprintf(f, "  - Piesi:              %d\n", g_shm->stats.liczba_pieszych);
-    fprintf(f, "  - Rowerzyści:         %d\n", g_shm->stats.liczba_rowerzystow);
-    fprintf(f, "  - VIP:                %d\n", g_shm->stats.liczba_vip);
-    fprintf(f, "  - Grupy rodzinne:     %d\n", g_shm->stats.liczba_grup_rodzinnych);
+    fprintf(f, "Łączna liczba klientów: %d\n", stats.laczna_liczba_klientow);
+    fprintf(f, "  - Piesi:              %d\n", stats.liczba_pieszych);
+    fprintf(f, "  - Rowerzyści:         %d\n", stats.liczba_rowerzystow);
+    fprintf(f, "  - VIP:                %d\n", stats.liczba_vip);
+    fprintf(f, "  - Grupy rodzinne:     %d\n", stats.liczba_grup_rodzinnych);
     fprintf(f, "  - Dzieci odrzucone:   %d (bez opiekuna)\n\n", 
-            g_shm->stats.liczba_dzieci_odrzuconych);
+            stats.liczba_dzieci_odrzuconych);
     
     /* Statystyki karnetów */
     fprintf(f, "--- KARNETY ---\n");
-    fprintf(f, "Jednorazowe:     %d\n", g_shm->stats.sprzedane_karnety[0]);
-    fprintf(f, "TK1 (30min):     %d\n", g_shm->stats.sprzedane_karnety[1]);
-    fprintf(f, "TK2 (60min):     %d\n", g_shm->stats.sprzedane_karnety[2]);
-    fprintf(f, "TK3 (120min):    %d\n", g_shm->stats.sprzedane_karnety[3]);
-    fprintf(f, "Dzienne:         %d\n\n", g_shm->stats.sprzedane_karnety[4]);
+    fprintf(f, "Jednorazowe:     %d\n", stats.sprzedane_karnety[0]);
+    fprintf(f, "TK1 (30min):     %d\n", stats.sprzedane_karnety[1]);
+    fprintf(f, "TK2 (60min):     %d\n", stats.sprzedane_karnety[2]);
+    fprintf(f, "TK3 (120min):    %d\n", stats.sprzedane_karnety[3]);
+    fprintf(f, "Dzienne:         %d\n\n", stats.sprzedane_karnety[4]);
     
     /* Przychód */
     char kwota_buf[20];
-    formatuj_kwote(g_shm->stats.przychod_gr, kwota_buf);
+    formatuj_kwote(stats.przychod_gr, kwota_buf);
     fprintf(f, "--- PRZYCHÓD ---\n");
     fprintf(f, "Łączny przychód: %s\n\n", kwota_buf);
     
     /* Trasy */
     fprintf(f, "--- TRASY ---\n");
-    fprintf(f, "T1 (rower łatwa):    %d\n", g_shm->stats.uzycia_tras[0]);
-    fprintf(f, "T2 (rower średnia):  %d\n", g_shm->stats.uzycia_tras[1]);
-    fprintf(f, "T3 (rower trudna):   %d\n", g_shm->stats.uzycia_tras[2]);
-    fprintf(f, "T4 (piesza):         %d\n\n", g_shm->stats.uzycia_tras[3]);
+    fprintf(f, "T1 (rower łatwa):    %d\n", stats.uzycia_tras[0]);
+    fprintf(f, "T2 (rower średnia):  %d\n", stats.uzycia_tras[1]);
+    fprintf(f, "T3 (rower trudna):   %d\n", stats.uzycia_tras[2]);
+    fprintf(f, "T4 (piesza):         %d\n\n", stats.uzycia_tras[3]);
     
     /* Liczba przejazdów i awarii */
     fprintf(f, "--- OPERACJE ---\n");
-    fprintf(f, "Liczba przejazdów:   %d\n", g_shm->stats.liczba_przejazdow);
-    fprintf(f, "Liczba zatrzymań:    %d\n\n", g_shm->stats.liczba_zatrzyman);
+    fprintf(f, "Liczba przejazdów:   %d\n", stats.liczba_przejazdow);
+    fprintf(f, "Liczba zatrzymań:    %d\n", stats.liczba_zatrzyman);
+    fprintf(f, "Wpisy logu przejść:  %lu (opóźnione=%d, zgubione=%d)\n\n",
+            wpisy_logu, logi_opoznione, logi_zgubione);
+
+    /* Gdzie klient traci czas */
+    fprintf(f, "--- CZASY ETAPÓW (ms) ---\n");
+    histogramy_wypisz(f);
+    fprintf(f, "\n");
+
+    /* Przepustowość wyciągu zależy od tego, czy ticki trzymają tempo */
+    fprintf(f, "--- ZEGAR WYCIĄGU ---\n");
+    zegar_wyciagu_wypisz(f);
+    fprintf(f, "\n");
+
+    fprintf(f, "--- PAKOWANIE RZĘDÓW ---\n");
+    pakowanie_wypisz(f);
+    fprintf(f, "\n");
+
+    fprintf(f, "--- LINIE WYCIĄGU ---\n");
+    linie_wypisz(f);
+    fprintf(f, "\n");
     
     fprintf(f, "========================================\n");
     fprintf(f, "         KONIEC RAPORTU\n");
@@ -993,25 +1263,12 @@ static void generuj_raport_koncowy(void) {
         loguj("Raport zapisany do: %s", PLIK_RAPORT);
     }
     
-    /* Zapisz logi przejść */
-    FILE *flog = fopen(PLIK_LOG, "w");
-    if (flog != NULL) {
-        fprintf(flog, "ID_KARNETU;TYP_BRAMKI;NR_BRAMKI;CZAS\n");
-        for (int i = 0; i < g_shm->liczba_logow; i++) {
-            LogEntry *log = &g_shm->logi[i];
-            const char *typ_str;
-            switch (log->typ_bramki) {
-                case LOG_BRAMKA1: typ_str = "BRAMKA1"; break;
-                case LOG_BRAMKA2: typ_str = "BRAMKA2"; break;
-                case LOG_WYJSCIE_GORA: typ_str = "WYJSCIE_GORA"; break;
-                default: typ_str = "NIEZNANY"; break;
-            }
-            formatuj_czas(log->czas, czas_buf);
-            fprintf(flog, "%d;%s;%d;%s\n",
-                    log->id_karnetu, typ_str, log->numer_bramki, czas_buf);
-        }
-        fclose(flog);
-        loguj("Log przejść zapisany do: %s (%d wpisów)", 
-              PLIK_LOG, g_shm->liczba_logow);
+    loguj("Log przejść zapisany do: %s (%lu wpisów)", PLIK_LOG, wpisy_logu);
+    if (logi_opoznione > 0 || logi_zgubione > 0) {
+        loguj("UWAGA: drenaż logu przejść nie nadążał - opóźnione=%d, zgubione=%d (LOGI_PIERSCIEN=%d)",
+              logi_opoznione, logi_zgubione, LOGI_PIERSCIEN);
+    }
+    if (probki > 0) {
+        loguj("Próbki kolejek zapisane do: %s (%ld próbek)", PLIK_PROBKI, probki);
     }
 }
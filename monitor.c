@@ -9,16 +9,30 @@
 
 #include "ipc.h"
 #include "utils.h"
+#include "czas.h"
+#include "statystyki.h"
+#include "histogram.h"
+#include "obecnosc.h"
+#include "kolejki_shm.h"
 
 /*
  * monitor.c
- * Prosty "dashboard" na żywo do prezentacji komunikacji i stanu IPC.
+ * Prosty "dashboard" na żywo do prezentacji komunikacji i stanu IPC,
+ * albo eksport metryk dla wykresów / lokalnego stosu metryk.
  *
  * Użycie:
  *   ./monitor                 # odświeża ekran co 500ms
  *   ./monitor --once          # pojedynczy snapshot
  *   ./monitor --interval-ms 200
  *   ./monitor --no-color
+ *   ./monitor --format=json   # jeden obiekt JSON (wiersz) na interwał
+ *   ./monitor --format=prom   # format tekstowy Prometheusa
+ *   ./monitor --format=json --output metryki.jsonl [--rotate-mb 16] [--rotate-keep 3]
+ *   ./monitor --format=prom --output kolej.prom
+ *
+ * --output: json dopisuje wiersze i rotuje plik (PLIK -> PLIK.1 -> ... PLIK.K)
+ * po przekroczeniu --rotate-mb; prom podmienia plik atomowo (PLIK.tmp + rename)
+ * co interwał - tak jak oczekuje textfile collector node_exportera.
  */
 
 static volatile sig_atomic_t g_stop = 0;
@@ -43,8 +57,18 @@ static const char *faza_name(FazaDnia f) {
     }
 }
 
+typedef enum {
+    FORMAT_TEKST = 0,
+    FORMAT_JSON,
+    FORMAT_PROM
+} FormatWyjscia;
+
 typedef struct {
     int color;
+    FormatWyjscia format;
+    const char *output;         // NULL = stdout
+    long rotate_bajty;          // json + output: próg rotacji
+    int rotate_keep;            // ile starych plików trzymać
 } Ui;
 
 static const char *c(Ui *ui, const char *code) {
@@ -55,169 +79,607 @@ static void print_hr(void) {
     printf("------------------------------------------------------------\n");
 }
 
-static long mq_qnum(int mqid) {
-    struct msqid_ds ds;
-    if (mqid < 0) return -1;
-    if (msgctl(mqid, IPC_STAT, &ds) == -1) return -1;
-    return (long)ds.msg_qnum;
-}
-
 static long mq_qbytes(int mqid) {
     struct msqid_ds ds;
+    if (shmq_czy_uchwyt(mqid)) return shmq_pojemnosc_bajtow(mqid);
     if (mqid < 0) return -1;
     if (msgctl(mqid, IPC_STAT, &ds) == -1) return -1;
     return (long)ds.msg_qbytes;
 }
 
-/* Zwraca 0 gdy OK, !=0 gdy monitor powinien wyjść (np. IPC usunięte / main nie żyje). */
-static int print_snapshot(Ui *ui) {
+/* ============================================
+ * SNAPSHOT
+ * ============================================ */
+
+/* Kolejki w kolejności wyświetlania (uchwyty czytane po attach_ipc) */
+static const struct {
+    const char *nazwa;
+    const int *id;
+} g_kolejki[] = {
+    {"kasa", &g_mq_kasa},
+    {"kasa_odp", &g_mq_kasa_odp},
+    {"bramka", &g_mq_bramka},
+    {"bramka_odp", &g_mq_bramka_odp},
+    {"peron", &g_mq_peron},
+    {"peron_odp", &g_mq_peron_odp},
+    {"wyciag_req", &g_mq_wyciag_req},
+    {"wyciag_odp", &g_mq_wyciag_odp},
+    {"prac", &g_mq_prac},
+};
+#define LICZBA_KOLEJEK ((int)(sizeof(g_kolejki) / sizeof(g_kolejki[0])))
+
+#define LICZBA_PROCESOW (5 + LINIE_MAX + LICZBA_BRAMEK1)
+
+static const char *g_nazwy_karnetow[] = {"jednorazowy", "tk1", "tk2", "tk3", "dzienny"};
+static const char *g_nazwy_tras[] = {"T1", "T2", "T3", "T4"};
+
+/*
+ * UWAGA: SharedMemory jest bardzo duże (dziesiątki MB: karnety + logi).
+ * Nie wolno robić: `SharedMemory s = *g_shm;` bo to kopiuje cały segment
+ * do stosu i kończy się SIGSEGV (stack overflow).
+ *
+ * Zamiast tego kopiujemy TYLKO potrzebne pola do małego snapshota.
+ */
+typedef struct {
+    long long teraz_ns;
+
+    FazaDnia faza_dnia;
+    int awaria;
+    int panic;
+
+    long long start_ns;
+    long long koniec_dnia_ns;
+    int aktywni_klienci;
+
+    StanObecnosci ob;
+    int naruszenia;
+
+    Statystyki stats;
+
+    unsigned long logi_zalegle;
+    int logi_pojemnosc;
+    int logi_opoznione;
+    int logi_zgubione;
+
+    int sem_teren;
+    int sem_peron;
+    int sem_bariera;
+
+    long mq_num[LICZBA_KOLEJEK];
+    long mq_bytes[LICZBA_KOLEJEK];
+    int skrzynki;                   // -1 = transport SysV
+
+    pid_t pid_main;
+    pid_t pid_generator;
+    pid_t pid_kasjer;
+    pid_t pid_wyciag[LINIE_MAX];
+    int linie;
+    pid_t pid_pracownik1;
+    pid_t pid_pracownik2;
+    pid_t pid_bramki1[LICZBA_BRAMEK1];
+} MonitorSnapshot;
+
+/* Procesy stałe jako lista (nazwa, pid) - do json / prom */
+static int lista_procesow(const MonitorSnapshot *s, const char *nazwy[], pid_t pidy[]) {
+    static char nazwy_bramek[LICZBA_BRAMEK1][16];
+    static char nazwy_linii[LINIE_MAX][16];
+    int n = 0;
+
+    nazwy[n] = "main";        pidy[n++] = s->pid_main;
+    nazwy[n] = "generator";   pidy[n++] = s->pid_generator;
+    nazwy[n] = "kasjer";      pidy[n++] = s->pid_kasjer;
+    nazwy[n] = "wyciag";      pidy[n++] = s->pid_wyciag[0];
+    for (int i = 1; i < s->linie; i++) {
+        snprintf(nazwy_linii[i], sizeof(nazwy_linii[i]), "wyciag_%d", i + 1);
+        nazwy[n] = nazwy_linii[i];
+        pidy[n++] = s->pid_wyciag[i];
+    }
+    nazwy[n] = "pracownik1";  pidy[n++] = s->pid_pracownik1;
+    nazwy[n] = "pracownik2";  pidy[n++] = s->pid_pracownik2;
+    for (int i = 0; i < LICZBA_BRAMEK1; i++) {
+        snprintf(nazwy_bramek[i], sizeof(nazwy_bramek[i]), "bramka1_%d", i + 1);
+        nazwy[n] = nazwy_bramek[i];
+        pidy[n++] = s->pid_bramki1[i];
+    }
+    return n;
+}
+
+/*
+ * Zbiera snapshot. Zwraca 0 gdy OK, !=0 gdy monitor powinien wyjść
+ * (powód w *powod: IPC usunięte / main nie żyje).
+ */
+static int zbierz_snapshot(MonitorSnapshot *s, char *powod, size_t rozmiar) {
+    memset(s, 0, sizeof(*s));
+
     if (!g_shm) {
-        printf("Brak SHM (g_shm=NULL)\n");
+        snprintf(powod, rozmiar, "Brak SHM (g_shm=NULL)");
         return 1;
     }
 
-    /*
-     * UWAGA: SharedMemory jest bardzo duże (dziesiątki MB: karnety + logi).
-     * Nie wolno robić: `SharedMemory s = *g_shm;` bo to kopiuje cały segment
-     * do stosu i kończy się SIGSEGV (stack overflow).
-     *
-     * Zamiast tego kopiujemy TYLKO potrzebne pola do małego snapshota.
-     */
-    typedef struct {
-        FazaDnia faza_dnia;
-        int awaria;
-        int panic;
-
-        time_t czas_startu;
-        time_t czas_konca_dnia;
-        int aktywni_klienci;
-
-        int osoby_na_terenie;
-        int osoby_na_gorze;
-        int osoby_na_peronie;
-        int osoby_w_krzesle;
-
-        Statystyki stats;
-
-        pid_t pid_main;
-        pid_t pid_generator;
-        pid_t pid_kasjer;
-        pid_t pid_wyciag;
-        pid_t pid_pracownik1;
-        pid_t pid_pracownik2;
-        pid_t pid_bramki1[LICZBA_BRAMEK1];
-    } MonitorSnapshot;
-
-    MonitorSnapshot s;
-    memset(&s, 0, sizeof(s));
+    /* Mutex SHM żyje w segmencie (działa nawet po IPC_RMID) - usunięcie IPC
+     * wykrywamy po zestawie semaforów, który main kasuje razem z SHM. */
+    if (sem_getval_ipc(SEM_TEREN) < 0) {
+        snprintf(powod, rozmiar, "Brak dostepu do IPC (semafory usuniete) - czy main zakonczyl prace?");
+        return 1;
+    }
 
     /* Odczyt bezpieczny (z mutexem). Jeśli mutex padł (IPC usunięte), pokaż info zamiast crash. */
-    if (mutex_lock(SEM_MUTEX_SHM) != 0) {
-        printf("Brak dostepu do SHM (mutex SEM_MUTEX_SHM) - czy IPC zostalo usuniete?\n");
+    if (MUTEX_SHM_LOCK() != 0) {
+        snprintf(powod, rozmiar, "Brak dostepu do SHM (mutex SHM) - czy IPC zostalo usuniete?");
         return 1;
     }
-    s.faza_dnia = g_shm->faza_dnia;
-    s.awaria = g_shm->awaria;
-    s.panic = g_shm->panic;
+    StanGlobalny st;
+    stan_odczytaj(&st);
+    s->faza_dnia = st.faza_dnia;
+    s->awaria = st.awaria;
+    s->panic = st.panic;
+
+    s->start_ns = g_shm->kotwica.mono_ns;
+    s->koniec_dnia_ns = st.koniec_dnia_ns;
+    s->aktywni_klienci = g_shm->aktywni_klienci;
+
+    obecnosc_odczytaj(&s->ob);
+    s->naruszenia = obecnosc_naruszenia();
+
+    statystyki_zsumuj(&s->stats);
+
+    s->logi_zalegle = logi_oczekujace();
+    s->logi_pojemnosc = g_shm->geometria.pojemnosc_logow;
+    s->logi_opoznione = g_shm->logi_opoznione;
+    s->logi_zgubione = g_shm->logi_zgubione;
+
+    s->pid_main = st.pid_main;
+    s->pid_generator = st.pid_generator;
+    s->pid_kasjer = st.pid_kasjer;
+    memcpy(s->pid_wyciag, st.pid_wyciag, sizeof(s->pid_wyciag));
+    s->linie = g_shm->wyciag.linie;
+    s->pid_pracownik1 = st.pid_pracownik1;
+    s->pid_pracownik2 = st.pid_pracownik2;
+    memcpy(s->pid_bramki1, st.pid_bramki1, sizeof(s->pid_bramki1));
+    MUTEX_SHM_UNLOCK();
 
-    s.czas_startu = g_shm->czas_startu;
-    s.czas_konca_dnia = g_shm->czas_konca_dnia;
-    s.aktywni_klienci = g_shm->aktywni_klienci;
+    /* Jeśli main nie żyje, nie ma sensu trzymać SHM (a po IPC_RMID blokuje to zwolnienie segmentu). */
+    if (!is_alive(s->pid_main)) {
+        snprintf(powod, rozmiar, "[monitor] main=%d nie zyje -> koncze monitor", (int)s->pid_main);
+        return 1;
+    }
 
-    s.osoby_na_terenie = g_shm->osoby_na_terenie;
-    s.osoby_na_gorze = g_shm->osoby_na_gorze;
-    s.osoby_na_peronie = g_shm->osoby_na_peronie;
-    s.osoby_w_krzesle = g_shm->osoby_w_krzesle;
+    s->sem_teren = sem_getval_ipc(SEM_TEREN);
+    s->sem_peron = peron_wolne_sloty();
+    s->sem_bariera = sem_getval_ipc(SEM_BARIERA_AWARIA);
 
-    s.stats = g_shm->stats;
+    for (int i = 0; i < LICZBA_KOLEJEK; i++) {
+        s->mq_num[i] = msg_liczba(*g_kolejki[i].id);
+        s->mq_bytes[i] = mq_qbytes(*g_kolejki[i].id);
+    }
+    s->skrzynki = skrzynki_zajete();
 
-    s.pid_main = g_shm->pid_main;
-    s.pid_generator = g_shm->pid_generator;
-    s.pid_kasjer = g_shm->pid_kasjer;
-    s.pid_wyciag = g_shm->pid_wyciag;
-    s.pid_pracownik1 = g_shm->pid_pracownik1;
-    s.pid_pracownik2 = g_shm->pid_pracownik2;
-    memcpy(s.pid_bramki1, g_shm->pid_bramki1, sizeof(s.pid_bramki1));
-    mutex_unlock(SEM_MUTEX_SHM);
+    s->teraz_ns = czas_mono_ns();
+    return 0;
+}
 
-    /* Jeśli main nie żyje, nie ma sensu trzymać SHM (a po IPC_RMID blokuje to zwolnienie segmentu). */
-    if (!is_alive(s.pid_main)) {
-        printf("[monitor] main=%d nie zyje -> koncze monitor\n", (int)s.pid_main);
-        return 1;
-    }
+/* ============================================
+ * FORMAT TEKSTOWY (dashboard)
+ * ============================================ */
 
-    time_t now = time(NULL);
-    long left = (s.czas_konca_dnia > 0) ? (long)(s.czas_konca_dnia - now) : -1;
+static void print_snapshot(Ui *ui, const MonitorSnapshot *s) {
+    long long left_ms = (s->koniec_dnia_ns > 0) ? (s->koniec_dnia_ns - s->teraz_ns) / NS_NA_MS : -1;
 
     const char *phase_color = "";
     if (ui->color) {
-        if (s.faza_dnia == FAZA_OPEN) phase_color = "\x1b[32m";          /* green */
-        else if (s.faza_dnia == FAZA_CLOSING) phase_color = "\x1b[33m";   /* yellow */
-        else if (s.faza_dnia == FAZA_DRAINING) phase_color = "\x1b[35m";  /* magenta */
+        if (s->faza_dnia == FAZA_OPEN) phase_color = "\x1b[32m";          /* green */
+        else if (s->faza_dnia == FAZA_CLOSING) phase_color = "\x1b[33m";   /* yellow */
+        else if (s->faza_dnia == FAZA_DRAINING) phase_color = "\x1b[35m";  /* magenta */
     }
 
     printf("%sKOLEJ KRZESE\xC5\x81KOWA - MONITOR%s\n", c(ui, "\x1b[1m"), c(ui, "\x1b[0m"));
     print_hr();
 
     printf("Faza dnia: %s%s%s   awaria=%d   panic=%d\n",
-           phase_color, faza_name(s.faza_dnia), c(ui, "\x1b[0m"),
-           s.awaria, s.panic);
-
-    if (left >= 0) {
-        printf("Czas do konca dnia: %ld s   (start=%ld, koniec=%ld)\n",
-               left, (long)s.czas_startu, (long)s.czas_konca_dnia);
+           phase_color, faza_name(s->faza_dnia), c(ui, "\x1b[0m"),
+           s->awaria, s->panic);
+
+    if (left_ms >= 0) {
+        char start_buf[24], koniec_buf[24];
+        czas_formatuj_ms(s->start_ns, start_buf, sizeof(start_buf));
+        czas_formatuj_ms(s->koniec_dnia_ns, koniec_buf, sizeof(koniec_buf));
+        printf("Czas do konca dnia: %lld.%03lld s   (start=%s, koniec=%s)\n",
+               left_ms / 1000, left_ms % 1000, start_buf, koniec_buf);
     } else {
         printf("Czas do konca dnia: n/a\n");
     }
 
     print_hr();
     printf("Liczniki: teren=%d  peron=%d  w_krzesle=%d  gora=%d  aktywni_klienci=%d\n",
-           s.osoby_na_terenie, s.osoby_na_peronie, s.osoby_w_krzesle, s.osoby_na_gorze, s.aktywni_klienci);
+           s->ob.teren, s->ob.peron, s->ob.krzeslo, s->ob.gora, s->aktywni_klienci);
+    if (s->naruszenia >= 0) {
+        printf("Kontrola obecnosci: naruszenia=%d\n", s->naruszenia);
+    }
     printf("Statystyki: wygenerowani=%d  przejazdy=%d  przychod=%.2f zl\n",
-           s.stats.laczna_liczba_klientow, s.stats.liczba_przejazdow, s.stats.przychod_gr / 100.0);
+           s->stats.laczna_liczba_klientow, s->stats.liczba_przejazdow, s->stats.przychod_gr / 100.0);
+    printf("Log przejsc: zalegle=%lu/%d  opoznione=%d  zgubione=%d\n",
+           s->logi_zalegle, s->logi_pojemnosc, s->logi_opoznione, s->logi_zgubione);
+
+    print_hr();
+    printf("Czasy etapow (ms):\n");
+    histogramy_wypisz(stdout);
+
+    print_hr();
+    printf("Zegar wyciagu:\n");
+    zegar_wyciagu_wypisz(stdout);
+    pakowanie_wypisz(stdout);
 
     print_hr();
     printf("Semafory: TEREN=%d  PERON=%d  BARIERA_AWARIA=%d\n",
-           sem_getval_ipc(SEM_TEREN), sem_getval_ipc(SEM_PERON), sem_getval_ipc(SEM_BARIERA_AWARIA));
+           s->sem_teren, s->sem_peron, s->sem_bariera);
 
+    /* Dwa wiersze MQ: pierwsze 4 kolejki, potem reszta */
     print_hr();
-    printf("MQ: kasa=%ld/%ld  kasa_odp=%ld/%ld  bramka=%ld/%ld  bramka_odp=%ld/%ld\n",
-           mq_qnum(g_mq_kasa), mq_qbytes(g_mq_kasa),
-           mq_qnum(g_mq_kasa_odp), mq_qbytes(g_mq_kasa_odp),
-           mq_qnum(g_mq_bramka), mq_qbytes(g_mq_bramka),
-           mq_qnum(g_mq_bramka_odp), mq_qbytes(g_mq_bramka_odp));
-    printf("MQ: peron=%ld/%ld  peron_odp=%ld/%ld  wyciag_req=%ld/%ld  wyciag_odp=%ld/%ld  prac=%ld/%ld\n",
-           mq_qnum(g_mq_peron), mq_qbytes(g_mq_peron),
-           mq_qnum(g_mq_peron_odp), mq_qbytes(g_mq_peron_odp),
-           mq_qnum(g_mq_wyciag_req), mq_qbytes(g_mq_wyciag_req),
-           mq_qnum(g_mq_wyciag_odp), mq_qbytes(g_mq_wyciag_odp),
-           mq_qnum(g_mq_prac), mq_qbytes(g_mq_prac));
+    for (int i = 0; i < LICZBA_KOLEJEK; i++) {
+        printf("%s%s=%ld/%ld", (i == 0 || i == 4) ? "MQ: " : "  ",
+               g_kolejki[i].nazwa, s->mq_num[i], s->mq_bytes[i]);
+        if (i == 3 || i == LICZBA_KOLEJEK - 1) printf("\n");
+    }
+    if (s->skrzynki >= 0) {
+        printf("SKRZYNKI: zajete=%d/%d\n", s->skrzynki, SHMQ_SKRZYNKI);
+    }
 
     print_hr();
-    printf("PIDy: main=%d%s  gen=%d%s  kasjer=%d%s  wyciag=%d%s\n",
-           (int)s.pid_main, is_alive(s.pid_main) ? "" : "(dead)",
-           (int)s.pid_generator, is_alive(s.pid_generator) ? "" : "(dead)",
-           (int)s.pid_kasjer, is_alive(s.pid_kasjer) ? "" : "(dead)",
-           (int)s.pid_wyciag, is_alive(s.pid_wyciag) ? "" : "(dead)");
+    printf("PIDy: main=%d%s  gen=%d%s  kasjer=%d%s  wyciag:",
+           (int)s->pid_main, is_alive(s->pid_main) ? "" : "(dead)",
+           (int)s->pid_generator, is_alive(s->pid_generator) ? "" : "(dead)",
+           (int)s->pid_kasjer, is_alive(s->pid_kasjer) ? "" : "(dead)");
+    for (int i = 0; i < s->linie; i++) {
+        printf(" %d%s", (int)s->pid_wyciag[i], is_alive(s->pid_wyciag[i]) ? "" : "(dead)");
+    }
+    printf("\n");
     printf("PIDy: P1=%d%s  P2=%d%s  bramki:",
-           (int)s.pid_pracownik1, is_alive(s.pid_pracownik1) ? "" : "(dead)",
-           (int)s.pid_pracownik2, is_alive(s.pid_pracownik2) ? "" : "(dead)");
+           (int)s->pid_pracownik1, is_alive(s->pid_pracownik1) ? "" : "(dead)",
+           (int)s->pid_pracownik2, is_alive(s->pid_pracownik2) ? "" : "(dead)");
     for (int i = 0; i < LICZBA_BRAMEK1; i++) {
-        printf(" %d%s", (int)s.pid_bramki1[i], is_alive(s.pid_bramki1[i]) ? "" : "(dead)");
+        printf(" %d%s", (int)s->pid_bramki1[i], is_alive(s->pid_bramki1[i]) ? "" : "(dead)");
     }
     printf("\n");
 
+    printf("\n");
+}
+
+/* ============================================
+ * FORMAT JSON (jeden obiekt w wierszu)
+ * ============================================ */
+
+static void json_histogram(FILE *f, const char *nazwa, const Histogram *h) {
+    fprintf(f, "\"%s\":{\"liczba\":%lu,\"suma_us\":%lu,\"p50_us\":%lu,\"p99_us\":%lu,"
+               "\"p999_us\":%lu,\"max_us\":%lu}",
+            nazwa, h->liczba, h->suma_us, histogram_percentyl(h, 0.50),
+            histogram_percentyl(h, 0.99), histogram_percentyl(h, 0.999), h->max_us);
+}
+
+static void wypisz_json(FILE *f, const MonitorSnapshot *s) {
+    const Statystyki *st = &s->stats;
+    static Histogram h;
+    const char *nazwy[LICZBA_PROCESOW];
+    pid_t pidy[LICZBA_PROCESOW];
+    int n;
+
+    fprintf(f, "{\"czas_ms\":%lld,\"uplynelo_ms\":%lld,\"do_konca_ms\":%lld,",
+            czas_na_sciany_ns(s->teraz_ns) / NS_NA_MS,
+            (s->teraz_ns - s->start_ns) / NS_NA_MS,
+            (s->koniec_dnia_ns > 0) ? (s->koniec_dnia_ns - s->teraz_ns) / NS_NA_MS : -1);
+    fprintf(f, "\"faza\":\"%s\",\"awaria\":%d,\"panic\":%d,",
+            faza_name(s->faza_dnia), s->awaria, s->panic);
+
+    fprintf(f, "\"obecnosc\":{\"teren\":%d,\"peron\":%d,\"krzeslo\":%d,\"gora\":%d},",
+            s->ob.teren, s->ob.peron, s->ob.krzeslo, s->ob.gora);
+    fprintf(f, "\"aktywni_klienci\":%d,\"naruszenia\":%d,", s->aktywni_klienci, s->naruszenia);
+
+    fprintf(f, "\"statystyki\":{\"laczna_liczba_klientow\":%d,\"liczba_pieszych\":%d,"
+               "\"liczba_rowerzystow\":%d,\"liczba_vip\":%d,\"liczba_dzieci_odrzuconych\":%d,"
+               "\"liczba_grup_rodzinnych\":%d,\"sprzedane_karnety\":{",
+            st->laczna_liczba_klientow, st->liczba_pieszych, st->liczba_rowerzystow,
+            st->liczba_vip, st->liczba_dzieci_odrzuconych, st->liczba_grup_rodzinnych);
+    for (int i = 0; i < 5; i++) {
+        fprintf(f, "%s\"%s\":%d", i ? "," : "", g_nazwy_karnetow[i], st->sprzedane_karnety[i]);
+    }
+    fprintf(f, "},\"przychod_gr\":%d,\"uzycia_tras\":{", st->przychod_gr);
+    for (int i = 0; i < 4; i++) {
+        fprintf(f, "%s\"%s\":%d", i ? "," : "", g_nazwy_tras[i], st->uzycia_tras[i]);
+    }
+    fprintf(f, "},\"liczba_zatrzyman\":%d,\"liczba_przejazdow\":%d},",
+            st->liczba_zatrzyman, st->liczba_przejazdow);
+
+    fprintf(f, "\"log_przejsc\":{\"zalegle\":%lu,\"pojemnosc\":%d,\"opoznione\":%d,\"zgubione\":%d},",
+            s->logi_zalegle, s->logi_pojemnosc, s->logi_opoznione, s->logi_zgubione);
+
+    fprintf(f, "\"semafory\":{\"teren\":%d,\"peron\":%d,\"bariera_awaria\":%d},",
+            s->sem_teren, s->sem_peron, s->sem_bariera);
+
+    fprintf(f, "\"kolejki\":{");
+    for (int i = 0; i < LICZBA_KOLEJEK; i++) {
+        fprintf(f, "%s\"%s\":{\"qnum\":%ld,\"qbytes\":%ld}",
+                i ? "," : "", g_kolejki[i].nazwa, s->mq_num[i], s->mq_bytes[i]);
+    }
+    fprintf(f, "},\"skrzynki_zajete\":%d,", s->skrzynki);
+
+    fprintf(f, "\"procesy\":{");
+    n = lista_procesow(s, nazwy, pidy);
+    for (int i = 0; i < n; i++) {
+        fprintf(f, "%s\"%s\":{\"pid\":%d,\"zyje\":%d}",
+                i ? "," : "", nazwy[i], (int)pidy[i], is_alive(pidy[i]));
+    }
+    fprintf(f, "},");
+
+    {
+        const GeometriaWyciagu *w = &g_shm->wyciag;
+        fprintf(f, "\"geometria_wyciagu\":{\"rzedy\":%d,\"krzesla_w_rzedzie\":%d,\"peron_sloty\":%d,"
+                   "\"interwal_ms\":%d,\"pozycja_gorna\":%d},",
+                w->rzedy, w->krzesla_w_rzedzie, w->peron_sloty, w->interwal_ms, w->pozycja_gorna);
+        fprintf(f, "\"linie\":[");
+        for (int l = 0; l < w->linie; l++) {
+            fprintf(f, "%s{\"peron_zajety\":%d,\"grupy\":%lu}", l ? "," : "",
+                    linia_peron_zajety(l + 1),
+                    __atomic_load_n(&g_shm->linie[l].grupy, __ATOMIC_RELAXED));
+        }
+        fprintf(f, "],");
+    }
+
+    {
+        const ZegarWyciagu *z = &g_shm->zegar_wyciagu;
+        fprintf(f, "\"zegar_wyciagu\":{\"tryb\":\"%s\",\"interwal_ms\":%d,\"ticki\":%lu,"
+                   "\"zalegle\":%lu,\"pominiete\":%lu,",
+                nazwa_nadrabiania(z->tryb), g_shm->wyciag.interwal_ms,
+                __atomic_load_n(&z->ticki, __ATOMIC_RELAXED),
+                __atomic_load_n(&z->zalegle, __ATOMIC_RELAXED),
+                __atomic_load_n(&z->pominiete, __ATOMIC_RELAXED));
+        histogram_kopiuj(&z->opoznienie, &h);
+        json_histogram(f, "opoznienie", &h);
+        fprintf(f, ",");
+        histogram_kopiuj(&z->praca, &h);
+        json_histogram(f, "praca", &h);
+        fprintf(f, "},");
+    }
+    {
+        const PakowanieWyciagu *p = &g_shm->pakowanie;
+        fprintf(f, "\"pakowanie\":{\"polityka\":\"%s\",\"rzedy\":%lu,\"sloty\":%lu,\"grupy\":%lu,"
+                   "\"wyprzedzenia\":%lu,\"wyprzedzenia_max\":%d,\"wymuszone\":%lu},",
+                nazwa_pakowania(p->polityka),
+                __atomic_load_n(&p->rzedy, __ATOMIC_RELAXED), __atomic_load_n(&p->sloty, __ATOMIC_RELAXED),
+                __atomic_load_n(&p->grupy, __ATOMIC_RELAXED), __atomic_load_n(&p->wyprzedzenia, __ATOMIC_RELAXED),
+                __atomic_load_n(&p->wyprzedzenia_max, __ATOMIC_RELAXED),
+                __atomic_load_n(&p->wymuszone, __ATOMIC_RELAXED));
+    }
+
+    fprintf(f, "\"etapy\":[");
+    n = 0;
+    for (int e = 0; e < ETAP_LICZBA; e++) {
+        for (int k = 0; k < KLASA_LICZBA; k++) {
+            histogram_odczytaj((EtapKlienta)e, k, &h);
+            if (h.liczba == 0) continue;
+            fprintf(f, "%s{\"etap\":\"%s\",\"klasa\":\"%s\",\"liczba\":%lu,\"suma_us\":%lu,"
+                       "\"p50_us\":%lu,\"p90_us\":%lu,\"p99_us\":%lu,\"p999_us\":%lu,\"max_us\":%lu}",
+                    n++ ? "," : "", nazwa_etapu((EtapKlienta)e), nazwa_klasy(k), h.liczba, h.suma_us,
+                    histogram_percentyl(&h, 0.50), histogram_percentyl(&h, 0.90),
+                    histogram_percentyl(&h, 0.99), histogram_percentyl(&h, 0.999), h.max_us);
+        }
+    }
+    fprintf(f, "]}\n");
+}
+
+/* ============================================
+ * FORMAT PROMETHEUS (text exposition 0.0.4)
+ * ============================================ */
+
+static void prom_naglowek(FILE *f, const char *nazwa, const char *typ, const char *opis) {
+    fprintf(f, "# HELP %s %s\n# TYPE %s %s\n", nazwa, opis, nazwa, typ);
+}
+
+static void prom_wartosc(FILE *f, const char *nazwa, const char *typ, const char *opis, long long v) {
+    prom_naglowek(f, nazwa, typ, opis);
+    fprintf(f, "%s %lld\n", nazwa, v);
+}
+
+static void wypisz_prom(FILE *f, const MonitorSnapshot *s) {
+    const Statystyki *st = &s->stats;
+    static Histogram h;
+    const char *nazwy[LICZBA_PROCESOW];
+    pid_t pidy[LICZBA_PROCESOW];
+    static const double kwantyle[] = {0.5, 0.9, 0.99, 0.999};
+
+    prom_wartosc(f, "kolej_faza_dnia", "gauge", "Faza dnia: 0=OPEN 1=CLOSING 2=DRAINING", s->faza_dnia);
+    prom_wartosc(f, "kolej_awaria", "gauge", "STOP awaryjny aktywny", s->awaria);
+    prom_wartosc(f, "kolej_panic", "gauge", "Awaryjne zamykanie po smierci procesu", s->panic);
+    prom_naglowek(f, "kolej_do_konca_dnia_sekundy", "gauge", "Czas do konca dnia (-1 = nieustawiony)");
+    fprintf(f, "kolej_do_konca_dnia_sekundy %.3f\n",
+            (s->koniec_dnia_ns > 0) ? (double)(s->koniec_dnia_ns - s->teraz_ns) / NS_NA_SEK : -1.0);
+    prom_naglowek(f, "kolej_uplynelo_sekundy", "gauge", "Czas od startu symulacji");
+    fprintf(f, "kolej_uplynelo_sekundy %.3f\n", (double)(s->teraz_ns - s->start_ns) / NS_NA_SEK);
+
+    prom_naglowek(f, "kolej_obecnosc", "gauge", "Osoby w strefie");
+    fprintf(f, "kolej_obecnosc{strefa=\"teren\"} %d\n", s->ob.teren);
+    fprintf(f, "kolej_obecnosc{strefa=\"peron\"} %d\n", s->ob.peron);
+    fprintf(f, "kolej_obecnosc{strefa=\"krzeslo\"} %d\n", s->ob.krzeslo);
+    fprintf(f, "kolej_obecnosc{strefa=\"gora\"} %d\n", s->ob.gora);
+    prom_wartosc(f, "kolej_aktywni_klienci", "gauge", "Zyjace procesy klientow", s->aktywni_klienci);
+    prom_wartosc(f, "kolej_naruszenia_obecnosci", "gauge", "Naruszenia niezmiennikow (-1 = kontrola wylaczona)",
+                 s->naruszenia);
+
+    prom_wartosc(f, "kolej_klienci_total", "counter", "Wygenerowani klienci", st->laczna_liczba_klientow);
+    prom_wartosc(f, "kolej_klienci_piesi_total", "counter", "Klienci piesi", st->liczba_pieszych);
+    prom_wartosc(f, "kolej_klienci_rowerzysci_total", "counter", "Klienci rowerzysci", st->liczba_rowerzystow);
+    prom_wartosc(f, "kolej_klienci_vip_total", "counter", "Klienci VIP", st->liczba_vip);
+    prom_wartosc(f, "kolej_dzieci_odrzucone_total", "counter", "Dzieci bez opiekuna odrzucone",
+                 st->liczba_dzieci_odrzuconych);
+    prom_wartosc(f, "kolej_grupy_rodzinne_total", "counter", "Grupy z dziecmi", st->liczba_grup_rodzinnych);
+    prom_naglowek(f, "kolej_karnety_sprzedane_total", "counter", "Sprzedane karnety wg typu");
+    for (int i = 0; i < 5; i++) {
+        fprintf(f, "kolej_karnety_sprzedane_total{typ=\"%s\"} %d\n", g_nazwy_karnetow[i], st->sprzedane_karnety[i]);
+    }
+    prom_wartosc(f, "kolej_przychod_grosze_total", "counter", "Przychod w groszach", st->przychod_gr);
+    prom_naglowek(f, "kolej_trasy_total", "counter", "Zjazdy wg trasy");
+    for (int i = 0; i < 4; i++) {
+        fprintf(f, "kolej_trasy_total{trasa=\"%s\"} %d\n", g_nazwy_tras[i], st->uzycia_tras[i]);
+    }
+    prom_wartosc(f, "kolej_zatrzymania_total", "counter", "Zatrzymania awaryjne", st->liczba_zatrzyman);
+    prom_wartosc(f, "kolej_przejazdy_total", "counter", "Przejazdy wyciagiem", st->liczba_przejazdow);
+
+    prom_wartosc(f, "kolej_log_przejsc_zalegle", "gauge", "Wpisy czekajace w pierscieniu logu", (long long)s->logi_zalegle);
+    prom_wartosc(f, "kolej_log_przejsc_pojemnosc", "gauge", "Pojemnosc pierscienia logu", s->logi_pojemnosc);
+    prom_wartosc(f, "kolej_log_przejsc_opoznione_total", "counter", "Wpisy, na ktore producent czekal",
+                 s->logi_opoznione);
+    prom_wartosc(f, "kolej_log_przejsc_zgubione_total", "counter", "Wpisy porzucone", s->logi_zgubione);
+
+    prom_naglowek(f, "kolej_semafor", "gauge", "Wartosc semafora");
+    fprintf(f, "kolej_semafor{sem=\"teren\"} %d\n", s->sem_teren);
+    fprintf(f, "kolej_semafor{sem=\"peron\"} %d\n", s->sem_peron);
+    fprintf(f, "kolej_semafor{sem=\"bariera_awaria\"} %d\n", s->sem_bariera);
+
+    prom_naglowek(f, "kolej_kolejka_wiadomosci", "gauge", "Wiadomosci w kolejce (qnum)");
+    for (int i = 0; i < LICZBA_KOLEJEK; i++) {
+        fprintf(f, "kolej_kolejka_wiadomosci{kolejka=\"%s\"} %ld\n", g_kolejki[i].nazwa, s->mq_num[i]);
+    }
+    prom_naglowek(f, "kolej_kolejka_bajty_max", "gauge", "Pojemnosc kolejki w bajtach (qbytes)");
+    for (int i = 0; i < LICZBA_KOLEJEK; i++) {
+        fprintf(f, "kolej_kolejka_bajty_max{kolejka=\"%s\"} %ld\n", g_kolejki[i].nazwa, s->mq_bytes[i]);
+    }
+    prom_wartosc(f, "kolej_skrzynki_zajete", "gauge", "Zajete skrzynki odpowiedzi (-1 = transport SysV)",
+                 s->skrzynki);
+
+    prom_naglowek(f, "kolej_proces_zyje", "gauge", "Proces staly zyje");
+    int n = lista_procesow(s, nazwy, pidy);
+    for (int i = 0; i < n; i++) {
+        fprintf(f, "kolej_proces_zyje{proces=\"%s\",pid=\"%d\"} %d\n", nazwy[i], (int)pidy[i], is_alive(pidy[i]));
+    }
+
+    {
+        const ZegarWyciagu *z = &g_shm->zegar_wyciagu;
+        const Histogram *zh[2] = {&z->opoznienie, &z->praca};
+        static const char *zn[2] = {"kolej_wyciag_opoznienie_ticka_sekundy", "kolej_wyciag_praca_ticka_sekundy"};
+        static const char *zo[2] = {"Start ticka wyciagu po terminie", "Czas pracy ticka wyciagu"};
+
+        prom_wartosc(f, "kolej_wyciag_ticki_total", "counter", "Wykonane ticki wyciagu",
+                     (long long)__atomic_load_n(&z->ticki, __ATOMIC_RELAXED));
+        prom_wartosc(f, "kolej_wyciag_ticki_zalegle_total", "counter", "Ticki wykonane co najmniej interwal po terminie",
+                     (long long)__atomic_load_n(&z->zalegle, __ATOMIC_RELAXED));
+        prom_wartosc(f, "kolej_wyciag_ticki_pominiete_total", "counter", "Terminy tickow porzucone przez tryb nadrabiania",
+                     (long long)__atomic_load_n(&z->pominiete, __ATOMIC_RELAXED));
+        for (int i = 0; i < 2; i++) {
+            histogram_kopiuj(zh[i], &h);
+            prom_naglowek(f, zn[i], "summary", zo[i]);
+            for (int q = 0; q < 4; q++) {
+                fprintf(f, "%s{quantile=\"%g\"} %.6f\n", zn[i], kwantyle[q], histogram_percentyl(&h, kwantyle[q]) / 1e6);
+            }
+            fprintf(f, "%s_sum %.6f\n", zn[i], h.suma_us / 1e6);
+            fprintf(f, "%s_count %lu\n", zn[i], h.liczba);
+        }
+    }
+
+    {
+        const PakowanieWyciagu *p = &g_shm->pakowanie;
+        prom_wartosc(f, "kolej_pakowanie_rzedy_total", "counter", "Rzedy ladowane przy niepustej kolejce",
+                     (long long)__atomic_load_n(&p->rzedy, __ATOMIC_RELAXED));
+        prom_wartosc(f, "kolej_pakowanie_sloty_total", "counter", "Sloty zajete w ladowanych rzedach",
+                     (long long)__atomic_load_n(&p->sloty, __ATOMIC_RELAXED));
+        prom_wartosc(f, "kolej_pakowanie_wyprzedzenia_total", "counter", "Rzedy, w ktorych grupe wyprzedzil ktos pozniejszy",
+                     (long long)__atomic_load_n(&p->wyprzedzenia, __ATOMIC_RELAXED));
+        prom_wartosc(f, "kolej_pakowanie_wymuszone_total", "counter", "Grupy wsadzone z limitu wyprzedzen",
+                     (long long)__atomic_load_n(&p->wymuszone, __ATOMIC_RELAXED));
+    }
+
+    prom_naglowek(f, "kolej_etap_sekundy", "summary", "Czas etapu klienta");
+    for (int e = 0; e < ETAP_LICZBA; e++) {
+        for (int k = 0; k < KLASA_LICZBA; k++) {
+            histogram_odczytaj((EtapKlienta)e, k, &h);
+            if (h.liczba == 0) continue;
+            const char *etap = nazwa_etapu((EtapKlienta)e);
+            const char *klasa = nazwa_klasy(k);
+            for (int q = 0; q < 4; q++) {
+                fprintf(f, "kolej_etap_sekundy{etap=\"%s\",klasa=\"%s\",quantile=\"%g\"} %.6f\n",
+                        etap, klasa, kwantyle[q], histogram_percentyl(&h, kwantyle[q]) / 1e6);
+            }
+            fprintf(f, "kolej_etap_sekundy_sum{etap=\"%s\",klasa=\"%s\"} %.6f\n", etap, klasa, h.suma_us / 1e6);
+            fprintf(f, "kolej_etap_sekundy_count{etap=\"%s\",klasa=\"%s\"} %lu\n", etap, klasa, h.liczba);
+        }
+    }
+}
+
+/* ============================================
+ * ZAPIS DO PLIKU (rotacja / podmiana atomowa)
+ * ============================================ */
+
+/* PLIK.(K-1) -> PLIK.K, ..., PLIK -> PLIK.1 */
+static void rotuj(const char *plik, int keep) {
+    char z[512], na[512];
+
+    for (int i = keep - 1; i >= 1; i--) {
+        snprintf(z, sizeof(z), "%s.%d", plik, i);
+        snprintf(na, sizeof(na), "%s.%d", plik, i + 1);
+        (void)rename(z, na);
+    }
+    if (keep >= 1) {
+        snprintf(na, sizeof(na), "%s.1", plik);
+        (void)rename(plik, na);
+    } else {
+        (void)unlink(plik);
+    }
+}
+
+/* Zwraca 0 gdy OK, -1 przy błędzie zapisu */
+static int zapisz_rekord(Ui *ui, const MonitorSnapshot *s) {
+    if (ui->output == NULL) {
+        if (ui->format == FORMAT_JSON) wypisz_json(stdout, s);
+        else wypisz_prom(stdout, s);
+        fflush(stdout);
+        return 0;
+    }
+
+    if (ui->format == FORMAT_PROM) {
+        char tmp[512];
+        snprintf(tmp, sizeof(tmp), "%s.tmp", ui->output);
+        FILE *f = fopen(tmp, "w");
+        if (f == NULL) {
+            perror(tmp);
+            return -1;
+        }
+        wypisz_prom(f, s);
+        if (fclose(f) != 0 || rename(tmp, ui->output) != 0) {
+            perror(ui->output);
+            return -1;
+        }
+        return 0;
+    }
+
+    FILE *f = fopen(ui->output, "a");
+    if (f == NULL) {
+        perror(ui->output);
+        return -1;
+    }
+    if (ui->rotate_bajty > 0 && fseek(f, 0, SEEK_END) == 0 && ftell(f) >= ui->rotate_bajty) {
+        fclose(f);
+        rotuj(ui->output, ui->rotate_keep);
+        f = fopen(ui->output, "a");
+        if (f == NULL) {
+            perror(ui->output);
+            return -1;
+        }
+    }
+    wypisz_json(f, s);
+    if (fclose(f) != 0) {
+        perror(ui->output);
+        return -1;
+    }
     return 0;
 }
 
 static void usage(const char *argv0) {
     printf("Uzycie: %s [--once] [--interval-ms N] [--no-color]\n", argv0);
+    printf("        [--format=text|json|prom] [--output PLIK] [--rotate-mb N] [--rotate-keep K]\n");
 }
 
 int main(int argc, char **argv) {
     int once = 0;
     int interval_ms = 500;
-    Ui ui = {.color = 1};
+    Ui ui = {.color = 1, .format = FORMAT_TEKST, .output = NULL,
+             .rotate_bajty = 16L * 1024 * 1024, .rotate_keep = 3};
 
     for (int i = 1; i < argc; i++) {
         if (strcmp(argv[i], "--once") == 0) {
@@ -227,6 +689,22 @@ int main(int argc, char **argv) {
         } else if (strcmp(argv[i], "--interval-ms") == 0 && i + 1 < argc) {
             interval_ms = atoi(argv[++i]);
             if (interval_ms < 50) interval_ms = 50;
+        } else if (strncmp(argv[i], "--format=", 9) == 0) {
+            const char *fmt = argv[i] + 9;
+            if (strcmp(fmt, "text") == 0) ui.format = FORMAT_TEKST;
+            else if (strcmp(fmt, "json") == 0) ui.format = FORMAT_JSON;
+            else if (strcmp(fmt, "prom") == 0) ui.format = FORMAT_PROM;
+            else {
+                usage(argv[0]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--output") == 0 && i + 1 < argc) {
+            ui.output = argv[++i];
+        } else if (strcmp(argv[i], "--rotate-mb") == 0 && i + 1 < argc) {
+            ui.rotate_bajty = atol(argv[++i]) * 1024L * 1024L;
+        } else if (strcmp(argv[i], "--rotate-keep") == 0 && i + 1 < argc) {
+            ui.rotate_keep = atoi(argv[++i]);
+            if (ui.rotate_keep < 0) ui.rotate_keep = 0;
         } else if (strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0) {
             usage(argv[0]);
             return 0;
@@ -235,6 +713,13 @@ int main(int argc, char **argv) {
             return 1;
         }
     }
+    if (ui.output != NULL && ui.format == FORMAT_TEKST) {
+        fprintf(stderr, "[monitor] --output wymaga --format=json albo --format=prom\n");
+        return 1;
+    }
+    if (ui.format != FORMAT_TEKST) {
+        ui.color = 0;
+    }
 
     if (attach_ipc() != 0) {
         fprintf(stderr, "[monitor] Nie moge podlaczyc IPC (czy ./main dziala?)\n");
@@ -244,23 +729,27 @@ int main(int argc, char **argv) {
     signal(SIGINT, on_sigint);
     signal(SIGTERM, on_sigint);
 
-    if (once) {
-        (void)print_snapshot(&ui);
-        detach_ipc();
-        return 0;
-    }
+    MonitorSnapshot s;
+    char powod[160];
 
     while (!g_stop) {
-        /* czyść ekran */
-        if (ui.color) {
-            printf("\x1b[2J\x1b[H");
-        } else {
-            printf("\n\n");
-        }
-        if (print_snapshot(&ui) != 0) {
+        int koniec = zbierz_snapshot(&s, powod, sizeof(powod));
+
+        if (ui.format == FORMAT_TEKST) {
+            /* czyść ekran */
+            if (!once) {
+                printf(ui.color ? "\x1b[2J\x1b[H" : "\n\n");
+            }
+            if (koniec) printf("%s\n", powod);
+            else print_snapshot(&ui, &s);
+            fflush(stdout);
+        } else if (koniec) {
+            fprintf(stderr, "%s\n", powod);
+        } else if (zapisz_rekord(&ui, &s) != 0) {
             break;
         }
-        fflush(stdout);
+
+        if (koniec || once) break;
         usleep((useconds_t)interval_ms * 1000u);
     }
 
@@ -0,0 +1,147 @@
+#include "obecnosc.h"
+#include "ipc.h"
+#include "utils.h"
+
+/*
+ * KOLEJ KRZESEŁKOWA - LICZNIKI OBECNOŚCI
+ *
+ * Układ słowa strefy (bity):
+ *   [0..15]  teren    (<= N_LIMIT_TERENU_MAX)
+ *   [16..27] peron    (<= LINIE_MAX * PERON_SLOTY_MAX)
+ *   [28..41] krzesło  (<= LINIE_MAX * RZEDY_MAX * KRZESLA_MAX, suma linii)
+ *   [42..63] góra     (<= 3 * MAX_KLIENTOW)
+ * Peron i krzesło sumują wszystkie linie wyciągu; SEM_TEREN zwalnia się
+ * przy wejściu na peron, więc N ich nie ogranicza - tylko geometria.
+ * Przeniesienie = add(k << przesuniecie[do] - k << przesuniecie[z]).
+ * Póki żadna strefa nie spada poniżej zera, pożyczka między polami
+ * nie występuje; gdy spadnie (błąd), tryb kontroli to wykryje.
+ *
+ * Tryb kontroli (KOLEJ_KONTROLA_OBECNOSCI=1):
+ * - wpuszczeni/wyszli liczą wejścia i wyjścia,
+ * - po każdym przeniesieniu: strefa źródłowa miała >= k osób
+ *   i suma stref <= wpuszczeni - wyszli,
+ * - na koniec dnia: strefy puste i wpuszczeni == wyszli.
+ * Poza trybem kontroli przeniesienie to dokładnie jeden atomowy add.
+ */
+
+static const int g_przesuniecie[STREFA_LICZBA] = {
+    [STREFA_POZA]    = -1,
+    [STREFA_TEREN]   = 0,
+    [STREFA_PERON]   = 16,
+    [STREFA_KRZESLO] = 28,
+    [STREFA_GORA]    = 42
+};
+
+static const int g_bity[STREFA_LICZBA] = {
+    [STREFA_POZA]    = 0,
+    [STREFA_TEREN]   = 16,
+    [STREFA_PERON]   = 12,
+    [STREFA_KRZESLO] = 14,
+    [STREFA_GORA]    = 22
+};
+
+static const char *g_nazwy[STREFA_LICZBA] = {
+    [STREFA_POZA]    = "poza",
+    [STREFA_TEREN]   = "teren",
+    [STREFA_PERON]   = "peron",
+    [STREFA_KRZESLO] = "krzeslo",
+    [STREFA_GORA]    = "gora"
+};
+
+_Static_assert(N_LIMIT_TERENU_MAX < (1 << 15), "obecnosc: pole teren za małe");
+_Static_assert(LINIE_MAX * RZEDY_MAX * KRZESLA_MAX < (1 << 13), "obecnosc: pole krzeslo za małe");
+_Static_assert(LINIE_MAX * PERON_SLOTY_MAX < (1 << 11), "obecnosc: pole peron za małe");
+_Static_assert(MAX_KLIENTOW * 3L < (1L << 21), "obecnosc: pole gora za małe");
+
+/* Pole strefy ze znakiem (ujemne = ktoś wyjął więcej niż było) */
+static int pole(unsigned long slowo, StrefaObecnosci s) {
+    unsigned long maska = (1UL << g_bity[s]) - 1;
+    long v = (long)((slowo >> g_przesuniecie[s]) & maska);
+    if (v >= (long)(1UL << (g_bity[s] - 1))) v -= (long)(1UL << g_bity[s]);
+    return (int)v;
+}
+
+static int suma(unsigned long slowo) {
+    int s = 0;
+    for (int i = STREFA_TEREN; i < STREFA_LICZBA; i++) s += pole(slowo, (StrefaObecnosci)i);
+    return s;
+}
+
+static void zglos_naruszenie(const char *opis, unsigned long slowo, long wpuszczeni, long wyszli) {
+    __atomic_fetch_add(&g_shm->obecnosc.naruszenia, 1, __ATOMIC_RELAXED);
+    loguj("OBECNOSC: NARUSZENIE %s (teren=%d peron=%d krzeslo=%d gora=%d, wpuszczeni=%ld wyszli=%ld)",
+          opis, pole(slowo, STREFA_TEREN), pole(slowo, STREFA_PERON),
+          pole(slowo, STREFA_KRZESLO), pole(slowo, STREFA_GORA), wpuszczeni, wyszli);
+}
+
+void obecnosc_wlacz_kontrole(void) {
+    if (g_shm == NULL) return;
+    __atomic_store_n(&g_shm->obecnosc.kontrola, 1, __ATOMIC_RELEASE);
+    loguj("Kontrola obecności: WŁĄCZONA (niezmienniki sprawdzane przy każdym przejściu)");
+}
+
+void obecnosc_przenies(StrefaObecnosci z, StrefaObecnosci do_strefy, int k) {
+    if (g_shm == NULL || k <= 0 || z == do_strefy) return;
+    Obecnosc *o = &g_shm->obecnosc;
+
+    unsigned long delta = 0;
+    if (do_strefy != STREFA_POZA) delta += (unsigned long)k << g_przesuniecie[do_strefy];
+    if (z != STREFA_POZA)         delta -= (unsigned long)k << g_przesuniecie[z];
+
+    if (!__atomic_load_n(&o->kontrola, __ATOMIC_RELAXED)) {
+        __atomic_fetch_add(&o->strefy, delta, __ATOMIC_RELAXED);
+        return;
+    }
+
+    /* Kolejność: wejście liczymy PRZED dodaniem do strefy, wyjście PO zdjęciu,
+     * więc suma stref nigdy nie przekracza wpuszczeni - wyszli. */
+    if (z == STREFA_POZA) __atomic_fetch_add(&o->wpuszczeni, k, __ATOMIC_SEQ_CST);
+    unsigned long przed = __atomic_fetch_add(&o->strefy, delta, __ATOMIC_SEQ_CST);
+    if (do_strefy == STREFA_POZA) __atomic_fetch_add(&o->wyszli, k, __ATOMIC_SEQ_CST);
+
+    if (z != STREFA_POZA && pole(przed, z) < k) {
+        char opis[96];
+        snprintf(opis, sizeof(opis), "przeniesienie %d z %s (było %d) do %s",
+                 k, g_nazwy[z], pole(przed, z), g_nazwy[do_strefy]);
+        zglos_naruszenie(opis, przed + delta, __atomic_load_n(&o->wpuszczeni, __ATOMIC_RELAXED),
+                         __atomic_load_n(&o->wyszli, __ATOMIC_RELAXED));
+    }
+
+    long wyszli = __atomic_load_n(&o->wyszli, __ATOMIC_SEQ_CST);
+    unsigned long slowo = __atomic_load_n(&o->strefy, __ATOMIC_SEQ_CST);
+    long wpuszczeni = __atomic_load_n(&o->wpuszczeni, __ATOMIC_SEQ_CST);
+    if (suma(slowo) > wpuszczeni - wyszli) {
+        zglos_naruszenie("suma stref > wpuszczeni - wyszli", slowo, wpuszczeni, wyszli);
+    }
+}
+
+void obecnosc_odczytaj(StanObecnosci *s) {
+    unsigned long slowo = g_shm ? __atomic_load_n(&g_shm->obecnosc.strefy, __ATOMIC_RELAXED) : 0;
+    s->teren = pole(slowo, STREFA_TEREN);
+    s->peron = pole(slowo, STREFA_PERON);
+    s->krzeslo = pole(slowo, STREFA_KRZESLO);
+    s->gora = pole(slowo, STREFA_GORA);
+}
+
+int obecnosc_naruszenia(void) {
+    if (g_shm == NULL || !__atomic_load_n(&g_shm->obecnosc.kontrola, __ATOMIC_RELAXED)) return -1;
+    return __atomic_load_n(&g_shm->obecnosc.naruszenia, __ATOMIC_RELAXED);
+}
+
+int obecnosc_bilans_koncowy(void) {
+    if (g_shm == NULL || !__atomic_load_n(&g_shm->obecnosc.kontrola, __ATOMIC_RELAXED)) return 0;
+    Obecnosc *o = &g_shm->obecnosc;
+
+    unsigned long slowo = __atomic_load_n(&o->strefy, __ATOMIC_SEQ_CST);
+    long wpuszczeni = __atomic_load_n(&o->wpuszczeni, __ATOMIC_SEQ_CST);
+    long wyszli = __atomic_load_n(&o->wyszli, __ATOMIC_SEQ_CST);
+
+    if (slowo != 0 || wpuszczeni != wyszli) {
+        zglos_naruszenie("bilans końcowy (strefy niepuste)", slowo, wpuszczeni, wyszli);
+    }
+
+    int naruszenia = __atomic_load_n(&o->naruszenia, __ATOMIC_RELAXED);
+    loguj("OBECNOSC: bilans końcowy wpuszczeni=%ld wyszli=%ld naruszenia=%d -> %s",
+          wpuszczeni, wyszli, naruszenia, naruszenia == 0 ? "OK" : "BŁĄD");
+    return naruszenia == 0 ? 0 : -1;
+}
@@ -0,0 +1,51 @@
+#ifndef OBECNOSC_H
+#define OBECNOSC_H
+
+#include "types.h"
+
+/*
+ * KOLEJ KRZESEŁKOWA - LICZNIKI OBECNOŚCI
+ * Ile osób jest w każdej strefie (teren, peron, krzesełko, góra).
+ * Wszystkie strefy siedzą w jednym 64-bitowym słowie, więc
+ * "przenieś k osób z A do B" to jeden atomowy add - bez mutexa SHM
+ * i bez chwil, w których osoba jest w dwóch strefach albo w żadnej.
+ */
+
+/* Liczniki stref w czytelnej postaci (do monitora / raportów) */
+typedef struct {
+    int teren;
+    int peron;
+    int krzeslo;
+    int gora;
+} StanObecnosci;
+
+/*
+ * Włącza tryb kontroli niezmienników (main, przed startem procesów)
+ */
+void obecnosc_wlacz_kontrole(void);
+
+/*
+ * Przenosi k osób ze strefy z do strefy do
+ * STREFA_POZA po stronie z = wejście (bramka), po stronie do = wyjście.
+ * W trybie kontroli sprawdza niezmienniki i loguje naruszenia.
+ */
+void obecnosc_przenies(StrefaObecnosci z, StrefaObecnosci do_strefy, int k);
+
+/*
+ * Spójny odczyt wszystkich stref (jeden load)
+ */
+void obecnosc_odczytaj(StanObecnosci *s);
+
+/*
+ * Liczba wykrytych naruszeń (-1 = kontrola wyłączona)
+ */
+int obecnosc_naruszenia(void);
+
+/*
+ * Bilans końcowy (main, po zakończeniu klientów): wszystkie strefy puste
+ * i wpuszczeni == wyszli. Loguje wynik w trybie kontroli.
+ * Zwraca: 0=OK / kontrola wyłączona, -1=naruszenie
+ */
+int obecnosc_bilans_koncowy(void);
+
+#endif /* OBECNOSC_H */
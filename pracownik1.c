@@ -10,6 +10,7 @@
 #include "types.h"
 #include "ipc.h"
 #include "utils.h"
+#include "statystyki.h"
 
 /*
  * KOLEJ KRZESEŁKOWA - PRACOWNIK 1 (Stacja dolna)
@@ -60,10 +61,8 @@ static int czekaj_na_gotowy(int timeout_ms, int wymagaj_open) {
     int waited = 0;
     while (!g_koniec) {
         if (wymagaj_open) {
-            MUTEX_SHM_LOCK();
-            int faza = g_shm->faza_dnia;
-            int panic = g_shm->panic;
-            MUTEX_SHM_UNLOCK();
+            int faza = STAN(faza_dnia);
+            int panic = STAN(panic);
             if (panic || faza != FAZA_OPEN) {
                 return -2;
             }
@@ -78,10 +77,10 @@ static int czekaj_na_gotowy(int timeout_ms, int wymagaj_open) {
             /* Jeśli w trakcie czekania przyjdzie STOP/START, obsłuż je od razu */
             if (msg.typ_komunikatu == MSG_TYP_STOP) {
                 /* Drugi pracownik prosi o STOP -> potwierdź gotowość */
-                MUTEX_SHM_LOCK();
-                g_shm->awaria = 1;
-                g_shm->kolej_aktywna = 0;
-                MUTEX_SHM_UNLOCK();
+                stan_zapis_poczatek();
+                STAN_USTAW(awaria, 1);
+                STAN_USTAW(kolej_aktywna, 0);
+                stan_zapis_koniec();
 
                 MsgPracownicy odp;
                 odp.mtype = OTHER_MTYPE;
@@ -134,16 +133,16 @@ static int obsluz_peron(void) {
          * Uwaga: to jest rozszerzenie względem "po Tk bramki przestają działać" –
          * bramka1 nadal odmawia, ale peron nie blokuje osób już wpuszczonych na teren.
          */
-        MUTEX_SHM_LOCK();
-        int panic = g_shm->panic;
-        int awaria = g_shm->awaria;
-        MUTEX_SHM_UNLOCK();
+        int panic = STAN(panic);
+        int awaria = STAN(awaria);
 
         MsgPeronOdp odp;
         odp.mtype = req.pid_klienta;
         odp.sukces = (!panic && !awaria) ? 1 : 0;
+        /* Grupa idzie do linii z najkrótszą kolejką (najmniej zajętym peronem) */
+        odp.linia = odp.sukces ? linia_najkrotsza() : 0;
 
-        msg_send_nowait(g_mq_peron_odp, &odp, sizeof(odp));
+        msg_send_odp(g_mq_peron_odp, req.skrzynka, &odp, sizeof(odp), 0);
         handled++;
     }
     return handled;
@@ -160,10 +159,10 @@ static int obsluz_prac_messages(void) {
         switch (msg.typ_komunikatu) {
             case MSG_TYP_STOP: {
                 loguj("PRACOWNIK1: Otrzymano STOP (od P2) - potwierdzam GOTOWY");
-                MUTEX_SHM_LOCK();
-                g_shm->awaria = 1;
-                g_shm->kolej_aktywna = 0;
-                MUTEX_SHM_UNLOCK();
+                stan_zapis_poczatek();
+                STAN_USTAW(awaria, 1);
+                STAN_USTAW(kolej_aktywna, 0);
+                stan_zapis_koniec();
 
                 MsgPracownicy odp;
                 odp.mtype = OTHER_MTYPE;
@@ -193,18 +192,24 @@ static int obsluz_prac_messages(void) {
 static void wykonaj_stop_inicjator(void) {
     /* Zgłoś awarię w SHM (tylko pierwszy inicjator ją "posiada") */
     int jestem_wlascicielem = 0;
-
-    MUTEX_SHM_LOCK();
-    if (!g_shm->awaria) {
-        g_shm->awaria = 1;
-        g_shm->kolej_aktywna = 0;
-        g_shm->stats.liczba_zatrzyman++;
-        g_shm->pid_awaria_inicjator = getpid();
+    int nowa_awaria = 0;
+    pid_t ja = getpid();
+
+    stan_zapis_poczatek();
+    if (!STAN(awaria)) {
+        STAN_USTAW(awaria, 1);
+        STAN_USTAW(kolej_aktywna, 0);
+        STAN_USTAW(pid_awaria_inicjator, ja);
         jestem_wlascicielem = 1;
-    } else if (g_shm->pid_awaria_inicjator == getpid()) {
+        nowa_awaria = 1;
+    } else if (STAN(pid_awaria_inicjator) == ja) {
         jestem_wlascicielem = 1;
     }
-    MUTEX_SHM_UNLOCK();
+    stan_zapis_koniec();
+
+    if (nowa_awaria) {
+        STAT_INC(liczba_zatrzyman);
+    }
 
     if (!jestem_wlascicielem) {
         /* Ktoś już zatrzymał kolej */
@@ -231,9 +236,7 @@ static void wykonaj_stop_inicjator(void) {
 
 static void wykonaj_start_inicjator(void) {
     /* Tylko inicjator ma prawo wznawiać */
-    MUTEX_SHM_LOCK();
-    int moja_awaria = (g_shm->pid_awaria_inicjator == getpid());
-    MUTEX_SHM_UNLOCK();
+    int moja_awaria = (STAN(pid_awaria_inicjator) == getpid());
 
     if (!moja_awaria) {
         loguj("PRACOWNIK1: Ignoruję START - nie jestem inicjatorem");
@@ -241,11 +244,9 @@ static void wykonaj_start_inicjator(void) {
     }
 
     /* Jeśli dzień się zamyka / panic - nie wznawiamy */
-    MUTEX_SHM_LOCK();
-    int faza = g_shm->faza_dnia;
-    int panic = g_shm->panic;
-    pid_t pid_p2 = g_shm->pid_pracownik2;
-    MUTEX_SHM_UNLOCK();
+    int faza = STAN(faza_dnia);
+    int panic = STAN(panic);
+    pid_t pid_p2 = STAN(pid_pracownik2);
 
     if (panic || faza != FAZA_OPEN) {
         loguj("PRACOWNIK1: START zignorowany - nie FAZA_OPEN / PANIC");
@@ -279,11 +280,11 @@ static void wykonaj_start_inicjator(void) {
     }
 
     /* Wznów kolej */
-    MUTEX_SHM_LOCK();
-    g_shm->awaria = 0;
-    g_shm->kolej_aktywna = 1;
-    g_shm->pid_awaria_inicjator = 0;
-    MUTEX_SHM_UNLOCK();
+    stan_zapis_poczatek();
+    STAN_USTAW(awaria, 0);
+    STAN_USTAW(kolej_aktywna, 1);
+    STAN_USTAW(pid_awaria_inicjator, 0);
+    stan_zapis_koniec();
 
     /* Odblokuj wszystkie procesy czekające na barierze awarii */
     odblokuj_czekajacych();
@@ -320,6 +321,7 @@ int main(int argc, char *argv[]) {
         loguj("PRACOWNIK1: Błąd dołączania do IPC");
         return EXIT_FAILURE;
     }
+    statystyki_shard_roli(STAT_ROLA_PRACOWNIK1);
 
     loguj("PRACOWNIK1: Rozpoczynam pracę");
 
@@ -10,6 +10,7 @@
 #include "types.h"
 #include "ipc.h"
 #include "utils.h"
+#include "statystyki.h"
 
 /*
  * KOLEJ KRZESEŁKOWA - PRACOWNIK 2 (Stacja górna)
@@ -57,10 +58,8 @@ static int czekaj_na_gotowy(int timeout_ms, int wymagaj_open) {
     int waited = 0;
     while (!g_koniec) {
         if (wymagaj_open) {
-            MUTEX_SHM_LOCK();
-            int faza = g_shm->faza_dnia;
-            int panic = g_shm->panic;
-            MUTEX_SHM_UNLOCK();
+            int faza = STAN(faza_dnia);
+            int panic = STAN(panic);
             if (panic || faza != FAZA_OPEN) {
                 return -2;
             }
@@ -73,10 +72,10 @@ static int czekaj_na_gotowy(int timeout_ms, int wymagaj_open) {
                 return 0;
             }
             if (msg.typ_komunikatu == MSG_TYP_STOP) {
-                MUTEX_SHM_LOCK();
-                g_shm->awaria = 1;
-                g_shm->kolej_aktywna = 0;
-                MUTEX_SHM_UNLOCK();
+                stan_zapis_poczatek();
+                STAN_USTAW(awaria, 1);
+                STAN_USTAW(kolej_aktywna, 0);
+                stan_zapis_koniec();
 
                 MsgPracownicy odp;
                 odp.mtype = OTHER_MTYPE;
@@ -106,18 +105,24 @@ static int czekaj_na_gotowy(int timeout_ms, int wymagaj_open) {
 
 static void wykonaj_stop_inicjator(void) {
     int jestem_wlascicielem = 0;
-
-    MUTEX_SHM_LOCK();
-    if (!g_shm->awaria) {
-        g_shm->awaria = 1;
-        g_shm->kolej_aktywna = 0;
-        g_shm->stats.liczba_zatrzyman++;
-        g_shm->pid_awaria_inicjator = getpid();
+    int nowa_awaria = 0;
+    pid_t ja = getpid();
+
+    stan_zapis_poczatek();
+    if (!STAN(awaria)) {
+        STAN_USTAW(awaria, 1);
+        STAN_USTAW(kolej_aktywna, 0);
+        STAN_USTAW(pid_awaria_inicjator, ja);
         jestem_wlascicielem = 1;
-    } else if (g_shm->pid_awaria_inicjator == getpid()) {
+        nowa_awaria = 1;
+    } else if (STAN(pid_awaria_inicjator) == ja) {
         jestem_wlascicielem = 1;
     }
-    MUTEX_SHM_UNLOCK();
+    stan_zapis_koniec();
+
+    if (nowa_awaria) {
+        STAT_INC(liczba_zatrzyman);
+    }
 
     if (!jestem_wlascicielem) {
         return;
@@ -140,9 +145,7 @@ static void wykonaj_stop_inicjator(void) {
 }
 
 static void wykonaj_start_inicjator(void) {
-    MUTEX_SHM_LOCK();
-    int moja_awaria = (g_shm->pid_awaria_inicjator == getpid());
-    MUTEX_SHM_UNLOCK();
+    int moja_awaria = (STAN(pid_awaria_inicjator) == getpid());
 
     if (!moja_awaria) {
         loguj("PRACOWNIK2: Ignoruję START - nie jestem inicjatorem");
@@ -150,11 +153,9 @@ static void wykonaj_start_inicjator(void) {
     }
 
     /* Jeśli dzień się zamyka / panic - nie wznawiamy */
-    MUTEX_SHM_LOCK();
-    int faza = g_shm->faza_dnia;
-    int panic = g_shm->panic;
-    pid_t pid_p1 = g_shm->pid_pracownik1;
-    MUTEX_SHM_UNLOCK();
+    int faza = STAN(faza_dnia);
+    int panic = STAN(panic);
+    pid_t pid_p1 = STAN(pid_pracownik1);
 
     if (panic || faza != FAZA_OPEN) {
         loguj("PRACOWNIK2: START zignorowany - nie FAZA_OPEN / PANIC");
@@ -186,11 +187,11 @@ static void wykonaj_start_inicjator(void) {
         return;
     }
 
-    MUTEX_SHM_LOCK();
-    g_shm->awaria = 0;
-    g_shm->kolej_aktywna = 1;
-    g_shm->pid_awaria_inicjator = 0;
-    MUTEX_SHM_UNLOCK();
+    stan_zapis_poczatek();
+    STAN_USTAW(awaria, 0);
+    STAN_USTAW(kolej_aktywna, 1);
+    STAN_USTAW(pid_awaria_inicjator, 0);
+    stan_zapis_koniec();
 
     odblokuj_czekajacych();
 
@@ -223,6 +224,7 @@ int main(int argc, char *argv[]) {
         loguj("PRACOWNIK2: Błąd dołączania do IPC");
         return EXIT_FAILURE;
     }
+    statystyki_shard_roli(STAT_ROLA_PRACOWNIK2);
 
     loguj("PRACOWNIK2: Rozpoczynam pracę");
 
@@ -248,10 +250,10 @@ int main(int argc, char *argv[]) {
         switch (msg.typ_komunikatu) {
             case MSG_TYP_STOP: {
                 loguj("PRACOWNIK2: Otrzymano STOP (od P1) - potwierdzam GOTOWY");
-                MUTEX_SHM_LOCK();
-                g_shm->awaria = 1;
-                g_shm->kolej_aktywna = 0;
-                MUTEX_SHM_UNLOCK();
+                stan_zapis_poczatek();
+                STAN_USTAW(awaria, 1);
+                STAN_USTAW(kolej_aktywna, 0);
+                stan_zapis_koniec();
 
                 MsgPracownicy odp;
                 odp.mtype = OTHER_MTYPE;
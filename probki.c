@@ -0,0 +1,195 @@
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <signal.h>
+#include <pthread.h>
+#include "probki.h"
+#include "probki_bin.h"
+#include "config.h"
+#include "types.h"
+#include "ipc.h"
+#include "utils.h"
+#include "czas.h"
+#include "obecnosc.h"
+#include "kolejki_shm.h"
+
+/*
+ * KOLEJ KRZESEŁKOWA - PRÓBKOWANIE KOLEJEK I STREF
+ * Jedna próbka = kilkanaście odczytów bez mutexa SHM (msgctl / semctl
+ * i atomowe liczniki), więc 10 ms nie obciąża symulacji. Wątek śpi do
+ * bezwzględnego terminu (clock_nanosleep), odstęp nie dryfuje; długi odstęp
+ * (do PROBKI_MS_MAX, x2 po każdej decymacji) śpi kawałkami PROBKI_KAWALEK_MS,
+ * żeby probki_zakoncz (także z panic_shutdown) nie czekało całego odstępu.
+ */
+
+/* Kolejki w kolejności kolumn (jak w monitorze) */
+static const int *g_kolejki[] = {
+    &g_mq_kasa, &g_mq_kasa_odp, &g_mq_bramka, &g_mq_bramka_odp,
+    &g_mq_peron, &g_mq_peron_odp, &g_mq_wyciag_req, &g_mq_wyciag_odp, &g_mq_prac,
+};
+#define LICZBA_KOLEJEK ((int)(sizeof(g_kolejki) / sizeof(g_kolejki[0])))
+
+static const char *g_nazwy_kolumn[] = {
+    "mq_kasa", "mq_kasa_odp", "mq_bramka", "mq_bramka_odp",
+    "mq_peron", "mq_peron_odp", "mq_wyciag_req", "mq_wyciag_odp", "mq_prac",
+    "sem_teren", "sem_peron", "sem_bariera",
+    "ob_teren", "ob_peron", "ob_krzeslo", "ob_gora",
+    "aktywni", "logi_zalegle", "skrzynki",
+};
+#define LICZBA_KOLUMN ((int)(sizeof(g_nazwy_kolumn) / sizeof(g_nazwy_kolumn[0])))
+
+_Static_assert(sizeof(g_nazwy_kolumn) / sizeof(g_nazwy_kolumn[0]) ==
+               sizeof(g_kolejki) / sizeof(g_kolejki[0]) + 10, "probki: kolumny != odczyty w probkuj()");
+_Static_assert((PROBKI_MAX & 1) == 0, "probki: PROBKI_MAX musi być parzyste");
+
+static pthread_t g_watek;
+static int g_dziala = 0;
+static int g_stop = 0;
+static int g_zapisane = 0;
+static const char *g_sciezka = NULL;
+
+static int g_interwal_startowy_ms = 0;
+static int g_interwal_ms = 0;
+static unsigned int g_decymacje = 0;
+
+/* Szereg kolumnowy (~5 MB przy PROBKI_MAX=65536, strony dotykane na bieżąco) */
+static long long g_czas[PROBKI_MAX];
+static int g_kolumny[LICZBA_KOLUMN][PROBKI_MAX];
+static int g_liczba = 0;
+
+/* Pełny bufor: zostaw co drugą próbkę, próbkuj dwa razy rzadziej */
+static void decymuj(void) {
+    int n = g_liczba / 2;
+    for (int i = 0; i < n; i++) {
+        g_czas[i] = g_czas[2 * i];
+        for (int k = 0; k < LICZBA_KOLUMN; k++) {
+            g_kolumny[k][i] = g_kolumny[k][2 * i];
+        }
+    }
+    g_liczba = n;
+    g_interwal_ms *= 2;
+    g_decymacje++;
+}
+
+static void probkuj(void) {
+    if (g_liczba == PROBKI_MAX) decymuj();
+
+    int i = g_liczba;
+    int k = 0;
+    StanObecnosci ob;
+
+    g_czas[i] = czas_mono_ns();
+    for (int q = 0; q < LICZBA_KOLEJEK; q++) {
+        g_kolumny[k++][i] = (int)msg_liczba(*g_kolejki[q]);
+    }
+    g_kolumny[k++][i] = sem_getval_ipc(SEM_TEREN);
+    g_kolumny[k++][i] = peron_wolne_sloty();
+    g_kolumny[k++][i] = sem_getval_ipc(SEM_BARIERA_AWARIA);
+
+    obecnosc_odczytaj(&ob);
+    g_kolumny[k++][i] = ob.teren;
+    g_kolumny[k++][i] = ob.peron;
+    g_kolumny[k++][i] = ob.krzeslo;
+    g_kolumny[k++][i] = ob.gora;
+
+    g_kolumny[k++][i] = __atomic_load_n(&g_shm->aktywni_klienci, __ATOMIC_RELAXED);
+    g_kolumny[k++][i] = (int)logi_oczekujace();
+    g_kolumny[k++][i] = skrzynki_zajete();
+
+    g_liczba++;
+}
+
+static void *watek_probek(void *arg) {
+    (void)arg;
+    long long termin = czas_mono_ns();
+
+    while (!__atomic_load_n(&g_stop, __ATOMIC_ACQUIRE)) {
+        probkuj();
+
+        /* Spóźnienie (wywłaszczenie) - nie nadrabiaj seriami, licz od teraz */
+        termin += (long long)g_interwal_ms * NS_NA_MS;
+        long long teraz = czas_mono_ns();
+        if (termin < teraz) termin = teraz;
+
+        /* Do terminu kawałkami - po każdym sprawdź g_stop */
+        while (!__atomic_load_n(&g_stop, __ATOMIC_ACQUIRE)) {
+            teraz = czas_mono_ns();
+            if (teraz >= termin) break;
+            long long pobudka = teraz + (long long)PROBKI_KAWALEK_MS * NS_NA_MS;
+            if (pobudka > termin) pobudka = termin;
+            struct timespec ts = {
+                .tv_sec = (time_t)(pobudka / NS_NA_SEK),
+                .tv_nsec = (long)(pobudka % NS_NA_SEK),
+            };
+            clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL);
+        }
+    }
+    return NULL;
+}
+
+int probki_start(const char *sciezka, int interwal_ms) {
+    g_sciezka = sciezka;
+    g_interwal_startowy_ms = interwal_ms;
+    g_interwal_ms = interwal_ms;
+
+    /* Sygnały obsługuje wątek główny (handlery main.c) */
+    sigset_t wszystkie, stare;
+    sigfillset(&wszystkie);
+    pthread_sigmask(SIG_BLOCK, &wszystkie, &stare);
+    int ret = pthread_create(&g_watek, NULL, watek_probek, NULL);
+    pthread_sigmask(SIG_SETMASK, &stare, NULL);
+
+    if (ret != 0) {
+        loguj("OSTRZEŻENIE: pthread_create (próbkowanie kolejek): %s", strerror(ret));
+        return -1;
+    }
+    g_dziala = 1;
+    return 0;
+}
+
+long probki_zakoncz(void) {
+    if (g_dziala) {
+        __atomic_store_n(&g_stop, 1, __ATOMIC_RELEASE);
+        pthread_join(g_watek, NULL);
+        g_dziala = 0;
+    }
+    if (g_sciezka == NULL || g_zapisane) return g_liczba;
+    g_zapisane = 1;
+
+    FILE *f = fopen(g_sciezka, "wb");
+    if (f == NULL) {
+        blad_ostrzezenie("fopen plik próbek");
+        return -1;
+    }
+
+    NaglowekProbekBin n;
+    memset(&n, 0, sizeof(n));
+    n.magic = PROBKI_BIN_MAGIC;
+    n.wersja = PROBKI_BIN_WERSJA;
+    n.liczba_kolumn = (unsigned short)LICZBA_KOLUMN;
+    n.liczba_probek = (unsigned int)g_liczba;
+    n.interwal_ms = (unsigned int)g_interwal_ms;
+    n.kotwica = g_shm->kotwica;
+    n.interwal_startowy_ms = (unsigned int)g_interwal_startowy_ms;
+    n.decymacje = g_decymacje;
+
+    char nazwy[LICZBA_KOLUMN][PROBKI_NAZWA_KOLUMNY];
+    memset(nazwy, 0, sizeof(nazwy));
+    for (int k = 0; k < LICZBA_KOLUMN; k++) {
+        strncpy(nazwy[k], g_nazwy_kolumn[k], PROBKI_NAZWA_KOLUMNY - 1);
+    }
+
+    int ok = fwrite(&n, sizeof(n), 1, f) == 1 &&
+             fwrite(nazwy, sizeof(nazwy), 1, f) == 1 &&
+             fwrite(g_czas, sizeof(g_czas[0]), (size_t)g_liczba, f) == (size_t)g_liczba;
+    for (int k = 0; ok && k < LICZBA_KOLUMN; k++) {
+        ok = fwrite(g_kolumny[k], sizeof(int), (size_t)g_liczba, f) == (size_t)g_liczba;
+    }
+    if (fclose(f) != 0) ok = 0;
+    if (!ok) {
+        blad_ostrzezenie("zapis pliku próbek");
+        return -1;
+    }
+    return g_liczba;
+}
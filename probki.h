@@ -0,0 +1,28 @@
+#ifndef PROBKI_H
+#define PROBKI_H
+
+/*
+ * KOLEJ KRZESEŁKOWA - PRÓBKOWANIE KOLEJEK I STREF (tylko main)
+ * Wątek main co interwal_ms zapisuje długości kolejek, wartości
+ * semaforów i liczniki obecności do szeregu czasowego w pamięci.
+ * Na koniec dnia szereg trafia do pliku kolumnowego (probki_bin.h);
+ * CSV: ./logdump.
+ *
+ * Bufor ma PROBKI_MAX próbek: po zapełnieniu zostaje co druga,
+ * a odstęp rośnie dwukrotnie - cały dzień zawsze mieści się w pamięci.
+ */
+
+/*
+ * Startuje wątek próbkujący; plik powstaje dopiero w probki_zakoncz
+ * Zwraca: 0=OK, -1=nie udało się uruchomić wątku
+ */
+int probki_start(const char *sciezka, int interwal_ms);
+
+/*
+ * Zatrzymuje wątek i zapisuje szereg do pliku z probki_start
+ * (można wołać wielokrotnie - zapis tylko raz)
+ * Zwraca: liczba zapisanych próbek, -1=błąd zapisu
+ */
+long probki_zakoncz(void);
+
+#endif /* PROBKI_H */
@@ -0,0 +1,35 @@
+#ifndef PROBKI_BIN_H
+#define PROBKI_BIN_H
+
+#include "types.h"
+
+/*
+ * KOLEJ KRZESEŁKOWA - BINARNY PLIK PRÓBEK (szereg czasowy kolejek / stref)
+ * Układ kolumnowy:
+ *   nagłówek (64 B)
+ *   liczba_kolumn x char[PROBKI_NAZWA_KOLUMNY]  - nazwy kolumn
+ *   long long czas_ns[liczba_probek]             - czas monotoniczny próbki
+ *   liczba_kolumn x int[liczba_probek]           - wartości kolumn
+ * Porządek bajtów maszyny, która plik zapisała; CSV robi ./logdump.
+ * Zmiana układu = podbicie PROBKI_BIN_WERSJA.
+ */
+
+#define PROBKI_BIN_MAGIC        0x53504C4Bu     // "KLPS"
+#define PROBKI_BIN_WERSJA       1
+#define PROBKI_NAZWA_KOLUMNY    16
+
+typedef struct {
+    unsigned int magic;             // PROBKI_BIN_MAGIC
+    unsigned short wersja;          // PROBKI_BIN_WERSJA
+    unsigned short liczba_kolumn;   // kolumn int (bez czasu)
+    unsigned int liczba_probek;
+    unsigned int interwal_ms;       // odstęp próbek w pliku (po decymacji)
+    KotwicaCzasu kotwica;           // g_shm->kotwica: ściana = sciana_ns + (czas_ns - mono_ns)
+    unsigned int interwal_startowy_ms;  // odstęp na początku dnia
+    unsigned int decymacje;         // ile razy bufor był przerzedzany (co 2. próbka)
+    char zarezerwowane[24];
+} NaglowekProbekBin;
+
+_Static_assert(sizeof(NaglowekProbekBin) == 64, "probki_bin: nagłówek musi mieć 64 bajty");
+
+#endif /* PROBKI_BIN_H */
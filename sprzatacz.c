@@ -144,6 +144,7 @@ static void hard_kill_remaining(void) {
     kill_by_exe_name("bramka", SIGKILL);
     kill_by_exe_name("pracownik1", SIGKILL);
     kill_by_exe_name("pracownik2", SIGKILL);
+    kill_by_exe_name("dziennik", SIGKILL);
 }
 
 int main(int argc, char *argv[]) {
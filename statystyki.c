@@ -0,0 +1,62 @@
+#include <string.h>
+#include "statystyki.h"
+
+/*
+ * KOLEJ KRZESEŁKOWA - STATYSTYKI (SHARDY)
+ *
+ * Wcześniej każdy licznik był jednym polem g_shm->stats pod mutexem SHM:
+ * kasjer, wyciąg i każdy klient serializowali się na tym samym mutexie
+ * i tej samej linii cache. Teraz:
+ * - procesy stałe piszą do stat_role[rola],
+ * - klient pisze do stat_klienci[id % STAT_SHARDY_KLIENTOW],
+ * - czytelnik (raport, monitor) sumuje shardy.
+ */
+
+/* Sumowanie traktuje Statystyki jako tablicę intów */
+_Static_assert(sizeof(Statystyki) % sizeof(int) == 0,
+               "Statystyki: sumowanie zakłada same pola int");
+
+Statystyki *g_stat = NULL;
+
+void statystyki_shard_roli(RolaStatystyk rola) {
+    if (g_shm == NULL || rola < 0 || rola >= STAT_LICZBA_ROL) return;
+    g_stat = &g_shm->stat_role[rola].s;
+}
+
+void statystyki_shard_klienta(int id_klienta) {
+    if (g_shm == NULL || id_klienta < 0) return;
+
+    int slot = id_klienta % STAT_SHARDY_KLIENTOW;
+    g_stat = &g_shm->stat_klienci[slot].s;
+
+    /* Podbij granicę sumowania (raz na klienta, nie na przejazd) */
+    int max = __atomic_load_n(&g_shm->stat_klienci_max, __ATOMIC_RELAXED);
+    while (slot + 1 > max &&
+           !__atomic_compare_exchange_n(&g_shm->stat_klienci_max, &max, slot + 1, 1,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+}
+
+static void dodaj_shard(Statystyki *wynik, const Statystyki *shard) {
+    int *dst = (int *)wynik;
+    const int *src = (const int *)shard;
+    for (size_t i = 0; i < sizeof(Statystyki) / sizeof(int); i++) {
+        dst[i] += __atomic_load_n(&src[i], __ATOMIC_RELAXED);
+    }
+}
+
+void statystyki_zsumuj(Statystyki *wynik) {
+    memset(wynik, 0, sizeof(*wynik));
+    if (g_shm == NULL) return;
+
+    for (int r = 0; r < STAT_LICZBA_ROL; r++) {
+        dodaj_shard(wynik, &g_shm->stat_role[r].s);
+    }
+
+    /* Tylko sloty, których ktoś używał - nie dotykamy reszty segmentu */
+    int max = __atomic_load_n(&g_shm->stat_klienci_max, __ATOMIC_RELAXED);
+    if (max > STAT_SHARDY_KLIENTOW) max = STAT_SHARDY_KLIENTOW;
+    for (int k = 0; k < max; k++) {
+        dodaj_shard(wynik, &g_shm->stat_klienci[k].s);
+    }
+}
@@ -0,0 +1,44 @@
+#ifndef STATYSTYKI_H
+#define STATYSTYKI_H
+
+#include "types.h"
+#include "ipc.h"
+
+/*
+ * KOLEJ KRZESEŁKOWA - STATYSTYKI (SHARDY)
+ * Każdy piszący ma własny shard w SHM (rola albo slot klienta),
+ * więc aktualizacja to jeden atomowy add bez mutexa na własnej linii cache.
+ * Wartości dla raportu/monitora daje statystyki_zsumuj().
+ */
+
+/* Shard bieżącego procesu (NULL = jeszcze nie wybrany -> STAT_ROLA_INNE) */
+extern Statystyki *g_stat;
+
+/*
+ * Wybiera shard roli dla bieżącego procesu (po attach_ipc / init_ipc)
+ */
+void statystyki_shard_roli(RolaStatystyk rola);
+
+/*
+ * Wybiera shard klienta (slot = id_klienta % STAT_SHARDY_KLIENTOW)
+ */
+void statystyki_shard_klienta(int id_klienta);
+
+static inline Statystyki *statystyki_moje(void) {
+    return g_stat != NULL ? g_stat : &g_shm->stat_role[STAT_ROLA_INNE].s;
+}
+
+/*
+ * Aktualizacja pola własnego sharda (np. STAT_INC(uzycia_tras[t]))
+ * Relaxed: liczniki nic nie synchronizują, sumę czyta się po fakcie.
+ */
+#define STAT_DODAJ(pole, n) \
+    ((void)__atomic_fetch_add(&statystyki_moje()->pole, (n), __ATOMIC_RELAXED))
+#define STAT_INC(pole)      STAT_DODAJ(pole, 1)
+
+/*
+ * Sumuje wszystkie shardy (role + używane sloty klientów)
+ */
+void statystyki_zsumuj(Statystyki *wynik);
+
+#endif /* STATYSTYKI_H */
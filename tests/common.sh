@@ -96,13 +96,37 @@ collect_results() {
     cp -a "$OUTPUT_DIR"/*.log "$outdir/" || true
   fi
   # dodatkowe raporty, jeśli istnieją
-  for f in raport.txt log_przejsc.csv log_przejsc.txt; do
+  for f in raport.txt log_przejsc.csv log_przejsc.txt log_przejsc.bin probki.bin; do
     [[ -f "$OUTPUT_DIR/$f" ]] && cp -a "$OUTPUT_DIR/$f" "$outdir/" || true
     [[ -f "$APP_DIR/$f" ]] && cp -a "$APP_DIR/$f" "$outdir/" || true
   done
   echo "$outdir"
 }
 
+# expect_main_rejects_env ZMIENNA WARTOSC WZORZEC [N T]
+# main z ZMIENNA=WARTOSC ma odmówić startu: kod != 0 i WZORZEC w jego wyjściu.
+# Kod wyjścia main trafia do ZLY_KOD (do podsumowania). Zwraca 1 (z [FAIL]), gdy main przyjął.
+ZLY_KOD=0
+expect_main_rejects_env() {
+  local zmienna="$1" wartosc="$2" wzorzec="$3" n="${4:-10}" t="${5:-1}"
+  local log="$OUTPUT_DIR/odmowa_${zmienna}.log"
+  ZLY_KOD=0
+  (cd "$APP_DIR" && env "$zmienna=$wartosc" timeout 10 ./main "$n" "$t" > "$log" 2>&1) || ZLY_KOD=$?
+  if [[ "$ZLY_KOD" -eq 0 ]] || ! grep -q "$wzorzec" "$log"; then
+    echo "[FAIL] main przyjął $zmienna=$wartosc (kod=$ZLY_KOD)" >&2
+    return 1
+  fi
+  return 0
+}
+
+# report_section NAZWA [RAPORT]
+# Sekcja raportu dziennego od nagłówka "--- NAZWA..." do pustej linii.
+# NAZWA to początek nagłówka (wystarczy prefiks ASCII, np. "ZEGAR WYCI").
+report_section() {
+  local nazwa="$1" raport="${2:-$OUTPUT_DIR/raport_dzienny.txt}"
+  sed -n "/^--- ${nazwa}/,/^\$/p" "$raport" 2>/dev/null || true
+}
+
 print_hint_screenshots() {
   local outdir="$1"
   cat <<MSG
@@ -15,6 +15,17 @@ TESTS=(
   test7_sigterm_klient_na_peronie_semundo
   test8_crash_main_sprzatacz_cleanup
   test9_wkrzesle_range_i_drain_zero
+  test10_transport_shm
+  test11_kontrola_obecnosci
+  test12_dziennik_zdarzen
+  test13_log_przejsc_strumien
+  test14_histogramy_etapow
+  test15_monitor_eksport
+  test16_probkowanie_kolejek
+  test17_zegar_wyciagu
+  test18_pakowanie_rzedow
+  test19_geometria_wyciagu
+  test20_linie_wyciagu
 )
 
 total=${#TESTS[@]}
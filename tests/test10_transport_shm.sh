@@ -0,0 +1,73 @@
+#!/usr/bin/env bash
+set -euo pipefail
+# Test 10 – Transport SHM (KOLEJ_TRANSPORT=shm)
+# - kolejki kasa/bramka/peron/wyciag_req idą pierścieniami w pamięci współdzielonej
+# - przepływ klientów musi być taki sam jak na SysV: BOARD == ARRIVE > 0
+# - po końcu dnia segment pierścieni musi zniknąć z ipcs
+
+source "$(dirname "$0")/common.sh"
+
+TEST_NAME="test10_transport_shm"
+
+reset_logs
+build_project
+
+N="${1:-60}"
+T="${2:-8}"
+
+echo "== $TEST_NAME =="
+
+export KOLEJ_TRANSPORT=shm
+run_main_bg "$N" "$T" 3000 300
+PID="$RUN_MAIN_PID"
+wait_main "$PID" || true
+
+OUTDIR="$(collect_results "$TEST_NAME")"
+
+MAIN_LOG="$OUTPUT_DIR/main.log"
+KLIENCI_LOG="$OUTPUT_DIR/klienci.log"
+
+transport_line="$(grep -a -m1 "Transport komunikatów:" "$MAIN_LOG" 2>/dev/null || true)"
+shmq_id="$(grep -a -m1 "Kolejki SHM utworzone" "$MAIN_LOG" 2>/dev/null | sed -nE 's/.*\(id=([0-9]+),.*/\1/p' || true)"
+
+board_cnt="$(grep -aoE 'KLIENT[[:space:]]+[0-9]+:[[:space:]]+BOARD\b' "$KLIENCI_LOG" 2>/dev/null | wc -l | tr -d ' ')"
+arrive_cnt="$(grep -aoE 'KLIENT[[:space:]]+[0-9]+:[[:space:]]+ARRIVE\b' "$KLIENCI_LOG" 2>/dev/null | wc -l | tr -d ' ')"
+
+segment_po=""
+if [[ -n "$shmq_id" ]]; then
+  segment_po="$(ipcs -m 2>/dev/null | awk -v id="$shmq_id" '$2 == id' || true)"
+fi
+
+{
+  echo "TEST10: transport SHM (pierścienie + futex)"
+  echo "N=$N, CZAS=$T"
+  echo
+  echo "[MAIN] ${transport_line:-BRAK}"
+  echo "[MAIN] id segmentu pierścieni: ${shmq_id:-?}"
+  echo
+  echo "BOARD events:  $board_cnt"
+  echo "ARRIVE events: $arrive_cnt"
+  echo
+  echo "[IPC] segment pierścieni po zakończeniu: ${segment_po:-usunięty}"
+} > "$OUTDIR/summary.txt"
+
+fail=0
+if [[ "$transport_line" != *"shm"* || -z "$shmq_id" ]]; then
+  echo "[FAIL] main nie wybrał transportu SHM (${transport_line:-brak wpisu})" >&2
+  fail=1
+fi
+if [[ "$board_cnt" -le 0 ]]; then
+  echo "[FAIL] Brak zdarzeń BOARD (board_cnt=$board_cnt)" >&2
+  fail=1
+fi
+if [[ "$board_cnt" -ne "$arrive_cnt" ]]; then
+  echo "[FAIL] BOARD($board_cnt) != ARRIVE($arrive_cnt)" >&2
+  fail=1
+fi
+if [[ -n "$segment_po" ]]; then
+  echo "[FAIL] Segment pierścieni nie został usunięty: $segment_po" >&2
+  fail=1
+fi
+
+print_hint_screenshots "$OUTDIR"
+exit "$fail"
@@ -0,0 +1,63 @@
+#!/usr/bin/env bash
+set -euo pipefail
+# Test 11 – Kontrola niezmienników liczników stref (KOLEJ_KONTROLA_OBECNOSCI=1)
+# - każde przeniesienie sprawdza: strefa źródłowa >= k, suma stref <= wpuszczeni - wyszli
+# - po końcu dnia wszystkie strefy puste i wpuszczeni == wyszli
+# - w main.log nie może być żadnego "OBECNOSC: NARUSZENIE"
+
+source "$(dirname "$0")/common.sh"
+
+TEST_NAME="test11_kontrola_obecnosci"
+
+reset_logs
+build_project
+
+N="${1:-60}"
+T="${2:-8}"
+
+echo "== $TEST_NAME =="
+
+export KOLEJ_KONTROLA_OBECNOSCI=1
+run_main_bg "$N" "$T" 3000 300
+PID="$RUN_MAIN_PID"
+wait_main "$PID" || true
+
+OUTDIR="$(collect_results "$TEST_NAME")"
+
+MAIN_LOG="$OUTPUT_DIR/main.log"
+
+kontrola_line="$(grep -a -m1 "Kontrola niezmienników obecności" "$MAIN_LOG" 2>/dev/null || true)"
+bilans_line="$(grep -a -m1 "OBECNOSC: bilans końcowy" "$MAIN_LOG" 2>/dev/null || true)"
+naruszenia_cnt="$(grep -ac "OBECNOSC: NARUSZENIE" "$MAIN_LOG" 2>/dev/null || true)"
+wpuszczeni="$(sed -nE 's/.*wpuszczeni=([0-9]+).*/\1/p' <<<"$bilans_line")"
+
+{
+  echo "TEST11: kontrola niezmienników obecności"
+  echo "N=$N, CZAS=$T"
+  echo
+  echo "[MAIN] ${kontrola_line:-BRAK}"
+  echo "[MAIN] ${bilans_line:-BRAK}"
+  echo "Naruszenia w logu: $naruszenia_cnt"
+} > "$OUTDIR/summary.txt"
+
+fail=0
+if [[ -z "$kontrola_line" ]]; then
+  echo "[FAIL] main nie włączył kontroli obecności" >&2
+  fail=1
+fi
+if [[ "$bilans_line" != *"-> OK"* ]]; then
+  echo "[FAIL] Bilans końcowy nie jest OK (${bilans_line:-brak wpisu})" >&2
+  fail=1
+fi
+if [[ "${wpuszczeni:-0}" -le 0 ]]; then
+  echo "[FAIL] Nikt nie wszedł na teren (wpuszczeni=${wpuszczeni:-?})" >&2
+  fail=1
+fi
+if [[ "$naruszenia_cnt" -ne 0 ]]; then
+  echo "[FAIL] Wykryto naruszenia niezmienników: $naruszenia_cnt" >&2
+  grep -a -m5 "OBECNOSC: NARUSZENIE" "$MAIN_LOG" >&2 || true
+  fail=1
+fi
+
+print_hint_screenshots "$OUTDIR"
+exit "$fail"
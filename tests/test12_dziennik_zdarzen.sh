@@ -0,0 +1,93 @@
+#!/usr/bin/env bash
+set -euo pipefail
+# Test 12 – Dziennik zdarzeń (KOLEJ_LOG_DZIENNIK=1)
+# - gorące wiersze idą pierścieniem w SHM do procesu dziennika
+# - klienci.log ma ten sam format co przy loguj(): BOARD == ARRIVE > 0
+# - każdy wiersz kompletny: "[HH:MM:SS.mmm][PID n] ..."
+# - dziennik kończy się sam po opróżnieniu pierścienia, IPC sprzątnięte
+
+source "$(dirname "$0")/common.sh"
+
+TEST_NAME="test12_dziennik_zdarzen"
+
+reset_logs
+build_project
+
+N="${1:-60}"
+T="${2:-8}"
+
+echo "== $TEST_NAME =="
+
+export KOLEJ_LOG_DZIENNIK=1
+run_main_bg "$N" "$T" 3000 300
+PID="$RUN_MAIN_PID"
+wait_main "$PID" || true
+
+OUTDIR="$(collect_results "$TEST_NAME")"
+
+MAIN_LOG="$OUTPUT_DIR/main.log"
+KLIENCI_LOG="$OUTPUT_DIR/klienci.log"
+KASA_LOG="$OUTPUT_DIR/kasa.log"
+
+start_line="$(grep -a -m1 "Dziennik uruchomiony" "$MAIN_LOG" 2>/dev/null || true)"
+koniec_line="$(grep -a -m1 "DZIENNIK: Kończę pracę" "$MAIN_LOG" 2>/dev/null || true)"
+zapisane="$(sed -nE 's/.*zapisane zdarzenia=([0-9]+).*/\1/p' <<< "$koniec_line")"
+shm_id="$(grep -a -m1 "Pamięć współdzielona utworzona" "$MAIN_LOG" 2>/dev/null | sed -nE 's/.*\(id=([0-9]+),.*/\1/p' || true)"
+
+board_cnt="$(grep -acE 'KLIENT[[:space:]]+[0-9]+:[[:space:]]+BOARD\b' "$KLIENCI_LOG" 2>/dev/null || true)"
+arrive_cnt="$(grep -acE 'KLIENT[[:space:]]+[0-9]+:[[:space:]]+ARRIVE\b' "$KLIENCI_LOG" 2>/dev/null || true)"
+sprzedaz_cnt="$(grep -ac 'KASJER: SPRZEDAŻ' "$KASA_LOG" 2>/dev/null || true)"
+zle_wiersze="$(grep -avcE '^\[[0-9]{2}:[0-9]{2}:[0-9]{2}\.[0-9]{3}\]\[PID [0-9]+\] ' "$KLIENCI_LOG" 2>/dev/null || true)"
+
+segment_po=""
+if [[ -n "$shm_id" ]]; then
+  segment_po="$(ipcs -m 2>/dev/null | awk -v id="$shm_id" '$2 == id' || true)"
+fi
+
+{
+  echo "TEST12: dziennik zdarzeń (pierścień SHM + proces dziennika)"
+  echo "N=$N, CZAS=$T"
+  echo
+  echo "[MAIN] ${start_line:-BRAK}"
+  echo "[MAIN] ${koniec_line:-BRAK}"
+  echo
+  echo "BOARD events:     $board_cnt"
+  echo "ARRIVE events:    $arrive_cnt"
+  echo "SPRZEDAŻ (kasa):  $sprzedaz_cnt"
+  echo "Wiersze bez prefiksu w klienci.log: $zle_wiersze"
+  echo
+  echo "[IPC] segment SHM po zakończeniu: ${segment_po:-usunięty}"
+} > "$OUTDIR/summary.txt"
+
+fail=0
+if [[ -z "$start_line" ]]; then
+  echo "[FAIL] main nie uruchomił dziennika" >&2
+  fail=1
+fi
+if [[ -z "$zapisane" || "$zapisane" -le 0 ]]; then
+  echo "[FAIL] Dziennik nie zakończył się poprawnie albo nic nie zapisał (${koniec_line:-brak wpisu})" >&2
+  fail=1
+fi
+if [[ "$board_cnt" -le 0 ]]; then
+  echo "[FAIL] Brak zdarzeń BOARD (board_cnt=$board_cnt)" >&2
+  fail=1
+fi
+if [[ "$board_cnt" -ne "$arrive_cnt" ]]; then
+  echo "[FAIL] BOARD($board_cnt) != ARRIVE($arrive_cnt)" >&2
+  fail=1
+fi
+if [[ "$sprzedaz_cnt" -le 0 ]]; then
+  echo "[FAIL] Brak wierszy sprzedaży w kasa.log" >&2
+  fail=1
+fi
+if [[ "$zle_wiersze" -ne 0 ]]; then
+  echo "[FAIL] $zle_wiersze wierszy klienci.log bez prefiksu [czas][PID] (przeplecione zapisy?)" >&2
+  fail=1
+fi
+if [[ -n "$segment_po" ]]; then
+  echo "[FAIL] Segment SHM nie został usunięty: $segment_po" >&2
+  fail=1
+fi
+
+print_hint_screenshots "$OUTDIR"
+exit "$fail"
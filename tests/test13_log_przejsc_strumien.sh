@@ -0,0 +1,88 @@
+#!/usr/bin/env bash
+set -euo pipefail
+# Test 13 – Log przejść jako strumień (pierścień w SHM + drenaż w main)
+# - log_przejsc.bin rośnie w trakcie dnia (nie dopiero w raporcie)
+# - rozmiar = nagłówek 64 B + 16 B na wpis, ./logdump daje tyle samo wierszy CSV
+# - liczba wpisów = "Log przejść zapisany ... (N wpisów)", nic nie zgubione
+# - każde ARRIVE klienta ma swój wpis WYJSCIE_GORA
+
+source "$(dirname "$0")/common.sh"
+
+TEST_NAME="test13_log_przejsc_strumien"
+
+reset_logs
+build_project
+
+N="${1:-60}"
+T="${2:-8}"
+
+echo "== $TEST_NAME =="
+
+LOG_PRZEJSC="$OUTPUT_DIR/log_przejsc.bin"
+rm -f "$LOG_PRZEJSC"
+
+run_main_bg "$N" "$T" 3000 300
+PID="$RUN_MAIN_PID"
+
+# W połowie dnia plik musi już mieć wpisy (nagłówek + dane)
+sleep $(( T / 2 ))
+bajty_w_trakcie="$(stat -c %s "$LOG_PRZEJSC" 2>/dev/null || echo 0)"
+
+wait_main "$PID" || true
+
+OUTDIR="$(collect_results "$TEST_NAME")"
+
+MAIN_LOG="$OUTPUT_DIR/main.log"
+KLIENCI_LOG="$OUTPUT_DIR/klienci.log"
+RAPORT="$OUTPUT_DIR/raport_dzienny.txt"
+
+zapisany_line="$(grep -a -m1 "Log przejść zapisany do:" "$MAIN_LOG" 2>/dev/null || true)"
+wpisy_main="$(sed -nE 's/.*\(([0-9]+) wpisów\).*/\1/p' <<< "$zapisany_line")"
+bajty="$(stat -c %s "$LOG_PRZEJSC" 2>/dev/null || echo 0)"
+CSV="$OUTDIR/log_przejsc.csv"
+(cd "$APP_DIR" && ./logdump "$LOG_PRZEJSC" "$CSV") 2>/dev/null || true
+wpisy_plik=$(( $( (wc -l < "$CSV") 2>/dev/null || echo 1) - 1 ))
+raport_line="$(grep -a -m1 "Wpisy logu przejść:" "$RAPORT" 2>/dev/null || true)"
+zgubione="$(sed -nE 's/.*zgubione=([0-9]+).*/\1/p' <<< "$raport_line")"
+
+arrive_cnt="$(grep -acE 'KLIENT[[:space:]]+[0-9]+:[[:space:]]+ARRIVE\b' "$KLIENCI_LOG" 2>/dev/null || true)"
+wyjscia_cnt="$(grep -ac ';WYJSCIE_GORA;' "$CSV" 2>/dev/null || true)"
+
+{
+  echo "TEST13: log przejść drenowany w trakcie dnia"
+  echo "N=$N, CZAS=$T"
+  echo
+  echo "Bajty log_przejsc.bin w połowie dnia: $bajty_w_trakcie"
+  echo "[MAIN] ${zapisany_line:-BRAK}"
+  echo "Bajty po zakończeniu: $bajty"
+  echo "Wiersze CSV (logdump): $wpisy_plik"
+  echo "[RAPORT] ${raport_line:-BRAK}"
+  echo
+  echo "ARRIVE events:      $arrive_cnt"
+  echo "WYJSCIE_GORA wpisy: $wyjscia_cnt"
+} > "$OUTDIR/summary.txt"
+
+fail=0
+if [[ "$bajty_w_trakcie" -le 64 ]]; then
+  echo "[FAIL] log_przejsc.bin pusty w trakcie dnia (bajty=$bajty_w_trakcie)" >&2
+  fail=1
+fi
+if [[ -z "$wpisy_main" || "$bajty" -ne $(( 64 + 16 * wpisy_main )) ]]; then
+  echo "[FAIL] main zgłosił ${wpisy_main:-?} wpisów, plik ma $bajty bajtów" >&2
+  fail=1
+fi
+if [[ -z "$wpisy_main" || "$wpisy_main" -ne "$wpisy_plik" ]]; then
+  echo "[FAIL] main zgłosił ${wpisy_main:-?} wpisów, logdump dał $wpisy_plik wierszy" >&2
+  fail=1
+fi
+if [[ "$zgubione" != "0" ]]; then
+  echo "[FAIL] Zgubione wpisy logu przejść (${raport_line:-brak wiersza w raporcie})" >&2
+  fail=1
+fi
+if [[ "$arrive_cnt" -le 0 || "$arrive_cnt" -ne "$wyjscia_cnt" ]]; then
+  echo "[FAIL] ARRIVE($arrive_cnt) != WYJSCIE_GORA($wyjscia_cnt)" >&2
+  fail=1
+fi
+
+print_hint_screenshots "$OUTDIR"
+exit "$fail"
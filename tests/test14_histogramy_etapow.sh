@@ -0,0 +1,66 @@
+#!/usr/bin/env bash
+set -euo pipefail
+# Test 14 – Histogramy czasów etapów klienta (HDR w SHM)
+# - raport_dzienny.txt ma sekcję "CZASY ETAPÓW" z wierszami KASA..PRZEJAZD
+# - suma pomiarów PRZEJAZD (wszystkie klasy) == liczba ARRIVE w klienci.log
+# - w każdym wierszu p50 <= p90 <= p99 <= p99.9 <= max
+
+source "$(dirname "$0")/common.sh"
+
+TEST_NAME="test14_histogramy_etapow"
+
+reset_logs
+build_project
+
+N="${1:-60}"
+T="${2:-8}"
+
+echo "== $TEST_NAME =="
+
+run_main_bg "$N" "$T" 3000 300
+PID="$RUN_MAIN_PID"
+wait_main "$PID" || true
+
+OUTDIR="$(collect_results "$TEST_NAME")"
+
+KLIENCI_LOG="$OUTPUT_DIR/klienci.log"
+RAPORT="$OUTPUT_DIR/raport_dzienny.txt"
+
+# Wiersze tabeli: ETAP KLASA LICZBA srednia p50 p90 p99 p99.9 max
+tabela="$(report_section "CZASY ETAPÓW" "$RAPORT" | grep -aE '^(KASA|BRAMKA1|PERON|BOARD|PRZEJAZD) ' || true)"
+
+arrive_cnt="$(grep -acE 'KLIENT[[:space:]]+[0-9]+:[[:space:]]+ARRIVE\b' "$KLIENCI_LOG" 2>/dev/null || true)"
+przejazd_cnt="$(awk '$1 == "PRZEJAZD" { s += $3 } END { print s + 0 }' <<< "$tabela")"
+etapy="$(awk '{ print $1 }' <<< "$tabela" | sort -u | tr '\n' ' ')"
+nieuporzadkowane="$(awk '!($5 <= $6 && $6 <= $7 && $7 <= $8 && $8 <= $9) { n++ } END { print n + 0 }' <<< "$tabela")"
+
+{
+  echo "TEST14: histogramy czasów etapów"
+  echo "N=$N, CZAS=$T"
+  echo
+  echo "$tabela"
+  echo
+  echo "Etapy w raporcie:     $etapy"
+  echo "ARRIVE events:        $arrive_cnt"
+  echo "PRZEJAZD pomiary:     $przejazd_cnt"
+  echo "Wiersze z p50>..>max: $nieuporzadkowane"
+} > "$OUTDIR/summary.txt"
+
+fail=0
+for e in KASA BRAMKA1 PERON BOARD PRZEJAZD; do
+  if ! grep -qw "$e" <<< "$etapy"; then
+    echo "[FAIL] Brak etapu $e w raporcie" >&2
+    fail=1
+  fi
+done
+if [[ "$arrive_cnt" -le 0 || "$przejazd_cnt" -ne "$arrive_cnt" ]]; then
+  echo "[FAIL] PRZEJAZD pomiary($przejazd_cnt) != ARRIVE($arrive_cnt)" >&2
+  fail=1
+fi
+if [[ "$nieuporzadkowane" -ne 0 ]]; then
+  echo "[FAIL] $nieuporzadkowane wierszy z percentylami nie rosnącymi" >&2
+  fail=1
+fi
+
+print_hint_screenshots "$OUTDIR"
+exit "$fail"
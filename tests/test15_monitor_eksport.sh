@@ -0,0 +1,89 @@
+#!/usr/bin/env bash
+set -euo pipefail
+# Test 15 – Eksport metryk z monitora (--format=json / --format=prom)
+# - json: jeden kompletny obiekt w wierszu na interwał, z semaforami, kolejkami i procesami
+# - prom: plik podmieniany atomowo, HELP/TYPE + metryki z etykietami, main żyje
+# - monitor kończy się sam po końcu dnia (main nie żyje)
+
+source "$(dirname "$0")/common.sh"
+
+TEST_NAME="test15_monitor_eksport"
+
+reset_logs
+build_project
+
+N="${1:-40}"
+T="${2:-6}"
+
+echo "== $TEST_NAME =="
+
+JSONL="$OUTPUT_DIR/metryki.jsonl"
+PROM="$OUTPUT_DIR/kolej.prom"
+rm -f "$JSONL" "$PROM"
+
+run_main_bg "$N" "$T" 3000 300
+PID="$RUN_MAIN_PID"
+sleep 1
+
+(cd "$APP_DIR" && ./monitor --format=json --output "$JSONL" --interval-ms 250 >/dev/null 2>&1) &
+MON_JSON=$!
+(cd "$APP_DIR" && ./monitor --format=prom --output "$PROM" --interval-ms 250 >/dev/null 2>&1) &
+MON_PROM=$!
+
+sleep 2
+prom_w_trakcie="$(cat "$PROM" 2>/dev/null || true)"
+
+wait_main "$PID" || true
+
+# Monitory muszą wyjść same (main nie żyje / IPC usunięte)
+monitory_zyja=0
+for _ in $(seq 1 20); do
+  if ! kill -0 "$MON_JSON" 2>/dev/null && ! kill -0 "$MON_PROM" 2>/dev/null; then break; fi
+  sleep 0.5
+done
+if kill -0 "$MON_JSON" 2>/dev/null || kill -0 "$MON_PROM" 2>/dev/null; then
+  monitory_zyja=1
+  kill "$MON_JSON" "$MON_PROM" 2>/dev/null || true
+fi
+
+OUTDIR="$(collect_results "$TEST_NAME")"
+cp -f "$JSONL" "$OUTDIR/" 2>/dev/null || true
+printf '%s\n' "$prom_w_trakcie" > "$OUTDIR/kolej.prom"
+
+json_wiersze="$( (wc -l < "$JSONL") 2>/dev/null || echo 0)"
+json_zle="$(grep -avcE '^\{"czas_ms":[0-9]+,.*"semafory":\{"teren":-?[0-9]+,"peron":-?[0-9]+,"bariera_awaria":-?[0-9]+\}.*"kolejki":\{"kasa":\{"qnum":-?[0-9]+.*"procesy":\{"main":\{"pid":[0-9]+,"zyje":[01]\}.*\]\}$' "$JSONL" 2>/dev/null || true)"
+prom_typy="$(grep -ac '^# TYPE kolej_' <<< "$prom_w_trakcie" || true)"
+prom_main="$(grep -aE '^kolej_proces_zyje\{proces="main",pid="[0-9]+"\} 1$' <<< "$prom_w_trakcie" || true)"
+prom_sem="$(grep -acE '^kolej_semafor\{sem="(teren|peron|bariera_awaria)"\} -?[0-9]+$' <<< "$prom_w_trakcie" || true)"
+
+{
+  echo "TEST15: eksport metryk monitora"
+  echo "N=$N, CZAS=$T"
+  echo
+  echo "JSON wiersze:            $json_wiersze (niepoprawne: $json_zle)"
+  echo "PROM # TYPE:             $prom_typy"
+  echo "PROM semafory:           $prom_sem"
+  echo "PROM main:               ${prom_main:-BRAK}"
+  echo "Monitory po końcu dnia:  $([[ $monitory_zyja -eq 0 ]] && echo zakończone || echo 'NADAL DZIAŁAŁY')"
+} > "$OUTDIR/summary.txt"
+
+fail=0
+if [[ "$json_wiersze" -lt 2 ]]; then
+  echo "[FAIL] Za mało rekordów JSON ($json_wiersze)" >&2
+  fail=1
+fi
+if [[ "$json_zle" -ne 0 ]]; then
+  echo "[FAIL] $json_zle niekompletnych / niepoprawnych wierszy JSON" >&2
+  fail=1
+fi
+if [[ "$prom_typy" -le 0 || "$prom_sem" -ne 3 || -z "$prom_main" ]]; then
+  echo "[FAIL] Plik Prometheusa niekompletny (TYPE=$prom_typy, semafory=$prom_sem)" >&2
+  fail=1
+fi
+if [[ "$monitory_zyja" -ne 0 ]]; then
+  echo "[FAIL] Monitor nie zakończył się po końcu dnia" >&2
+  fail=1
+fi
+
+print_hint_screenshots "$OUTDIR"
+exit "$fail"
@@ -0,0 +1,96 @@
+#!/usr/bin/env bash
+set -euo pipefail
+# Test 16 – Próbkowanie kolejek / semaforów / stref (szereg czasowy w main)
+# - KOLEJ_PROBKI_MS=20: main zapisuje probki.bin na koniec dnia
+# - ./logdump robi z niego CSV: tyle wierszy, ile próbek zgłosił main
+# - próbek >= ~CZAS / odstęp, T_MS rośnie ściśle
+# - liczniki mają sens: 0 < max(ob_teren) <= N, max(aktywni) > 0
+
+source "$(dirname "$0")/common.sh"
+
+TEST_NAME="test16_probkowanie_kolejek"
+
+reset_logs
+build_project
+
+N="${1:-60}"
+T="${2:-8}"
+ODSTEP_MS=20
+
+echo "== $TEST_NAME =="
+
+PROBKI="$OUTPUT_DIR/probki.bin"
+rm -f "$PROBKI"
+
+export KOLEJ_PROBKI_MS="$ODSTEP_MS"
+run_main_bg "$N" "$T" 3000 300
+PID="$RUN_MAIN_PID"
+wait_main "$PID" || true
+unset KOLEJ_PROBKI_MS
+
+OUTDIR="$(collect_results "$TEST_NAME")"
+
+MAIN_LOG="$OUTPUT_DIR/main.log"
+CSV="$OUTDIR/probki.csv"
+
+zapisane_line="$(grep -a -m1 "Próbki kolejek zapisane do:" "$MAIN_LOG" 2>/dev/null || true)"
+probki_main="$(sed -nE 's/.*\(([0-9]+) próbek\).*/\1/p' <<< "$zapisane_line")"
+(cd "$APP_DIR" && ./logdump "$PROBKI" "$CSV") 2>/dev/null || true
+wiersze_csv=$(( $( (wc -l < "$CSV") 2>/dev/null || echo 1) - 1 ))
+naglowek="$(head -n1 "$CSV" 2>/dev/null || true)"
+
+# Kolumny po nazwie z nagłówka CSV
+read -r niemonotoniczne max_teren max_aktywni < <(awk -F';' '
+  NR == 1 { for (i = 1; i <= NF; i++) kol[$i] = i; next }
+  {
+    if (NR > 2 && $1 <= poprz) zle++
+    poprz = $1
+    if ($(kol["ob_teren"]) > mt) mt = $(kol["ob_teren"])
+    if ($(kol["aktywni"]) > ma) ma = $(kol["aktywni"])
+  }
+  END { print zle + 0, mt + 0, ma + 0 }' "$CSV" 2>/dev/null || echo "? 0 0")
+
+oczekiwane=$(( T * 1000 / ODSTEP_MS ))
+
+{
+  echo "TEST16: próbkowanie kolejek i stref"
+  echo "N=$N, CZAS=$T, KOLEJ_PROBKI_MS=$ODSTEP_MS"
+  echo
+  echo "[MAIN] ${zapisane_line:-BRAK}"
+  echo "Wiersze CSV (logdump): $wiersze_csv (nominalnie ~$oczekiwane)"
+  echo "Nagłówek CSV: $naglowek"
+  echo "T_MS nierosnące: $niemonotoniczne"
+  echo "max ob_teren: $max_teren, max aktywni: $max_aktywni"
+} > "$OUTDIR/summary.txt"
+
+fail=0
+if [[ -z "$probki_main" || "$probki_main" -ne "$wiersze_csv" ]]; then
+  echo "[FAIL] main zgłosił ${probki_main:-?} próbek, logdump dał $wiersze_csv wierszy" >&2
+  fail=1
+fi
+# 1 CPU / wywłaszczenia: wystarczy połowa nominalnej liczby (więcej = próbki z drenowania po końcu dnia)
+if [[ "$wiersze_csv" -lt $(( oczekiwane / 2 )) ]]; then
+  echo "[FAIL] $wiersze_csv próbek, oczekiwano ~$oczekiwane" >&2
+  fail=1
+fi
+for k in mq_kasa mq_peron mq_wyciag_req sem_teren ob_teren ob_krzeslo aktywni; do
+  if ! grep -q ";$k\(;\|$\)" <<< "$naglowek"; then
+    echo "[FAIL] brak kolumny $k w CSV" >&2
+    fail=1
+  fi
+done
+if [[ "$niemonotoniczne" != "0" ]]; then
+  echo "[FAIL] T_MS nie rośnie ściśle ($niemonotoniczne wierszy)" >&2
+  fail=1
+fi
+if [[ "$max_teren" -le 0 || "$max_teren" -gt "$N" ]]; then
+  echo "[FAIL] max ob_teren=$max_teren poza (0, $N]" >&2
+  fail=1
+fi
+if [[ "$max_aktywni" -le 0 ]]; then
+  echo "[FAIL] max aktywni=$max_aktywni - próbki nie widziały klientów" >&2
+  fail=1
+fi
+
+print_hint_screenshots "$OUTDIR"
+exit "$fail"
@@ -0,0 +1,87 @@
+#!/usr/bin/env bash
+set -euo pipefail
+# Test 17 – Zegar wyciągu (bezwzględne terminy ticków + tryby nadrabiania)
+# - nieznany KOLEJ_WYCIAG_NADRABIANIE: main odmawia startu
+# - seria (domyślnie): tempo ticków >= 95% nominalnego
+# - pomin: ticki + pominięte terminy ~ czas / interwał (nic nie ginie bez śladu)
+# - w obu trybach histogram opóźnień ma pomiar na każdy tick
+
+source "$(dirname "$0")/common.sh"
+
+TEST_NAME="test17_zegar_wyciagu"
+
+reset_logs
+build_project
+
+N="${1:-60}"
+T="${2:-6}"
+
+echo "== $TEST_NAME =="
+
+RAPORT="$OUTPUT_DIR/raport_dzienny.txt"
+
+fail=0
+expect_main_rejects_env KOLEJ_WYCIAG_NADRABIANIE zly "Nieznany KOLEJ_WYCIAG_NADRABIANIE" "$N" "$T" || fail=1
+zly_kod="$ZLY_KOD"
+
+# Sekcja raportu -> "tryb ticki sekundy nominalnie/s procent zalegle pominiete opoznienie_liczba"
+zegar_z_raportu() {
+  report_section "ZEGAR WYCI" "$RAPORT" | awk '
+    /^Tryb nadrabiania:/ { tryb = $3 }
+    /^Ticki:/ { ticki = $2; sek = $4; nom = $8; sub(/\/s/, "", nom); pr = $NF; gsub(/[%)]/, "", pr) }
+    /^Zaleg/ { zal = $(NF - 2); pom = $NF }
+    /^opoznienie / { op = $2 }
+    END { print (tryb ? tryb : "?"), ticki + 0, sek + 0, nom + 0, pr + 0, zal + 0, pom + 0, op + 0 }'
+}
+
+declare -A wynik
+for tryb in seria pomin; do
+  export KOLEJ_WYCIAG_NADRABIANIE="$tryb"
+  run_main_bg "$N" "$T" 3000 300
+  wait_main "$RUN_MAIN_PID" || true
+  unset KOLEJ_WYCIAG_NADRABIANIE
+  wynik[$tryb]="$(zegar_z_raportu)"
+  cp -a "$RAPORT" "$OUTPUT_DIR/raport_$tryb.txt" 2>/dev/null || true
+done
+
+OUTDIR="$(collect_results "$TEST_NAME")"
+cp -a "$OUTPUT_DIR"/raport_seria.txt "$OUTPUT_DIR"/raport_pomin.txt "$OUTDIR/" 2>/dev/null || true
+
+read -r s_tryb s_ticki s_sek s_nom s_proc s_zal s_pom s_op <<< "${wynik[seria]}"
+read -r p_tryb p_ticki p_sek p_nom p_proc p_zal p_pom p_op <<< "${wynik[pomin]}"
+p_terminy=$(( p_ticki + p_pom ))
+p_nominalnie="$(awk -v s="$p_sek" -v n="$p_nom" 'BEGIN { printf "%d", s * n + 1 }')"
+
+{
+  echo "TEST17: zegar wyciągu"
+  echo "N=$N, CZAS=$T"
+  echo
+  echo "Zły tryb: kod wyjścia main=$zly_kod"
+  echo "seria: tryb=$s_tryb ticki=$s_ticki w ${s_sek}s (${s_proc}% nominalnego) zalegle=$s_zal pominiete=$s_pom opoznienie.liczba=$s_op"
+  echo "pomin: tryb=$p_tryb ticki=$p_ticki w ${p_sek}s (${p_proc}% nominalnego) zalegle=$p_zal pominiete=$p_pom opoznienie.liczba=$p_op"
+  echo "pomin: ticki+pominiete=$p_terminy, terminów w czasie pracy ~$p_nominalnie"
+} > "$OUTDIR/summary.txt"
+
+if [[ "$s_tryb" != "seria" || "$p_tryb" != "pomin" ]]; then
+  echo "[FAIL] raport nie pokazuje wybranego trybu (seria=$s_tryb, pomin=$p_tryb)" >&2
+  fail=1
+fi
+if ! awk -v p="$s_proc" 'BEGIN { exit !(p >= 95.0) }'; then
+  echo "[FAIL] seria: tempo ticków ${s_proc}% < 95% nominalnego" >&2
+  fail=1
+fi
+for t in s p; do
+  ticki_var="${t}_ticki"; op_var="${t}_op"
+  if [[ "${!ticki_var}" -le 0 || "${!ticki_var}" -ne "${!op_var}" ]]; then
+    echo "[FAIL] $t: ticki=${!ticki_var}, pomiary opóźnienia=${!op_var}" >&2
+    fail=1
+  fi
+done
+# pomin: każdy termin to tick albo pominięcie (tolerancja 2%)
+if ! awk -v a="$p_terminy" -v b="$p_nominalnie" 'BEGIN { d = a - b; if (d < 0) d = -d; exit !(b > 0 && d <= b * 0.02 + 2) }'; then
+  echo "[FAIL] pomin: ticki+pominiete=$p_terminy, oczekiwano ~$p_nominalnie" >&2
+  fail=1
+fi
+
+print_hint_screenshots "$OUTDIR"
+exit "$fail"
@@ -0,0 +1,143 @@
+#!/usr/bin/env bash
+set -euo pipefail
+# Test 18 – Polityki pakowania rzędu (KOLEJ_PAKOWANIE)
+# - nieznana polityka: main odmawia startu
+# - zachlanna / ffd / dokladna: raport pokazuje wybraną politykę
+# - każda grupa, która wsiadła, dojechała: grupy == liczba przejazdów
+# - wykorzystanie slotów w (0, 100]%, wyprzedzenia jednej grupy <= limit z raportu
+# - duży peron (KOLEJ_PERON_SLOTY > KOLEJ_KRZESLA, wolny wyciąg), ten sam ciąg
+#   klientów (KOLEJ_SEED) dla każdej polityki: ffd i dokladna wykorzystują sloty
+#   co najmniej jak zachlanna (tolerancja na różny przeplot), któraś wyraźnie lepiej
+
+source "$(dirname "$0")/common.sh"
+
+TEST_NAME="test18_pakowanie_rzedow"
+
+reset_logs
+build_project
+
+N="${1:-60}"
+T="${2:-5}"
+KRZESLA_DOMYSLNE=4      # KRZESLA_W_RZEDZIE z config.h
+
+# Scenariusz "duży peron": kolejka dłuższa niż rząd, więc polityka ma z czego wybierać
+DUZY_N=120
+DUZY_PERON=24
+DUZY_KRZESLA=4
+DUZY_INTERWAL=40
+DUZY_SEED=18            # te same grupy w tej samej kolejności dla każdej polityki
+TOLERANCJA_PP=1         # ffd/dokladna mogą przegrać z zachlanna najwyżej o tyle pp
+MARGINES_PP=2           # ... a lepsza z nich ma wygrać co najmniej o tyle pp
+
+echo "== $TEST_NAME =="
+
+RAPORT="$OUTPUT_DIR/raport_dzienny.txt"
+
+fail=0
+expect_main_rejects_env KOLEJ_PAKOWANIE zla "Nieznany KOLEJ_PAKOWANIE" "$N" "$T" || fail=1
+zly_kod="$ZLY_KOD"
+expect_main_rejects_env KOLEJ_SEED abc "Nieprawidłowy KOLEJ_SEED" "$N" "$T" || fail=1
+
+# Sekcja raportu -> "polityka limit rzedy sloty wykorzystanie grupy wyprzedzenia_max przejazdy"
+pakowanie_z_raportu() {
+  {
+    report_section "PAKOWANIE RZ" "$RAPORT"
+    grep -a "Liczba przejazdów:" "$RAPORT" 2>/dev/null
+  } | awk '
+    /^Polityka:/ { pol = $2; lim = $NF; sub(/\)/, "", lim) }
+    /^Rz/ { rz = $4; sub(/,/, "", rz); sl = $6; wyk = $NF; gsub(/[%)]/, "", wyk) }
+    /^Grupy:/ { gr = $2 }
+    /^Wyprzedzenia:/ { wm = $6 }
+    /^Liczba przejazd/ { prz = $NF }
+    END { print (pol ? pol : "?"), lim + 0, rz + 0, sl + 0, wyk + 0, gr + 0, wm + 0, prz + 0 }'
+}
+
+{
+  echo "TEST18: polityki pakowania rzędu"
+  echo "N=$N, CZAS=$T"
+  echo
+  echo "Zła polityka: kod wyjścia main=$zly_kod"
+} > "$OUTPUT_DIR/summary18.txt"
+
+
+# uruchom_polityke <polityka> <etykieta> <N> <krzesła w rzędzie>: uruchamia main
+# (ENV geometrii ustawia wołający), sprawdza raport, zapisuje wykorzystanie w WYK[etykieta]
+declare -A WYK
+uruchom_polityke() {
+  local pol="$1" etykieta="$2" n="$3" krzesla="$4"
+  local kod=0
+
+  rm -f "$RAPORT"
+  export KOLEJ_PAKOWANIE="$pol"
+  run_main_bg "$n" "$T" 2000 300
+  wait "$RUN_MAIN_PID" || kod=$?
+  unset KOLEJ_PAKOWANIE
+  cp -a "$RAPORT" "$OUTPUT_DIR/raport_$etykieta.txt" 2>/dev/null || true
+
+  if [[ "$kod" -ne 0 || ! -f "$RAPORT" ]]; then
+    echo "[FAIL] $etykieta: main zakończył się kodem $kod (raport: $([[ -f "$RAPORT" ]] && echo jest || echo brak))" >&2
+    echo "$etykieta: main kod=$kod - brak wyników" >> "$OUTPUT_DIR/summary18.txt"
+    WYK[$etykieta]=0
+    fail=1
+    return
+  fi
+
+  read -r r_pol r_lim r_rz r_sl r_wyk r_gr r_wm r_prz <<< "$(pakowanie_z_raportu)"
+  WYK[$etykieta]="$r_wyk"
+  echo "$etykieta: polityka=$r_pol rzedy=$r_rz sloty=$r_sl wykorzystanie=${r_wyk}% grupy=$r_gr przejazdy=$r_prz wyprzedzenia_max=$r_wm (limit $r_lim)" \
+    >> "$OUTPUT_DIR/summary18.txt"
+
+  if [[ "$r_pol" != "$pol" ]]; then
+    echo "[FAIL] $etykieta: raport pokazuje politykę '$r_pol'" >&2
+    fail=1
+  fi
+  if [[ "$r_gr" -le 0 || "$r_gr" -ne "$r_prz" ]]; then
+    echo "[FAIL] $etykieta: grupy=$r_gr, przejazdy=$r_prz" >&2
+    fail=1
+  fi
+  if [[ "$r_rz" -le 0 || "$r_sl" -gt $(( r_rz * krzesla )) ]] || ! awk -v w="$r_wyk" 'BEGIN { exit !(w > 0 && w <= 100) }'; then
+    echo "[FAIL] $etykieta: rzędy=$r_rz, sloty=$r_sl (max $krzesla na rząd), wykorzystanie=${r_wyk}%" >&2
+    fail=1
+  fi
+  if [[ "$r_wm" -gt "$r_lim" ]]; then
+    echo "[FAIL] $etykieta: grupa wyprzedzona $r_wm razy (limit $r_lim)" >&2
+    fail=1
+  fi
+}
+
+for pol in zachlanna ffd dokladna; do
+  uruchom_polityke "$pol" "$pol" "$N" "$KRZESLA_DOMYSLNE"
+done
+
+echo >> "$OUTPUT_DIR/summary18.txt"
+echo "Duży peron: N=$DUZY_N, PERON_SLOTY=$DUZY_PERON, KRZESLA=$DUZY_KRZESLA, INTERWAL=${DUZY_INTERWAL}ms, SEED=$DUZY_SEED" >> "$OUTPUT_DIR/summary18.txt"
+export KOLEJ_PERON_SLOTY="$DUZY_PERON" KOLEJ_KRZESLA="$DUZY_KRZESLA" KOLEJ_INTERWAL_MS="$DUZY_INTERWAL" KOLEJ_SEED="$DUZY_SEED"
+for pol in zachlanna ffd dokladna; do
+  uruchom_polityke "$pol" "${pol}_duzy_peron" "$DUZY_N" "$DUZY_KRZESLA"
+done
+unset KOLEJ_PERON_SLOTY KOLEJ_KRZESLA KOLEJ_INTERWAL_MS KOLEJ_SEED
+
+# Polityki mają coś dawać: nie gorzej niż zachłanna, co najmniej jedna wyraźnie lepiej
+w_zach="${WYK[zachlanna_duzy_peron]}"
+lepsza=0
+for pol in ffd dokladna; do
+  w="${WYK[${pol}_duzy_peron]}"
+  if awk -v a="$w" -v b="$w_zach" -v t="$TOLERANCJA_PP" 'BEGIN { exit !(a < b - t) }'; then
+    echo "[FAIL] duży peron: $pol wykorzystuje ${w}% slotów, zachlanna ${w_zach}%" >&2
+    fail=1
+  fi
+  if awk -v a="$w" -v b="$w_zach" -v m="$MARGINES_PP" 'BEGIN { exit !(a >= b + m) }'; then
+    lepsza=1
+  fi
+done
+if [[ "$lepsza" -ne 1 ]]; then
+  echo "[FAIL] duży peron: ani ffd, ani dokladna nie pakuje o ${MARGINES_PP}pp lepiej niż zachlanna (${w_zach}%)" >&2
+  fail=1
+fi
+
+OUTDIR="$(collect_results "$TEST_NAME")"
+cp -a "$OUTPUT_DIR"/raport_zachlanna*.txt "$OUTPUT_DIR"/raport_ffd*.txt "$OUTPUT_DIR"/raport_dokladna*.txt "$OUTDIR/" 2>/dev/null || true
+cp -a "$OUTPUT_DIR/summary18.txt" "$OUTDIR/summary.txt"
+
+print_hint_screenshots "$OUTDIR"
+exit "$fail"
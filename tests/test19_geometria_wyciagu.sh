@@ -0,0 +1,82 @@
+#!/usr/bin/env bash
+set -euo pipefail
+# Test 19 – Geometria wyciągu w czasie uruchomienia (KOLEJ_RZEDY / KRZESLA / PERON_SLOTY / INTERWAL_MS)
+# - wartość spoza zakresu: main odmawia startu
+# - wyciąg startuje z zadaną geometrią, raport pokazuje zadany interwał
+# - każda grupa, która wsiadła, dojechała: grupy == liczba przejazdów
+# - sloty w ładowanych rzędach <= rzędy * KOLEJ_KRZESLA
+
+source "$(dirname "$0")/common.sh"
+
+TEST_NAME="test19_geometria_wyciagu"
+
+reset_logs
+build_project
+
+N="${1:-60}"
+T="${2:-5}"
+RZEDY=60
+KRZESLA=6
+PERON=12
+INTERWAL=5
+
+echo "== $TEST_NAME =="
+
+RAPORT="$OUTPUT_DIR/raport_dzienny.txt"
+
+fail=0
+expect_main_rejects_env KOLEJ_KRZESLA 0 "Nieprawidłowy KOLEJ_KRZESLA" "$N" "$T" || fail=1
+zly_kod="$ZLY_KOD"
+
+export KOLEJ_RZEDY="$RZEDY" KOLEJ_KRZESLA="$KRZESLA" KOLEJ_PERON_SLOTY="$PERON" KOLEJ_INTERWAL_MS="$INTERWAL"
+run_main_bg "$N" "$T" 2000 300
+wait_main "$RUN_MAIN_PID" || true
+unset KOLEJ_RZEDY KOLEJ_KRZESLA KOLEJ_PERON_SLOTY KOLEJ_INTERWAL_MS
+
+start="$(grep -ah "WYCIAG: Start" "$OUTPUT_DIR"/*.log | tail -n1 || true)"
+read -r r_rz r_sl r_gr r_prz r_int <<< "$(
+  {
+    report_section "PAKOWANIE RZ" "$RAPORT"
+    grep -a "Tryb nadrabiania:" "$RAPORT" 2>/dev/null
+    grep -a "Liczba przejazdów:" "$RAPORT" 2>/dev/null
+  } | awk '
+    /^Rz/ { rz = $4; sub(/,/, "", rz); sl = $6 }
+    /^Grupy:/ { gr = $2 }
+    /^Tryb nadrabiania:/ { for (i = 1; i <= NF; i++) if ($i == "(interwał") it = $(i + 1) }
+    /^Liczba przejazd/ { prz = $NF }
+    END { print rz + 0, sl + 0, gr + 0, prz + 0, it + 0 }'
+)"
+
+{
+  echo "TEST19: geometria wyciągu z ENV"
+  echo "N=$N, CZAS=$T, RZEDY=$RZEDY, KRZESLA=$KRZESLA, PERON=$PERON, INTERWAL=${INTERWAL}ms"
+  echo
+  echo "Zła geometria: kod wyjścia main=$zly_kod"
+  echo "Start wyciągu: $start"
+  echo "Raport: rzedy=$r_rz sloty=$r_sl grupy=$r_gr przejazdy=$r_prz interwal=${r_int}ms"
+} > "$OUTPUT_DIR/summary19.txt"
+
+if [[ "$start" != *"RZEDOW=$RZEDY,"* || "$start" != *"SLOTY/RZAD=$KRZESLA,"* || "$start" != *"PERON=$PERON,"* \
+      || "$start" != *"INTERWAL=${INTERWAL}ms"* || "$start" != *"GORNA=$(( RZEDY / 2 )),"* ]]; then
+  echo "[FAIL] wyciąg nie wystartował z zadaną geometrią: $start" >&2
+  fail=1
+fi
+if [[ "$r_int" -ne "$INTERWAL" ]]; then
+  echo "[FAIL] raport pokazuje interwał ${r_int} ms (oczekiwano $INTERWAL)" >&2
+  fail=1
+fi
+if [[ "$r_gr" -le 0 || "$r_gr" -ne "$r_prz" ]]; then
+  echo "[FAIL] grupy=$r_gr, przejazdy=$r_prz" >&2
+  fail=1
+fi
+if [[ "$r_rz" -le 0 || "$r_sl" -gt $(( r_rz * KRZESLA )) ]]; then
+  echo "[FAIL] rzędy=$r_rz, sloty=$r_sl (max $KRZESLA na rząd)" >&2
+  fail=1
+fi
+
+OUTDIR="$(collect_results "$TEST_NAME")"
+cp -a "$RAPORT" "$OUTDIR/" 2>/dev/null || true
+cp -a "$OUTPUT_DIR/summary19.txt" "$OUTDIR/summary.txt"
+
+print_hint_screenshots "$OUTDIR"
+exit "$fail"
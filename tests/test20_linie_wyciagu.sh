@@ -0,0 +1,81 @@
+#!/usr/bin/env bash
+set -euo pipefail
+# Test 20 – Kilka niezależnych linii wyciągu (KOLEJ_LINIE)
+# - wartość spoza zakresu: main odmawia startu
+# - main uruchamia po jednym wyciągu na linię
+# - pracownik1 rozdziela grupy: każda linia przewiozła grupy
+# - suma grup linii == grupy pakowania == liczba przejazdów, perony linii puste po dniu
+
+source "$(dirname "$0")/common.sh"
+
+TEST_NAME="test20_linie_wyciagu"
+
+reset_logs
+build_project
+
+N="${1:-80}"
+T="${2:-5}"
+LINIE=3
+
+echo "== $TEST_NAME =="
+
+RAPORT="$OUTPUT_DIR/raport_dzienny.txt"
+
+fail=0
+expect_main_rejects_env KOLEJ_LINIE 0 "Nieprawidłowy KOLEJ_LINIE" "$N" "$T" || fail=1
+zly_kod="$ZLY_KOD"
+
+export KOLEJ_LINIE="$LINIE"
+run_main_bg "$N" "$T" 2000 300
+wait_main "$RUN_MAIN_PID" || true
+unset KOLEJ_LINIE
+
+uruchomione="$(grep -ac "Wyciąg uruchomiony" "$OUTPUT_DIR/main.log" 2>/dev/null || true)"
+starty="$(grep -ah "WYCIAG: Start" "$OUTPUT_DIR"/*.log | grep -c "LINIA=[0-9]*/$LINIE," || true)"
+linie_raport="$(report_section "LINIE WYCI" "$RAPORT" | grep -a "^Linia" || true)"
+read -r l_n l_min l_suma l_kol r_gr r_prz <<< "$(
+  {
+    echo "$linie_raport"
+    report_section "PAKOWANIE RZ" "$RAPORT"
+    grep -a "Liczba przejazdów:" "$RAPORT" 2>/dev/null
+  } | awk '
+    /^Linia/ { g = $4; sub(/,/, "", g); n++; suma += g; kol += ($NF < 0 ? -$NF : $NF)
+               if (n == 1 || g < min) min = g }
+    /^Grupy:/ { gr = $2 }
+    /^Liczba przejazd/ { prz = $NF }
+    END { print n + 0, min + 0, suma + 0, kol + 0, gr + 0, prz + 0 }'
+)"
+
+{
+  echo "TEST20: linie wyciągu z ENV"
+  echo "N=$N, CZAS=$T, LINIE=$LINIE"
+  echo
+  echo "Złe linie: kod wyjścia main=$zly_kod"
+  echo "Uruchomione wyciągi: $uruchomione, starty z LINIA=x/$LINIE: $starty"
+  echo "$linie_raport"
+  echo "Raport: linie=$l_n min_grup=$l_min suma_grup=$l_suma zajete_sloty=$l_kol grupy=$r_gr przejazdy=$r_prz"
+} > "$OUTPUT_DIR/summary20.txt"
+
+if [[ "$uruchomione" -ne "$LINIE" || "$starty" -ne "$LINIE" ]]; then
+  echo "[FAIL] uruchomiono $uruchomione wyciągów, wystartowało $starty (oczekiwano $LINIE)" >&2
+  fail=1
+fi
+if [[ "$l_n" -ne "$LINIE" || "$l_min" -le 0 ]]; then
+  echo "[FAIL] raport: linie=$l_n, najmniej grup na linii=$l_min" >&2
+  fail=1
+fi
+if [[ "$l_suma" -ne "$r_gr" || "$r_gr" -ne "$r_prz" ]]; then
+  echo "[FAIL] suma grup linii=$l_suma, grupy pakowania=$r_gr, przejazdy=$r_prz" >&2
+  fail=1
+fi
+if [[ "$l_kol" -ne 0 ]]; then
+  echo "[FAIL] po dniu na peronach linii zostało $l_kol zajętych slotów" >&2
+  fail=1
+fi
+
+OUTDIR="$(collect_results "$TEST_NAME")"
+cp -a "$RAPORT" "$OUTDIR/" 2>/dev/null || true
+cp -a "$OUTPUT_DIR/summary20.txt" "$OUTDIR/summary.txt"
+
+print_hint_screenshots "$OUTDIR"
+exit "$fail"
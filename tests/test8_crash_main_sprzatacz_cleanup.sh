@@ -32,12 +32,14 @@ int main(int argc, char **argv) {
   key_t base = ftok(path, 'K');
   if (base == (key_t)-1) { perror("ftok"); return 1; }
 
-  const int offsets[] = {0,1,2,3,4,5,6,7,8,9,10};
+  /* 12 = IPC_KEY_SHM_KARNETY: pierwszy chunk karnetów */
+  const int offsets[] = {0,1,2,3,4,5,6,7,8,9,10,11,12};
   const char *names[] = {
     "SEM","SHM","MQ_KASA","MQ_KASA_ODP","MQ_BRAMKA","MQ_BRAMKA_ODP",
-    "MQ_PRAC","MQ_WYCIAG_REQ","MQ_WYCIAG_ODP","MQ_PERON","MQ_PERON_ODP"
+    "MQ_PRAC","MQ_WYCIAG_REQ","MQ_WYCIAG_ODP","MQ_PERON","MQ_PERON_ODP",
+    "SHM_KOLEJKI","SHM_KARNETY_0"
   };
-  for (int i=0;i<11;i++) {
+  for (int i=0;i<13;i++) {
     unsigned k = (unsigned)(base + offsets[i]);
     printf("%s 0x%08x\n", names[i], k);
   }
@@ -69,6 +71,13 @@ for k in "${KEY_HEXES[@]}"; do
   fi
 done
 
+# Chunk karnetów musi istnieć przed crashem, inaczej jego sprzątanie nie jest sprawdzane
+KARNETY_HEX="$(printf '%s\n' "${KEY_LINES[@]}" | awk '$1 == "SHM_KARNETY_0" {print $2}')"
+if ! echo "$IPCS_BEFORE" | grep -qi "$KARNETY_HEX"; then
+  echo "[FAIL] Brak segmentu SHM_KARNETY_0 ($KARNETY_HEX) przed crashem (test niewiarygodny)." >&2
+  found_before=0
+fi
+
 if [[ "$found_before" -ne 1 ]]; then
   echo "[FAIL] Nie wykryłem obiektów IPC po naszych kluczach PRZED crashem (test niewiarygodny)." >&2
   kill -TERM "$PID_MAIN" 2>/dev/null || true
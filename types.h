@@ -3,6 +3,7 @@
 
 #include <sys/types.h>
 #include <time.h>
+#include <pthread.h>
 #include "config.h"
 
 /*
@@ -51,6 +52,15 @@ typedef enum {
     TRASA_T4                // piesza (60 min)
 } Trasa;
 
+/* ============================================
+ * KOTWICA CZASU
+ * Ta sama chwila na obu zegarach: czas ściany = sciana_ns + (t - mono_ns)
+ * ============================================ */
+typedef struct {
+    long long mono_ns;          // CLOCK_MONOTONIC
+    long long sciana_ns;        // CLOCK_REALTIME (ns od epoki)
+} KotwicaCzasu;
+
 /* ============================================
  * STRUKTURA KARNETU
  * ============================================ */
@@ -58,7 +68,7 @@ typedef struct {
     int id;                     // unikalny ID karnetu
     TypKarnetu typ;             // typ karnetu
     int czas_waznosci_sek;      // czas ważności w sekundach (0 = jednorazowy)
-    time_t czas_aktywacji;      // kiedy pierwszy raz użyty (0 = nieaktywny)
+    long long aktywacja_ns;     // pierwsze użycie, CLOCK_MONOTONIC (0 = nieaktywny)
     int cena_gr;                // cena w groszach
     int uzyty;                  // dla jednorazowego: 0/1
     int vip;                    // czy VIP: 0/1
@@ -83,12 +93,14 @@ typedef struct {
 
 /* ============================================
  * STRUKTURA WPISU W LOGU
+ * 16 bajtów: ten sam rekord w pierścieniu SHM i w pliku binarnym (log_bin.h)
  * ============================================ */
 typedef struct {
     int id_karnetu;             // ID karnetu
-    TypLogu typ_bramki;         // która bramka
-    int numer_bramki;           // numer konkretnej bramki (1-4, 1-3, 1-2)
-    time_t czas;                // czas przejścia
+    unsigned char typ_bramki;   // TypLogu - która bramka
+    unsigned char numer_bramki; // numer konkretnej bramki (1-4, 1-3, 1-2)
+    unsigned short zarezerwowane;
+    long long czas_ns;          // czas przejścia (CLOCK_MONOTONIC, ściana: kotwica w nagłówku)
 } LogEntry;
 
 /* ============================================
@@ -108,49 +120,139 @@ typedef struct {
     int liczba_przejazdow;          // łączna liczba przejazdów
 } Statystyki;
 
+/* Shard statystyk: jeden piszący, własne linie cache (patrz statystyki.h) */
+typedef struct {
+    Statystyki s;
+} __attribute__((aligned(64))) ShardStatystyk;
+
+/* Role procesów stałych - każda pisze do własnego sharda */
+typedef enum {
+    STAT_ROLA_INNE = 0,             // main / generator / bramki (rzadkie zapisy)
+    STAT_ROLA_KASJER,
+    STAT_ROLA_WYCIAG,
+    STAT_ROLA_PRACOWNIK1,
+    STAT_ROLA_PRACOWNIK2,
+    STAT_LICZBA_ROL
+} RolaStatystyk;
+
 /* ============================================
- * PAMIĘĆ WSPÓŁDZIELONA - GŁÓWNA STRUKTURA
+ * HISTOGRAMY CZASÓW ETAPÓW KLIENTA (patrz histogram.h)
+ * Log-liniowe (HDR): HIST_POD kubełków liniowych na każdą potęgę
+ * dwójki, wartości w µs - błąd względny kubełka <= 1/HIST_POD.
+ * ============================================ */
+#define HIST_BITY_POD   4
+#define HIST_POD        (1 << HIST_BITY_POD)    // kubełków na oktawę
+#define HIST_BITY       36                      // zakres: do 2^36 µs (~19 h), dłuższe w ostatnim
+#define HIST_KUBELKI    ((HIST_BITY - HIST_BITY_POD + 1) * HIST_POD)
+
+typedef enum {
+    ETAP_KASA = 0,                  // wysłanie do kasy -> karnet
+    ETAP_BRAMKA1,                   // wysłanie do bramki1 -> wpuszczony (z SEM_TEREN)
+    ETAP_PERON,                     // prośba do pracownika1 -> na peronie (z SEM_PERON)
+    ETAP_BOARD,                     // na peronie -> BOARD
+    ETAP_PRZEJAZD,                  // BOARD -> ARRIVE
+    ETAP_LICZBA
+} EtapKlienta;
+
+typedef enum {
+    KLASA_PIESZY = 0,
+    KLASA_ROWER,
+    KLASA_VIP,                      // VIP niezależnie od typu
+    KLASA_LICZBA
+} KlasaKlienta;
+
+typedef struct {
+    unsigned long liczba;           // pomiarów
+    unsigned long suma_us;
+    unsigned long max_us;
+    unsigned long kubelki[HIST_KUBELKI];
+} __attribute__((aligned(64))) Histogram;
+
+/* ============================================
+ * ZEGAR WYCIĄGU - ticki ringu (piszą wszystkie linie wyciągu, atomowo)
+ * ============================================ */
+typedef struct {
+    int tryb;                       // NADRABIANIE_* (ustawia main przed startem wyciągu)
+    long long start_ns;             // termin pierwszego ticka pierwszej linii (0 = wyciąg jeszcze nie ruszył)
+    long long ostatni_ns;           // start ostatniego ticka
+    unsigned long ticki;            // wykonane ticki (suma linii)
+    unsigned long pominiete;        // terminy bez ticka (pomin / ponad WYCIAG_SERIA_MAX)
+    unsigned long zalegle;          // ticki wykonane co najmniej interwał po terminie
+    Histogram opoznienie;           // start ticka - termin
+    Histogram praca;                // czas pracy ticka (wysadzanie, załadunek, odpowiedzi)
+} __attribute__((aligned(64))) ZegarWyciagu;
+
+/* Geometria ringu wyciągu (ustala main przed init_ipc, reszta tylko czyta) */
+typedef struct {
+    int rzedy;                      // rzędów w obiegu
+    int krzesla_w_rzedzie;          // slotów w rzędzie
+    int peron_sloty;                // pojemność peronu (start SEM_PERON)
+    int interwal_ms;                // co ile podjeżdża rząd
+    int pozycja_gorna;              // pozycja wyładunku (przejazd = pozycja_gorna * interwal_ms)
+    int linie;                      // równoległe linie (procesy wyciag), każda z tą geometrią
+} GeometriaWyciagu;
+
+/* Linia wyciągu - liczniki linii (długość kolejki: linia_peron_zajety, z semafora) */
+typedef struct {
+    unsigned long grupy;            // grupy, które wsiadły na tej linii
+} __attribute__((aligned(64))) LiniaWyciagu;
+
+/* Pakowanie rzędów na dolnej stacji (piszą linie wyciągu, sumy wszystkich linii) */
+typedef struct {
+    int polityka;                   // PAKOWANIE_* (ustawia main przed startem wyciągu)
+    unsigned long rzedy;            // rzędy ładowane przy niepustej kolejce
+    unsigned long sloty;            // sloty zajęte w tych rzędach (wykorzystanie = sloty / rzedy*krzesla_w_rzedzie)
+    unsigned long grupy;            // grupy, które wsiadły
+    unsigned long wyprzedzenia;     // rzędy, w których grupę wyprzedził ktoś późniejszy z jej klasy
+    unsigned long wymuszone;        // grupy wsadzone poza polityką (limit wyprzedzeń)
+    int wyprzedzenia_max;           // najwięcej wyprzedzeń jednej grupy przed wejściem
+} __attribute__((aligned(64))) PakowanieWyciagu;
+
+/* ============================================
+ * OBECNOŚĆ - LICZNIKI STREF (patrz obecnosc.h)
+ * ============================================ */
+typedef enum {
+    STREFA_POZA = 0,                // poza stacją (wejście / wyjście)
+    STREFA_TEREN,                   // teren dolnej stacji (po BRAMKA1)
+    STREFA_PERON,                   // peron (po BRAMKA2)
+    STREFA_KRZESLO,                 // w krzesełku (BOARD -> ARRIVE)
+    STREFA_GORA,                    // góra / trasa powrotna
+    STREFA_LICZBA
+} StrefaObecnosci;
+
+typedef struct {
+    unsigned long strefy;           // wszystkie strefy w jednym słowie (atomowe przeniesienia)
+    int kontrola;                   // 1 = sprawdzaj niezmienniki (KOLEJ_KONTROLA_OBECNOSCI)
+    int naruszenia;                 // ile naruszeń wykryto
+    long wpuszczeni;                // wejścia (tylko w trybie kontroli)
+    long wyszli;                    // wyjścia (tylko w trybie kontroli)
+} __attribute__((aligned(64))) Obecnosc;
+
+/* ============================================
+ * STAN GLOBALNY (seqlock)
+ * Rzadko zmieniane pola czytane na gorących ścieżkach wszystkich procesów.
+ * Odczyt bez blokad: STAN(pole) albo stan_odczytaj() dla spójnej kopii.
+ * Zapis: stan_zapis_poczatek() / STAN_USTAW() / stan_zapis_koniec() (ipc.h).
  * ============================================ */
 typedef struct {
+    unsigned long long seq;         // niskie 32 bity: licznik (parzysty = spójny, nieparzysty = zapis w toku)
+                                    // wysokie 32 bity: PID piszącego (0 = nikt) - ustawiane tym samym CAS-em
+
     /* Stan systemu */
     int kolej_aktywna;              // 0=stop, 1=działa
     int awaria;                     // 0=brak, 1=STOP aktywny
     int koniec_dnia;                // DEPRECATED - używaj faza_dnia
-    time_t czas_startu;             // czas uruchomienia symulacji
-    int czekajacych_na_wznowienie;  // ile procesów czeka na SEM_BARIERA_AWARIA
-    
-    /* NOWE: 2-fazowe zamykanie */
     FazaDnia faza_dnia;             // OPEN / CLOSING / DRAINING
-    time_t czas_konca_dnia;         // kiedy kończy się dzień (absolutny timestamp)
-    int aktywni_klienci;            // ile procesów klienta żyje (do drenowania)
+    long long koniec_dnia_ns;       // kiedy kończy się dzień (CLOCK_MONOTONIC, 0 = nieustawiony)
 
     /* PANIC: awaryjne zamykanie po śmierci procesu */
     int panic;                      // 0=OK, 1=panic shutdown
     pid_t panic_pid;                // PID, który wywołał panic (jeśli znany)
     int panic_sig;                  // sygnał (jeśli znany)
 
-    /* Liczniki bieżące */
-    int osoby_na_terenie;           // aktualnie na terenie stacji
-    int osoby_na_gorze;             // aktualnie na górze
-    int osoby_na_peronie;           // aktualnie na peronie
-    int osoby_w_krzesle;            // w trakcie wjazdu (na krzesełku)
-    int aktualny_rzad;              // 0-17, który rząd jest gotowy
-    
-    /* Autoincrement ID */
-    int nastepny_id_karnetu;        // następny ID karnetu
-    int nastepny_id_klienta;        // następny ID klienta
-    
-    /* Karnety */
-    Karnet karnety[MAX_KARNETOW];
-    int liczba_karnetow;
-    
-    /* Logi przejść */
-    LogEntry logi[MAX_LOGOW];
-    int liczba_logow;
-    
-    /* Statystyki */
-    Statystyki stats;
-    
+    /* AWARIA: który pracownik zainicjował STOP (do SIGUSR2 / wznowienia) */
+    pid_t pid_awaria_inicjator;
+
     /* PIDs procesów stałych (do cleanup) */
     pid_t pid_main;                 // proces główny
     pid_t pid_generator;
@@ -158,11 +260,102 @@ typedef struct {
     pid_t pid_bramki1[LICZBA_BRAMEK1];
     pid_t pid_pracownik1;
     pid_t pid_pracownik2;
-    pid_t pid_wyciag;               // proces wyciągu
+    pid_t pid_wyciag[LINIE_MAX];    // procesy wyciągu (linie 1..linie)
+    pid_t pid_dziennik;             // proces dziennika (0 = brak, tryb ENV_LOG_DZIENNIK)
+} __attribute__((aligned(64))) StanGlobalny;
 
-    /* AWARIA: który pracownik zainicjował STOP (do SIGUSR2 / wznowienia) */
-    pid_t pid_awaria_inicjator;
-    
+/* ============================================
+ * PAMIĘĆ WSPÓŁDZIELONA - GŁÓWNA STRUKTURA
+ * Regiony na osobnych stronach (SHM_STRONA), żeby gorące liczniki
+ * nie dzieliły linii cache z rzadko zmienianym sterowaniem ani
+ * z magazynami karnetów / logów:
+ *   1. strona sterująca  - nagłówek układu, mutex, stan globalny
+ *   2. strona liczników  - każdy licznik z innym piszącym na własnej linii
+ *   3. statystyki (shardy) + histogramy etapów klienta + zegar / pakowanie wyciągu
+ *   4. pierścień logu przejść - za strukturą, stały (LOGI_PIERSCIEN), drenowany przez main
+ *   5. pierścień zdarzeń dziennika - za logiem przejść (tylko ENV_LOG_DZIENNIK=1)
+ * Geometria pierścieni (pojemności + offsety) leży w nagłówku,
+ * procesy potomne czytają ją w attach_ipc.
+ * Karnety leżą poza tym segmentem: w chunkach (osobne segmenty
+ * IPC_KEY_SHM_KARNETY + nr), dokładanych na żądanie przez kasjera.
+ * Zmiana układu = podbicie SHM_WERSJA_UKLADU (sprawdza attach_ipc).
+ * ============================================ */
+#define SHM_MAGIC           0x4B4F4C4Au     // "KOLJ"
+#define SHM_WERSJA_UKLADU   15
+#define SHM_STRONA          4096            // wyrównanie regionów
+#define SHM_LINIA           64              // wyrównanie gorących liczników
+
+/* Geometria segmentu: ustala main (geometria_shm_oblicz), reszta tylko czyta */
+typedef struct {
+    size_t rozmiar_segmentu;        // część stała + pierścień logów + pierścień zdarzeń
+    size_t offset_logow;            // od początku segmentu (wyrównany do SHM_STRONA)
+    int pojemnosc_logow;            // wpisów w pierścieniu logu przejść
+    int chunki_karnetow_start;      // chunki karnetów tworzone od razu przez init_ipc
+    size_t offset_zdarzen;          // pierścień zdarzeń dziennika (wyrównany do SHM_STRONA)
+    int pojemnosc_zdarzen;          // rekordów w pierścieniu (0 = dziennik wyłączony)
+} GeometriaShm;
+
+typedef struct {
+    /* ---- 1. Strona sterująca (rzadkie zapisy) ---- */
+
+    /* Nagłówek układu - zawsze na offsecie 0 (czytelny dla każdej wersji) */
+    unsigned int magic;             // SHM_MAGIC
+    unsigned int wersja_ukladu;     // SHM_WERSJA_UKLADU
+    size_t rozmiar;                 // sizeof(SharedMemory) u twórcy segmentu
+    GeometriaShm geometria;         // pierścienie logów / zdarzeń + początkowe chunki karnetów
+    GeometriaWyciagu wyciag;        // ring wyciągu, peron, interwał
+
+    /* Mutex SHM (robust, process-shared) - używaj przez MUTEX_SHM_LOCK/UNLOCK */
+    pthread_mutex_t mutex_shm;
+
+    /* Transport komunikatów (TRANSPORT_SYSV / TRANSPORT_SHM) - ustawia init_ipc */
+    int transport;
+    KotwicaCzasu kotwica;           // start symulacji: oba zegary w tej samej chwili (czas.h)
+    int czekajacych_na_wznowienie;  // ile procesów czeka na SEM_BARIERA_AWARIA (pod mutexem)
+    int aktualny_rzad;              // 0-17, który rząd jest gotowy
+    int dziennik_aktywny;           // 1 = dziennik opróżnia pierścień zdarzeń (ustawia sam dziennik)
+    int zdarzenia_w_locie;          // producenci między odczytem dziennik_aktywny a włożeniem do pierścienia
+
+    /* Chunki karnetów: shmid każdego chunka (czytelnicy podpinają je leniwie) */
+    int id_chunkow_karnetow[KARNETY_MAX_CHUNKOW];
+
+    /* Stan globalny - osobne linie cache, czytany bez mutexa */
+    StanGlobalny stan;
+
+    /* ---- 2. Strona liczników (gorące, różni piszący) ---- */
+
+    /* Liczniki bieżące - osoby w strefach przez obecnosc_przenies() */
+    Obecnosc obecnosc __attribute__((aligned(SHM_STRONA)));
+
+    /* Linie wyciągu: kolejki (pracownik1 +, wyciąg / klient -) */
+    LiniaWyciagu linie[LINIE_MAX];
+
+    /* 2-fazowe zamykanie: ile procesów klienta żyje (do drenowania) */
+    int aktywni_klienci __attribute__((aligned(SHM_LINIA)));
+
+    /* Log przejść: pełny pierścień (main nie nadąża) - rzadkie, wspólna linia */
+    int logi_opoznione __attribute__((aligned(SHM_LINIA)));    // wpisy, na które producent czekał
+    int logi_zgubione;              // wpisy porzucone po LOGI_CZEKANIE_MS
+
+    /* Karnety + autoincrement ID (pisze kasjer pod mutexem) */
+    int liczba_karnetow __attribute__((aligned(SHM_LINIA)));
+    int chunki_karnetow;            // opublikowane chunki (id_chunkow_karnetow[0..n-1])
+    int nastepny_id_karnetu;        // następny ID karnetu
+    int nastepny_id_klienta;        // następny ID klienta
+
+    /* ---- 3. Statystyki - shardy (sumuje statystyki_zsumuj) ---- */
+    ShardStatystyk stat_role[STAT_LICZBA_ROL] __attribute__((aligned(SHM_STRONA)));
+    ShardStatystyk stat_klienci[STAT_SHARDY_KLIENTOW];
+    int stat_klienci_max __attribute__((aligned(SHM_LINIA)));   // najwyższy użyty slot klienta + 1
+
+    /* Histogramy czasów etapów (atomowe inkrementacje klientów, histogram.h) */
+    Histogram hist[ETAP_LICZBA][KLASA_LICZBA] __attribute__((aligned(SHM_STRONA)));
+
+    /* Zegar wyciągu: opóźnienia / praca ticków (jeden piszący - wyciag) */
+    ZegarWyciagu zegar_wyciagu __attribute__((aligned(SHM_STRONA)));
+    PakowanieWyciagu pakowanie;
+
+    /* ---- 4./5. Pierścienie logu przejść i zdarzeń: za strukturą, patrz geometria ---- */
 } SharedMemory;
 
 /* ============================================
@@ -177,6 +370,7 @@ typedef struct {
     int vip;                    // czy VIP
     int liczba_dzieci;          // 0, 1, 2
     int wiek_dzieci[2];         // wiek dzieci
+    int skrzynka;               // skrzynka odpowiedzi klienta (-1 = kolejka SysV)
 } MsgKasa;
 
 /* ============================================
@@ -203,6 +397,7 @@ typedef struct {
     int rozmiar_grupy;          // ile miejsc zajmuje (1-3)
     int numer_bramki;           // do której bramki (1-4)
     int vip;                    // czy VIP: 0/1 (do bramki VIP-only)
+    int skrzynka;               // skrzynka odpowiedzi klienta (-1 = kolejka SysV)
 } MsgBramka1;
 
 /* ============================================
@@ -231,12 +426,14 @@ typedef struct {
     int id_karnetu;             // ID karnetu
     int miejsca;                // ile miejsc potrzebuje (1-4)
     int numer_bramki2;          // przez którą bramkę2 wchodzi (1-3)
+    int skrzynka;               // skrzynka odpowiedzi klienta (-1 = kolejka SysV)
 } MsgPeron;
 
 /* Odpowiedź pracownika1 dla klienta (peron) */
 typedef struct {
     long mtype;                 // = pid_klienta
     int sukces;                 // 0=odmowa, 1=OK
+    int linia;                  // linia wyciągu (1..linie) wybrana przez pracownika1
 } MsgPeronOdp;
 
 /* ============================================
@@ -252,12 +449,13 @@ typedef enum {
  * KOMUNIKATY - WYCIĄG REQUEST (klient -> wyciąg)
  * ============================================ */
 typedef struct {
-    long mtype;                 // MSG_TYP_VIP lub MSG_TYP_NORMALNY
+    long mtype;                 // numer linii wyciągu (1..linie); VIP niesie pole vip
     pid_t pid_klienta;          // PID klienta
     int typ_klienta;            // TypKlienta (pieszy/rower)
     int vip;                    // 0/1
     int rozmiar_grupy;          // osoby (dorosły + dzieci)
     int waga_slotow;            // sloty peronu (pieszy=1+dzieci, rower=2+dzieci)
+    int skrzynka;               // skrzynka odpowiedzi klienta (-1 = kolejka SysV)
 } MsgWyciagReq;
 
 /* ============================================
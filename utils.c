@@ -6,8 +6,10 @@
 #include <unistd.h>
 #include <stdarg.h>
 #include <sys/file.h>
+#include <limits.h>
 #include "utils.h"
-#include "ipc.h"  /* dla g_shm->czas_konca_dnia */
+#include "czas.h"
+#include "ipc.h"  /* dla STAN(koniec_dnia_ns) */
 
 /*
  * KOLEJ KRZESEŁKOWA - IMPLEMENTACJA FUNKCJI POMOCNICZYCH
@@ -26,20 +28,111 @@ void blad_ostrzezenie(const char *msg) {
     loguj("OSTRZEŻENIE: %s: %s", msg, strerror(errno));
 }
 
+/* ============================================
+ * LOGOWANIE
+ * Tryb bezpośredni (domyślny): każdy wiersz = flock + write.
+ * Tryb buforowany (ENV_LOG_BUFOR=1): wiersze zbierane w prywatnym
+ * buforze procesu, zapis paczkami po całych wierszach (<= PIPE_BUF,
+ * deskryptory logów mają O_APPEND, więc paczki się nie przeplatają)
+ * po przekroczeniu LOG_BUFOR_PROG / LOG_BUFOR_MS i przy wyjściu.
+ * ============================================ */
+
+static int g_log_tryb = -1;                 // -1 = nieznany, 0 = bezpośredni, 1 = buforowany
+static char g_log_bufor[LOG_BUFOR_ROZMIAR];
+static size_t g_log_zajete = 0;
+static pid_t g_log_wlasciciel = 0;          // proces, który napełnił bufor (fork kopiuje bufor)
+static long g_log_najstarszy_ms = 0;        // kiedy trafił pierwszy nieopróżniony wiersz
+static int g_log_zajety = 0;                // bufor w użyciu (sygnał / wątek -> tryb bezpośredni)
+
+static long log_teraz_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000L + ts.tv_nsec / 1000000L;
+}
+
+/* write() best-effort z obsługą EINTR (async-signal-safe) */
+static void log_zapisz(const char *buf, size_t len) {
+    size_t pos = 0;
+    while (pos < len) {
+        ssize_t w = write(STDERR_FILENO, buf + pos, len - pos);
+        if (w < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        pos += (size_t)w;
+    }
+}
+
+/* Zapis bufora paczkami po całych wierszach (wywołujący trzyma g_log_zajety) */
+static void log_oproznij_bufor(void) {
+    int e = errno;
+    size_t pos = 0;
+
+    /* Kopia bufora po fork() bez exec - te wiersze zapisze rodzic */
+    if (g_log_wlasciciel != getpid()) {
+        g_log_zajete = 0;
+        return;
+    }
+
+    while (pos < g_log_zajete) {
+        size_t koniec = g_log_zajete;
+        if (koniec - pos > PIPE_BUF) {
+            /* Ostatni pełny wiersz mieszczący się w PIPE_BUF */
+            koniec = pos + PIPE_BUF;
+            while (koniec > pos && g_log_bufor[koniec - 1] != '\n') koniec--;
+            if (koniec == pos) koniec = pos + PIPE_BUF;
+        }
+        log_zapisz(g_log_bufor + pos, koniec - pos);
+        pos = koniec;
+    }
+    g_log_zajete = 0;
+    errno = e;
+}
+
+void loguj_oproznij(void) {
+    if (g_log_tryb != 1) return;
+    if (__atomic_exchange_n(&g_log_zajety, 1, __ATOMIC_ACQUIRE)) return;
+    log_oproznij_bufor();
+    __atomic_store_n(&g_log_zajety, 0, __ATOMIC_RELEASE);
+}
+
+int g_log_poziom = -1;
+
+void loguj_ustal_poziom(void) {
+    static const char *nazwy[] = {"debug", "info", "warn", "error", "none"};
+    const char *env = getenv(ENV_LOG_LEVEL);
+    int poziom = LOG_POZIOM_DEBUG;
+
+    if (env != NULL && *env) {
+        for (int i = 0; i <= LOG_POZIOM_BRAK; i++) {
+            if (strcmp(env, nazwy[i]) == 0) poziom = i;
+        }
+    }
+    g_log_poziom = poziom;
+}
+
+static void log_ustal_tryb(void) {
+    const char *env = getenv(ENV_LOG_BUFOR);
+    g_log_tryb = (env != NULL && strcmp(env, "1") == 0) ? 1 : 0;
+    if (g_log_tryb == 1) {
+        atexit(loguj_oproznij);
+    }
+}
+
 void loguj(const char *format, ...) {
     /*
      * Uwaga: wiele procesów loguje do tych samych plików (stdout/stderr są
      * przekierowane w main.c do output/<nazwa>.log). Żeby nie mieszać
-     * wpisów, cały wiersz składamy do bufora i zapisujemy pod lockiem.
+     * wpisów, cały wiersz składamy do bufora i zapisujemy pod lockiem
+     * (albo dokładamy do bufora procesu w trybie buforowanym).
      */
     char buf[1024];
+    int e = errno;
 
-    time_t teraz = time(NULL);
-    struct tm tm_info;
-    localtime_r(&teraz, &tm_info);
+    if (g_log_tryb < 0) log_ustal_tryb();
 
-    char czas_buf[20];
-    strftime(czas_buf, sizeof(czas_buf), "%H:%M:%S", &tm_info);
+    char czas_buf[24];
+    czas_formatuj_ms(czas_mono_ns(), czas_buf, sizeof(czas_buf));
 
     int n = snprintf(buf, sizeof(buf), "[%s][PID %d] ", czas_buf, (int)getpid());
     if (n < 0) return;
@@ -66,20 +159,31 @@ void loguj(const char *format, ...) {
         }
     }
 
-    int locked = (flock(STDERR_FILENO, LOCK_EX) == 0);
+    /* Tryb buforowany (bufor zajęty = wywołanie z handlera sygnału -> bezpośrednio) */
+    if (g_log_tryb == 1 && !__atomic_exchange_n(&g_log_zajety, 1, __ATOMIC_ACQUIRE)) {
+        long teraz_ms = log_teraz_ms();
+        pid_t ja = getpid();
 
-    /* write() best-effort z obsługą EINTR */
-    size_t pos = 0;
-    while (pos < len) {
-        ssize_t w = write(STDERR_FILENO, buf + pos, len - pos);
-        if (w < 0) {
-            if (errno == EINTR) continue;
-            break;
+        if (g_log_wlasciciel != ja || g_log_zajete + len > sizeof(g_log_bufor)) {
+            log_oproznij_bufor();
+            g_log_wlasciciel = ja;
         }
-        pos += (size_t)w;
+        if (g_log_zajete == 0) g_log_najstarszy_ms = teraz_ms;
+        memcpy(g_log_bufor + g_log_zajete, buf, len);
+        g_log_zajete += len;
+
+        if (g_log_zajete >= LOG_BUFOR_PROG || teraz_ms - g_log_najstarszy_ms >= LOG_BUFOR_MS) {
+            log_oproznij_bufor();
+        }
+        __atomic_store_n(&g_log_zajety, 0, __ATOMIC_RELEASE);
+        errno = e;
+        return;
     }
 
+    int locked = (flock(STDERR_FILENO, LOCK_EX) == 0);
+    log_zapisz(buf, len);
     if (locked) (void)flock(STDERR_FILENO, LOCK_UN);
+    errno = e;
 }
 
 void loguj_errno(const char *prefix) {
@@ -148,7 +252,14 @@ int waliduj_argumenty(int argc, char *argv[], int *N, int *czas_symulacji) {
  * LOSOWANIE
  * ============================================ */
 
-void inicjalizuj_losowanie(void) {
+void inicjalizuj_losowanie(int sol) {
+    /* KOLEJ_SEED sprawdził już main; tu tylko odczyt (dzieci dziedziczą env) */
+    const char *env = getenv(ENV_SEED);
+    if (env != NULL && *env) {
+        unsigned int ziarno = (unsigned int)strtoul(env, NULL, 10);
+        srand(ziarno ^ ((unsigned int)sol * 2654435761u));
+        return;
+    }
     /* Używamy PID + czas dla unikalności w każdym procesie */
     srand((unsigned int)(time(NULL) ^ getpid()));
 }
@@ -398,13 +509,13 @@ int oblicz_cene_ze_znizka(int cena_gr, int wiek) {
     return cena_gr;
 }
 
-int czy_karnet_wazny(Karnet *karnet, time_t aktualny_czas) {
+int czy_karnet_wazny(Karnet *karnet, long long teraz_ns) {
     if (karnet == NULL) return 0;
     if (!karnet->aktywny) return 0;
     
     /* GLOBALNA ZASADA: po zamknięciu stacji WSZYSTKIE karnety nieważne */
-    if (g_shm != NULL && g_shm->czas_konca_dnia > 0) {
-        if (aktualny_czas >= g_shm->czas_konca_dnia) {
+    if (g_shm != NULL && STAN(koniec_dnia_ns) > 0) {
+        if (teraz_ns >= STAN(koniec_dnia_ns)) {
             return 0; /* Po zamknięciu */
         }
     }
@@ -415,13 +526,13 @@ int czy_karnet_wazny(Karnet *karnet, time_t aktualny_czas) {
     }
     
     /* Karnet czasowy - sprawdź czy nie wygasł */
-    if (karnet->czas_aktywacji == 0) {
+    if (karnet->aktywacja_ns == 0) {
         /* Jeszcze nieaktywowany - ważny (ale tylko przed zamknięciem) */
         return 1;
     }
     
-    time_t czas_uplynal = aktualny_czas - karnet->czas_aktywacji;
-    return czas_uplynal < karnet->czas_waznosci_sek;
+    long long czas_uplynal = teraz_ns - karnet->aktywacja_ns;
+    return czas_uplynal < (long long)karnet->czas_waznosci_sek * NS_NA_SEK;
 }
 
 int oblicz_miejsca_krzeselko(TypKlienta typ, int liczba_dzieci) {
@@ -434,10 +545,10 @@ int oblicz_miejsca_krzeselko(TypKlienta typ, int liczba_dzieci) {
  * CZAS SYMULACJI
  * ============================================ */
 
-time_t czas_symulacji(time_t czas_startu) {
-    return time(NULL) - czas_startu;
+long long czas_symulacji_ns(long long start_ns) {
+    return czas_mono_ns() - start_ns;
 }
 
-int czy_koniec_symulacji(time_t czas_startu, int max_czas) {
-    return czas_symulacji(czas_startu) >= max_czas;
+int czy_koniec_symulacji(long long start_ns, int max_czas) {
+    return czas_symulacji_ns(start_ns) >= (long long)max_czas * NS_NA_SEK;
 }
@@ -33,15 +33,83 @@ void blad_ostrzezenie(const char *msg);
 
 /*
  * Loguje komunikat do pliku i na stderr
- * Format: [CZAS] [PID] komunikat
+ * Format: [HH:MM:SS.mmm][PID n] komunikat (czas z kotwicy, czas.h)
  */
 void loguj(const char *format, ...);
 
+/* ============================================
+ * POZIOMY LOGOWANIA
+ * LOG_DEBUG/INFO/WARN/ERROR(...) = loguj(...) z poziomem.
+ * - kompilacja: make LOG_LEVEL=debug|info|warn|error|none ustawia
+ *   LOG_POZIOM_MIN; niższe poziomy kompilują się do zera (argumenty
+ *   nie są liczone ani formatowane, zostaje tylko kontrola typów)
+ * - uruchomienie: ENV_LOG_LEVEL (ten sam zapis) podnosi próg dla
+ *   poziomów wkompilowanych
+ * Zwykłe loguj() loguje zawsze (zdarzenia cyklu życia procesów).
+ * ============================================ */
+#define LOG_POZIOM_DEBUG    0
+#define LOG_POZIOM_INFO     1
+#define LOG_POZIOM_WARN     2
+#define LOG_POZIOM_ERROR    3
+#define LOG_POZIOM_BRAK     4
+
+#ifndef LOG_POZIOM_MIN
+#define LOG_POZIOM_MIN      LOG_POZIOM_DEBUG
+#endif
+
+extern int g_log_poziom;            // próg z ENV_LOG_LEVEL (-1 = jeszcze nie czytany)
+
+/*
+ * Czyta ENV_LOG_LEVEL (raz na proces)
+ */
+void loguj_ustal_poziom(void);
+
+static inline int log_poziom_aktywny(int poziom) {
+    if (g_log_poziom < 0) loguj_ustal_poziom();
+    return poziom >= g_log_poziom;
+}
+
+#define LOG_NA_POZIOMIE(poziom, ...) \
+    do { if (log_poziom_aktywny(poziom)) loguj(__VA_ARGS__); } while (0)
+#define LOG_WYLACZONY(...) \
+    do { if (0) loguj(__VA_ARGS__); } while (0)
+
+#if LOG_POZIOM_MIN <= LOG_POZIOM_DEBUG
+#define LOG_DEBUG(...)      LOG_NA_POZIOMIE(LOG_POZIOM_DEBUG, __VA_ARGS__)
+#else
+#define LOG_DEBUG(...)      LOG_WYLACZONY(__VA_ARGS__)
+#endif
+
+#if LOG_POZIOM_MIN <= LOG_POZIOM_INFO
+#define LOG_INFO(...)       LOG_NA_POZIOMIE(LOG_POZIOM_INFO, __VA_ARGS__)
+#else
+#define LOG_INFO(...)       LOG_WYLACZONY(__VA_ARGS__)
+#endif
+
+#if LOG_POZIOM_MIN <= LOG_POZIOM_WARN
+#define LOG_WARN(...)       LOG_NA_POZIOMIE(LOG_POZIOM_WARN, __VA_ARGS__)
+#else
+#define LOG_WARN(...)       LOG_WYLACZONY(__VA_ARGS__)
+#endif
+
+#if LOG_POZIOM_MIN <= LOG_POZIOM_ERROR
+#define LOG_ERROR(...)      LOG_NA_POZIOMIE(LOG_POZIOM_ERROR, __VA_ARGS__)
+#else
+#define LOG_ERROR(...)      LOG_WYLACZONY(__VA_ARGS__)
+#endif
+
 /*
  * Loguje prefix + strerror(errno) jako jedna linia (bez mieszania logów).
  */
 void loguj_errno(const char *prefix);
 
+/*
+ * Zapisuje zbuforowane wiersze (tryb ENV_LOG_BUFOR=1, inaczej nic nie robi)
+ * Async-signal-safe: wywoływać przed _exit() i na ścieżkach awaryjnych.
+ * Przy exit() wywołuje się samo (atexit).
+ */
+void loguj_oproznij(void);
+
 /* ============================================
  * WALIDACJA DANYCH
  * ============================================ */
@@ -66,8 +134,14 @@ int waliduj_argumenty(int argc, char *argv[], int *N, int *czas_symulacji);
 /*
  * Inicjalizuje generator liczb losowych
  * Wywołać raz na początku każdego procesu!
+ * Bez KOLEJ_SEED: czas ^ PID. Z KOLEJ_SEED: ziarno zmieszane z `sol`, więc
+ * każdy proces ma własny, ale powtarzalny ciąg (klient: sol = id klienta).
  */
-void inicjalizuj_losowanie(void);
+#define LOS_SOL_MAIN        (-1)
+#define LOS_SOL_GENERATOR   (-2)
+#define LOS_SOL_KASJER      (-3)
+#define LOS_SOL_BRAMKA(n)   (-10 - (n))
+void inicjalizuj_losowanie(int sol);
 
 /*
  * Losuje liczbę z zakresu [min, max] włącznie
@@ -159,10 +233,10 @@ void formatuj_kwote(int grosze, char *bufor);
 int oblicz_cene_ze_znizka(int cena_gr, int wiek);
 
 /*
- * Sprawdza czy karnet jest ważny
+ * Sprawdza czy karnet jest ważny w chwili teraz_ns (czas_mono_ns())
  * Zwraca: 1=ważny, 0=nieważny
  */
-int czy_karnet_wazny(Karnet *karnet, time_t aktualny_czas);
+int czy_karnet_wazny(Karnet *karnet, long long teraz_ns);
 
 /*
  * Oblicza ile miejsc zajmuje klient na krzesełku
@@ -175,13 +249,13 @@ int oblicz_miejsca_krzeselko(TypKlienta typ, int liczba_dzieci);
  * ============================================ */
 
 /*
- * Pobiera aktualny czas symulacji (sekundy od startu)
+ * Pobiera aktualny czas symulacji (ns od start_ns = g_shm->kotwica.mono_ns)
  */
-time_t czas_symulacji(time_t czas_startu);
+long long czas_symulacji_ns(long long start_ns);
 
 /*
- * Sprawdza czy czas symulacji się skończył
+ * Sprawdza czy minęło max_czas sekund od start_ns
  */
-int czy_koniec_symulacji(time_t czas_startu, int max_czas);
+int czy_koniec_symulacji(long long start_ns, int max_czas);
 
 #endif /* UTILS_H */
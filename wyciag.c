@@ -11,32 +11,47 @@
 #include "types.h"
 #include "ipc.h"
 #include "utils.h"
+#include "obecnosc.h"
+#include "statystyki.h"
+#include "histogram.h"
+#include "czas.h"
 
 /*
- * KOLEJ KRZESEŁKOWA - PROCES WYCIĄGU (MODEL RING LICZBA_RZEDOW)
+ * KOLEJ KRZESEŁKOWA - PROCES WYCIĄGU (MODEL RING)
+ *
+ * Geometria z g_shm->wyciag (main: config.h + ENV_RZEDY, ENV_KRZESLA, ...):
+ * rzedy, krzesla_w_rzedzie, interwal_ms, pozycja_gorna (domyślnie rzedy/2).
  * 
  * Model fizyczny:
- * - LICZBA_RZEDOW rzędów w obiegu (ring buffer)
- *   (1 rząd = 4 krzesełka obok siebie = KRZESLA_W_RZEDZIE slotów)
+ * - rzedy rzędów w obiegu (ring buffer)
+ *   (1 rząd = krzesla_w_rzedzie krzesełek obok siebie = tyle slotów)
  * - Pozycja 0 = stacja dolna (załadunek pasażerów)
- * - Pozycja (LICZBA_RZEDOW/2) = stacja górna (wyładunek pasażerów)
- * - Pozycje 1..(POZYCJA_GORNA-1) = jazda w górę (z pasażerami)
- * - Pozycje (POZYCJA_GORNA+1)..(LICZBA_RZEDOW-1) = jazda w dół (puste krzesełka wracają)
- * - Każdy rząd ma KRZESLA_W_RZEDZIE miejsc (slotów)
+ * - Pozycja pozycja_gorna = stacja górna (wyładunek pasażerów)
+ * - Pozycje 1..(pozycja_gorna-1) = jazda w górę (z pasażerami)
+ * - Pozycje (pozycja_gorna+1)..(rzedy-1) = jazda w dół (puste krzesełka wracają)
  * 
- * Co INTERWAL_KRZESELKA_MS:
- * 1. Rząd na pozycji (LICZBA_RZEDOW/2) wysadza pasażerów (ARRIVE)
+ * Co interwal_ms:
+ * 1. Rząd na pozycji pozycja_gorna wysadza pasażerów (ARRIVE)
  * 2. Rząd na pozycji 0 przyjmuje nowych z peronu (BOARD)
  * 3. Ring przesuwa się o 1 pozycję
  * 
- * Czas przejazdu = (LICZBA_RZEDOW/2) ticków
+ * Czas przejazdu = pozycja_gorna ticków
+ *
+ * Linie (ENV_LINIE): main uruchamia jeden proces na linię, argv[1] = numer
+ * linii 1..linie. Każda ma własny ring, kolejkę peronu (mtype requestu =
+ * numer linii) i semafor peronu; zegar i statystyki pakowania są wspólne.
+ *
+ * Ticki liczone od bezwzględnych terminów start + k*interwal_ms
+ * (clock_nanosleep TIMER_ABSTIME), więc praca ticka nie wydłuża okresu.
+ * Spóźnienie obsługuje tryb nadrabiania (config.h, NADRABIANIE_*);
+ * opóźnienie i czas pracy każdego ticka trafiają do g_shm->zegar_wyciagu.
  */
 
 #define POZYCJA_DOLNA       0   /* załadunek */
-#define POZYCJA_GORNA       (LICZBA_RZEDOW/2)   /* wyładunek */
-#define MAX_PASAZEROW_RZAD  4   /* max grup w jednym rzędzie */
+#define MAX_PASAZEROW_RZAD  KRZESLA_MAX   /* max grup w jednym rzędzie (grupa zajmuje >= 1 slot) */
 
 static volatile sig_atomic_t g_stop = 0;
+static int g_linia = 1;     /* numer linii (1..g_shm->wyciag.linie) */
 
 static void handler_sigterm(int sig) {
     (void)sig;
@@ -46,6 +61,7 @@ static void handler_sigterm(int sig) {
 /* Struktura pasażera w krzesełku */
 typedef struct {
     pid_t pid;
+    int skrzynka;       /* skrzynka odpowiedzi klienta (-1 = kolejka SysV) */
     int rozmiar_grupy;  /* ile osób (do statystyk) */
 } Pasazer;
 
@@ -56,41 +72,102 @@ typedef struct {
     int zajete_sloty;       /* suma wag slotów */
 } Rzad;
 
-/* Ring LICZBA_RZEDOW rzędów */
-static Rzad g_ring[LICZBA_RZEDOW];
+/* Geometria (kopia g_shm->wyciag - czytana raz na starcie) */
+static int g_rzedy = LICZBA_RZEDOW;
+static int g_krzesla = KRZESLA_W_RZEDZIE;
+static int g_pozycja_gorna = LICZBA_RZEDOW / 2;
+
+/* Ring: do LICZBA_RZEDOW rzędów w tablicy statycznej, większy z calloc */
+static Rzad g_ring_domyslny[LICZBA_RZEDOW];
+static Rzad *g_ring = g_ring_domyslny;
 static int g_head = 0;  /* indeks rzędu na pozycji 0 (dolna stacja) */
 
-/* Pobiera rząd na danej pozycji logicznej (0=dolna, POZYCJA_GORNA=górna) */
+/* Pobiera rząd na danej pozycji logicznej (0=dolna, g_pozycja_gorna=górna) */
 static Rzad* rzad_na_pozycji(int pozycja) {
-    int idx = (g_head + pozycja) % LICZBA_RZEDOW;
+    /* pozycja < g_rzedy: jedno odejmowanie zamiast dzielenia przez zmienną */
+    int idx = g_head + pozycja;
+    if (idx >= g_rzedy) idx -= g_rzedy;
     return &g_ring[idx];
 }
 
 /* Przesuwa ring o 1 (symulacja ruchu liny) */
 static void przesun_ring(void) {
-    g_head = (g_head + 1) % LICZBA_RZEDOW;
+    if (++g_head == g_rzedy) g_head = 0;
 }
 
-/* Wysyła odpowiedź do klienta z backoff */
-static int wyslij_odp(pid_t pid, TypWyciagOdp typ) {
-    MsgWyciagOdp odp;
-    odp.mtype = (long)pid;
-    odp.typ = typ;
-    
+/* ============================================
+ * PACZKA TICKA
+ * BOARD/ARRIVE i przesunięcia liczników zbierane w czasie ticka,
+ * zatwierdzane raz na jego końcu: po jednym atomowym add na kierunek
+ * (peron -> krzesło, krzesło -> góra), jeden add przejazdów i jedno
+ * przejście msg_send_odp_paczka po odpowiedziach. Koszt liczników SHM nie
+ * rośnie z liczbą grup; wysyłka to nadal jedna odpowiedź na grupę, ale z jednym
+ * backoffem na całą paczkę zamiast ponawiania każdej z osobna.
+ * ============================================ */
+
+#define PACZKA_MAX          (2 * MAX_PASAZEROW_RZAD)   /* ARRIVE z góry + BOARD na dole */
+#define PACZKA_PROBY        100
+#define PACZKA_BACKOFF_MAX  50      /* ms */
+
+typedef struct {
+    MsgWyciagOdp odp[PACZKA_MAX];
+    int skrzynki[PACZKA_MAX];
+    int liczba;
+    int na_krzeslo;     /* osób peron -> krzesło (BOARD) */
+    int na_gore;        /* osób krzesło -> góra (ARRIVE) */
+    int przejazdy;      /* grup, które dojechały */
+    int wsiadlo;        /* grup, które wsiadły */
+} PaczkaTicka;
+
+static PaczkaTicka g_paczka;
+
+/* Liczniki najpierw: klient po ARRIVE od razu schodzi z góry, więc osoba
+ * musi już tam być, zanim odpowiedź do niego dotrze. */
+static void paczka_zatwierdz_liczniki(void) {
+    PaczkaTicka *p = &g_paczka;
+    obecnosc_przenies(STREFA_PERON, STREFA_KRZESLO, p->na_krzeslo);
+    obecnosc_przenies(STREFA_KRZESLO, STREFA_GORA, p->na_gore);
+    if (p->przejazdy > 0) STAT_DODAJ(liczba_przejazdow, p->przejazdy);
+    if (p->wsiadlo > 0) {
+        __atomic_fetch_add(&g_shm->linie[g_linia - 1].grupy, (unsigned long)p->wsiadlo, __ATOMIC_RELAXED);
+    }
+    p->na_krzeslo = p->na_gore = p->przejazdy = p->wsiadlo = 0;
+}
+
+/* Dostarcza odpowiedzi z backoff na całą paczkę (nie na każdą z osobna) */
+static void paczka_wyslij_odpowiedzi(void) {
+    PaczkaTicka *p = &g_paczka;
     int backoff = 1;
-    for (int i = 0; i < 100; i++) {
-        int r = msg_send_nowait(g_mq_wyciag_odp, &odp, sizeof(odp));
-        if (r == 0) return 0;
-        if (r == -2) return -2;  /* IPC usunięte */
-        if (errno == EAGAIN) {
-            if (g_stop) return -1;
-            poll(NULL, 0, backoff);
-            if (backoff < 50) backoff *= 2;
-            continue;
-        }
-        return -1;
+    for (int proba = 0; proba < PACZKA_PROBY && p->liczba > 0; proba++) {
+        int r = msg_send_odp_paczka(g_mq_wyciag_odp, p->skrzynki, p->odp, sizeof(p->odp[0]), p->liczba);
+        if (r == -2) break;  /* IPC usunięte */
+        p->liczba = r;
+        if (r == 0 || g_stop) break;
+        poll(NULL, 0, backoff);
+        if (backoff < PACZKA_BACKOFF_MAX) backoff *= 2;
     }
-    return -1;
+    p->liczba = 0;
+}
+
+static void paczka_zatwierdz(void) {
+    paczka_zatwierdz_liczniki();
+    paczka_wyslij_odpowiedzi();
+}
+
+/* Dopisuje odpowiedź (pełna paczka = zatwierdź wcześniej, np. przy wysadzaniu całego ringu) */
+static void paczka_odp(pid_t pid, int skrzynka, TypWyciagOdp typ) {
+    if (g_paczka.liczba == PACZKA_MAX) paczka_zatwierdz();
+    MsgWyciagOdp *odp = &g_paczka.odp[g_paczka.liczba];
+    memset(odp, 0, sizeof(*odp));
+    odp->mtype = (long)pid;
+    odp->typ = typ;
+    g_paczka.skrzynki[g_paczka.liczba++] = skrzynka;
+}
+
+/* Odpowiedź od razu (odmowa przy braku pamięci) - zatwierdza też to, co już w paczce */
+static void wyslij_odp(pid_t pid, int skrzynka, TypWyciagOdp typ) {
+    paczka_odp(pid, skrzynka, typ);
+    paczka_zatwierdz();
 }
 
 /* Wysadza pasażerów z rzędu na górnej stacji */
@@ -98,14 +175,10 @@ static void wysadz_pasazerow(Rzad *rzad) {
     for (int i = 0; i < rzad->liczba_pasazerow; i++) {
         Pasazer *p = &rzad->pasazerowie[i];
         if (p->pid > 0) {
-            wyslij_odp(p->pid, WYCIAG_ODP_ARRIVE);
-            
-            /* Aktualizuj liczniki - przenieś z krzesła na górę */
-            MUTEX_SHM_LOCK();
-            g_shm->osoby_w_krzesle -= p->rozmiar_grupy;
-            g_shm->osoby_na_gorze += p->rozmiar_grupy;
-            g_shm->stats.liczba_przejazdow++;
-            MUTEX_SHM_UNLOCK();
+            /* Przeniesienie krzesło -> góra i przejazd trafiają do paczki */
+            paczka_odp(p->pid, p->skrzynka, WYCIAG_ODP_ARRIVE);
+            g_paczka.na_gore += p->rozmiar_grupy;
+            g_paczka.przejazdy++;
         }
     }
     /* Wyczyść rząd */
@@ -114,95 +187,346 @@ static void wysadz_pasazerow(Rzad *rzad) {
     memset(rzad->pasazerowie, 0, sizeof(rzad->pasazerowie));
 }
 
-/* Kolejka oczekujących na peronie */
-static MsgWyciagReq g_kolejka[32];
-static int g_kolejka_n = 0;
+/* ============================================
+ * KOLEJKI OCZEKUJĄCYCH NA PERONIE
+ * Osobne FIFO dla VIP i reszty: pierścień rosnący x2 (realloc), więc
+ * dopisywanie i wsiadanie z głowy to O(1), a kolejność w klasie się
+ * nie zmienia. Polityki z oknem wyjmują też grupy spod indeksu < OKNO.
+ * ============================================ */
+
+#define KOLEJKA_START       32      /* początkowa pojemność (potęga 2) */
+
+_Static_assert(PAKOWANIE_OKNO >= 1 && PAKOWANIE_OKNO <= 16, "wyciag: PAKOWANIE_OKNO poza 1..16 (maski podzbiorów)");
+
+typedef enum {
+    KLASA_KOLEJKI_VIP = 0,
+    KLASA_KOLEJKI_ZWYKLA,
+    KLASY_KOLEJKI
+} KlasaKolejki;
+
+typedef struct {
+    MsgWyciagReq req;
+    int waga;           /* sloty w rzędzie (>= 1) */
+    int wyprzedzenia;   /* rzędy, którymi pojechał ktoś późniejszy z tej klasy */
+} Oczekujacy;
+
+typedef struct {
+    Oczekujacy *wpisy;
+    int pojemnosc;      /* potęga 2 (0 = jeszcze nie przydzielona) */
+    int glowa;          /* indeks najstarszego wpisu */
+    int liczba;
+} KolejkaFifo;
+
+static KolejkaFifo g_kolejki[KLASY_KOLEJKI];
+static int g_max_oczekujacych = 0;     /* najdłuższa kolejka w ciągu dnia (do logu) */
+static PakowanieWyciagu *g_pakowanie = NULL;
+
+/* Miejsce na jeszcze jeden wpis. Zwraca 0=OK, -1=brak pamięci */
+static int fifo_zapewnij_miejsce(KolejkaFifo *k) {
+    if (k->liczba < k->pojemnosc) return 0;
+
+    int nowa = (k->pojemnosc > 0) ? k->pojemnosc * 2 : KOLEJKA_START;
+    Oczekujacy *w = realloc(k->wpisy, (size_t)nowa * sizeof(Oczekujacy));
+    if (w == NULL) return -1;
+
+    /* Zawinięty ogon (przed głową) przenieś za stary koniec */
+    int ogon = k->glowa + k->liczba - k->pojemnosc;
+    if (ogon > 0) {
+        memcpy(&w[k->pojemnosc], &w[0], (size_t)ogon * sizeof(Oczekujacy));
+    }
+    k->wpisy = w;
+    k->pojemnosc = nowa;
+    return 0;
+}
+
+/* i-ty od głowy (0 = najstarszy) */
+static Oczekujacy *fifo_na(KolejkaFifo *k, int i) {
+    return &k->wpisy[(k->glowa + i) & (k->pojemnosc - 1)];
+}
+
+static void fifo_dodaj(KolejkaFifo *k, const MsgWyciagReq *req) {
+    Oczekujacy *o = fifo_na(k, k->liczba);
+    o->req = *req;
+    o->waga = (req->waga_slotow > 0) ? req->waga_slotow : 1;
+    o->wyprzedzenia = 0;
+    k->liczba++;
+}
+
+static void fifo_zdejmij(KolejkaFifo *k) {
+    k->glowa = (k->glowa + 1) & (k->pojemnosc - 1);
+    k->liczba--;
+}
+
+/* Usuwa i-ty wpis: starsze przesuwają się o 1 w stronę ogona - O(i) */
+static void fifo_usun(KolejkaFifo *k, int i) {
+    for (int j = i; j > 0; j--) {
+        *fifo_na(k, j) = *fifo_na(k, j - 1);
+    }
+    fifo_zdejmij(k);
+}
+
+static int oczekujacych(void) {
+    return g_kolejki[KLASA_KOLEJKI_VIP].liczba + g_kolejki[KLASA_KOLEJKI_ZWYKLA].liczba;
+}
 
 /* Zbiera requesty z kolejki MQ (non-blocking) */
 static void zbierz_requesty(void) {
     for (;;) {
-        if (g_kolejka_n >= (int)(sizeof(g_kolejka) / sizeof(g_kolejka[0]))) {
-            break;  /* bufor pełny */
-        }
         MsgWyciagReq req;
-        int r = msg_recv_nowait(g_mq_wyciag_req, &req, sizeof(req), 0);
-        if (r > 0) {
-            g_kolejka[g_kolejka_n++] = req;
+        int r = msg_recv_nowait(g_mq_wyciag_req, &req, sizeof(req), g_linia);
+        if (r == -2) g_stop = 1;  /* IPC usunięte */
+        if (r <= 0) break;
+
+        /* mtype = numer linii, klasa tylko z pola vip */
+        KolejkaFifo *k = &g_kolejki[req.vip ? KLASA_KOLEJKI_VIP : KLASA_KOLEJKI_ZWYKLA];
+        if (fifo_zapewnij_miejsce(k) != 0) {
+            /* Bez pamięci nie można zgubić klienta - obsłuż go od razu odmową */
+            blad_ostrzezenie("WYCIAG: realloc kolejki peronu");
+            wyslij_odp(req.pid_klienta, req.skrzynka, WYCIAG_ODP_KONIEC);
             continue;
         }
-        if (r == -2) g_stop = 1;  /* IPC usunięte */
-        break;
+        fifo_dodaj(k, &req);
+        if (oczekujacych() > g_max_oczekujacych) g_max_oczekujacych = oczekujacych();
     }
 }
 
-/* Załaduj pasażerów do rzędu na dolnej stacji */
-static void zaladuj_pasazerow(Rzad *rzad) {
-    int slots = KRZESLA_W_RZEDZIE;  /* 4 sloty na rząd */
-    
-    /* Pakowanie: VIP najpierw, potem reszta */
-    for (int pass = 0; pass < 2 && slots > 0; pass++) {
-        for (int i = 0; i < g_kolejka_n && slots > 0; ) {
-            int is_vip = g_kolejka[i].vip || (g_kolejka[i].mtype == MSG_TYP_VIP);
-            
-            /* pass 0 = tylko VIP, pass 1 = tylko nie-VIP */
-            if ((pass == 0 && !is_vip) || (pass == 1 && is_vip)) {
-                i++;
-                continue;
-            }
-            
-            int w = g_kolejka[i].waga_slotow;
-            if (w <= 0) w = 1;
-            
-            if (w <= slots && rzad->liczba_pasazerow < MAX_PASAZEROW_RZAD) {
-                /* Mieści się - wsiadaj */
-                Pasazer *p = &rzad->pasazerowie[rzad->liczba_pasazerow++];
-                p->pid = g_kolejka[i].pid_klienta;
-                p->rozmiar_grupy = g_kolejka[i].rozmiar_grupy;
-                rzad->zajete_sloty += w;
-                slots -= w;
-                
-                /* Wyślij BOARD */
-                wyslij_odp(g_kolejka[i].pid_klienta, WYCIAG_ODP_BOARD);
-
-                /*
-                 * Liczniki SHM aktualizuje WYCIĄG (jedno źródło prawdy):
-                 * - peron -> krzesełko w momencie BOARD
-                 * - krzesełko -> góra w momencie ARRIVE
-                 * Dzięki temu w DRAINING nie zobaczysz "ujemnych" wartości
-                 * przez wyścig BOARD/ARRIVE pomiędzy procesami.
-                 */
-                MUTEX_SHM_LOCK();
-                g_shm->osoby_na_peronie -= p->rozmiar_grupy;
-                g_shm->osoby_w_krzesle += p->rozmiar_grupy;
-                MUTEX_SHM_UNLOCK();
-                
-                /* Usuń z kolejki (swap z ostatnim) */
-                g_kolejka[i] = g_kolejka[g_kolejka_n - 1];
-                g_kolejka_n--;
-                continue;
-            }
-            i++;
+/* ============================================
+ * PAKOWANIE RZĘDU
+ * Wybór grup z okna jednej klasy: wagi w[0..n-1] (kolejność przyjścia),
+ * wolne sloty i miejsca na grupy. Wynik w wziete[] (1 = wsiada).
+ * ============================================ */
+
+/* Zachłannie w kolejności przyjścia - do pierwszej, która się nie mieści */
+static void pakuj_zachlannie(const int w[], int n, int slots, int miejsca, int wziete[]) {
+    for (int i = 0; i < n && miejsca > 0; i++) {
+        if (wziete[i]) continue;
+        if (w[i] > slots) break;
+        wziete[i] = 1;
+        slots -= w[i];
+        miejsca--;
+    }
+}
+
+/* First-fit-decreasing: najcięższe najpierw, równe wagi w kolejności przyjścia */
+static void pakuj_ffd(const int w[], int n, int slots, int miejsca, int wziete[]) {
+    for (int waga = g_krzesla; waga >= 1 && miejsca > 0; waga--) {
+        for (int i = 0; i < n && miejsca > 0; i++) {
+            if (wziete[i] || w[i] != waga || waga > slots) continue;
+            wziete[i] = 1;
+            slots -= waga;
+            miejsca--;
+        }
+    }
+}
+
+/*
+ * Dokładnie: podzbiór zapełniający najwięcej slotów (<= 2^PAKOWANIE_OKNO masek);
+ * przy remisie ten, który bierze wcześniejsze grupy (leksykograficznie)
+ */
+static void pakuj_dokladnie(const int w[], int n, int slots, int miejsca, int wziete[]) {
+    unsigned int wolne = 0, najlepsza = 0;
+    int najlepiej = 0;
+
+    for (int i = 0; i < n; i++) {
+        if (!wziete[i]) wolne |= 1u << i;
+    }
+    /* Podzbiory wolnych: m = (m - 1) & wolne */
+    for (unsigned int m = wolne; m != 0; m = (m - 1) & wolne) {
+        if (__builtin_popcount(m) > miejsca) continue;
+        int suma = 0;
+        for (int i = 0; i < n; i++) {
+            if (m & (1u << i)) suma += w[i];
+        }
+        if (suma > slots || suma < najlepiej) continue;
+        /* Remis: wcześniejsza grupa = niższy bit; najniższy różniący się bit rozstrzyga */
+        if (suma == najlepiej && najlepsza != 0 && !((m ^ najlepsza) & m & -(m ^ najlepsza))) continue;
+        najlepiej = suma;
+        najlepsza = m;
+    }
+    for (int i = 0; i < n; i++) {
+        if (najlepsza & (1u << i)) wziete[i] = 1;
+    }
+}
+
+/*
+ * Wsadza grupy z klasy do rzędu wg polityki; liczy wyprzedzenia
+ * Zwraca: liczba grup, które wsiadły
+ */
+static int pakuj_klase(KolejkaFifo *k, Rzad *rzad) {
+    int n = (k->liczba < PAKOWANIE_OKNO) ? k->liczba : PAKOWANIE_OKNO;
+    int slots = g_krzesla - rzad->zajete_sloty;
+    int miejsca = MAX_PASAZEROW_RZAD - rzad->liczba_pasazerow;
+    int w[PAKOWANIE_OKNO], wziete[PAKOWANIE_OKNO];
+    int wymuszone = 0;
+
+    if (n == 0 || slots <= 0 || miejsca <= 0) return 0;
+    for (int i = 0; i < n; i++) {
+        w[i] = fifo_na(k, i)->waga;
+        wziete[i] = 0;
+    }
+
+    /* Limit wyprzedzeń: takie grupy pierwsze; jeśli się nie mieszczą, nikt ich nie wyprzedzi */
+    int zablokowane = 0;
+    for (int i = 0; i < n; i++) {
+        if (fifo_na(k, i)->wyprzedzenia < PAKOWANIE_MAX_WYPRZEDZEN) continue;
+        if (w[i] > slots || miejsca == 0) {
+            zablokowane = 1;
+            break;
+        }
+        wziete[i] = 1;
+        slots -= w[i];
+        miejsca--;
+        wymuszone++;
+    }
+
+    if (!zablokowane) {
+        switch (g_pakowanie->polityka) {
+            case PAKOWANIE_FFD:      pakuj_ffd(w, n, slots, miejsca, wziete); break;
+            case PAKOWANIE_DOKLADNA: pakuj_dokladnie(w, n, slots, miejsca, wziete); break;
+            default:                 pakuj_zachlannie(w, n, slots, miejsca, wziete); break;
+        }
+    }
+
+    /* Wsiadanie w kolejności przyjścia */
+    int ostatni = -1, wsiadlo = 0;
+    for (int i = 0; i < n; i++) {
+        if (!wziete[i]) continue;
+        Oczekujacy *o = fifo_na(k, i);
+        Pasazer *p = &rzad->pasazerowie[rzad->liczba_pasazerow++];
+        p->pid = o->req.pid_klienta;
+        p->skrzynka = o->req.skrzynka;
+        p->rozmiar_grupy = o->req.rozmiar_grupy;
+        rzad->zajete_sloty += o->waga;
+
+        /*
+         * BOARD do paczki. Liczniki SHM aktualizuje WYCIĄG (jedno źródło prawdy):
+         * - peron -> krzesełko w momencie BOARD
+         * - krzesełko -> góra w momencie ARRIVE
+         * Paczka zatwierdza je przed wysłaniem odpowiedzi, więc w DRAINING
+         * nie zobaczysz "ujemnych" wartości przez wyścig BOARD/ARRIVE.
+         */
+        paczka_odp(o->req.pid_klienta, o->req.skrzynka, WYCIAG_ODP_BOARD);
+        g_paczka.na_krzeslo += p->rozmiar_grupy;
+        g_paczka.wsiadlo++;
+
+        /* Maksimum wspólne dla wszystkich linii - CAS zamiast zwykłego zapisu */
+        int max = __atomic_load_n(&g_pakowanie->wyprzedzenia_max, __ATOMIC_RELAXED);
+        while (o->wyprzedzenia > max &&
+               !__atomic_compare_exchange_n(&g_pakowanie->wyprzedzenia_max, &max, o->wyprzedzenia,
+                                            1, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
         }
+        ostatni = i;
+        wsiadlo++;
+    }
+
+    /* Starsze grupy, które zostały, a ktoś późniejszy pojechał: +1 wyprzedzenie */
+    unsigned long wyprzedzone = 0;
+    for (int i = 0; i < ostatni; i++) {
+        if (wziete[i]) continue;
+        fifo_na(k, i)->wyprzedzenia++;
+        wyprzedzone++;
     }
+
+    /* Wyjmij od końca - fifo_usun nie rusza niższych indeksów */
+    for (int i = n - 1; i >= 0; i--) {
+        if (wziete[i]) fifo_usun(k, i);
+    }
+
+    if (wyprzedzone > 0) __atomic_fetch_add(&g_pakowanie->wyprzedzenia, wyprzedzone, __ATOMIC_RELAXED);
+    if (wymuszone > 0) __atomic_fetch_add(&g_pakowanie->wymuszone, (unsigned long)wymuszone, __ATOMIC_RELAXED);
+    return wsiadlo;
+}
+
+/* Załaduj pasażerów do rzędu na dolnej stacji: VIP najpierw, potem reszta */
+static void zaladuj_pasazerow(Rzad *rzad) {
+    int grupy = 0;
+    for (int klasa = 0; klasa < KLASY_KOLEJKI; klasa++) {
+        grupy += pakuj_klase(&g_kolejki[klasa], rzad);
+    }
+
+    __atomic_fetch_add(&g_pakowanie->rzedy, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&g_pakowanie->sloty, (unsigned long)rzad->zajete_sloty, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&g_pakowanie->grupy, (unsigned long)grupy, __ATOMIC_RELAXED);
 }
 
 /* Wyślij KONIEC do wszystkich w kolejce */
 static void ewakuuj_kolejke(void) {
-    for (int i = 0; i < g_kolejka_n; i++) {
-        wyslij_odp(g_kolejka[i].pid_klienta, WYCIAG_ODP_KONIEC);
+    for (int klasa = 0; klasa < KLASY_KOLEJKI; klasa++) {
+        KolejkaFifo *k = &g_kolejki[klasa];
+        while (k->liczba > 0) {
+            Oczekujacy *o = fifo_na(k, 0);
+            paczka_odp(o->req.pid_klienta, o->req.skrzynka, WYCIAG_ODP_KONIEC);
+            fifo_zdejmij(k);
+        }
+        free(k->wpisy);
+        memset(k, 0, sizeof(*k));
+    }
+    paczka_zatwierdz();
+}
+
+/* ============================================
+ * ZEGAR TICKÓW
+ * ============================================ */
+
+static long long g_interwal_ns = (long long)INTERWAL_KRZESELKA_MS * NS_NA_MS;
+static ZegarWyciagu *g_zegar = NULL;
+
+/*
+ * Termin następnego ticka po ticku z terminem `termin`, skończonym o `teraz`
+ * Zaległe terminy (pełne interwały za `teraz`) obsługuje tryb nadrabiania.
+ */
+static long long nastepny_termin(long long termin, long long teraz) {
+    termin += g_interwal_ns;
+    if (termin >= teraz) return termin;
+
+    long long zalegle = (teraz - termin) / g_interwal_ns;
+    long long porzucone = 0;
+
+    switch (g_zegar->tryb) {
+        case NADRABIANIE_POMIN:
+            /* Bieżący termin jeszcze wykonaj, starsze przepadają */
+            porzucone = zalegle;
+            termin += zalegle * g_interwal_ns;
+            break;
+        case NADRABIANIE_PRZESUN:
+            /* Nowa siatka: teraz + interwał; wszystkie zaległe terminy
+             * (łącznie z bieżącym) przepadają */
+            porzucone = zalegle + 1;
+            termin = teraz + g_interwal_ns;
+            break;
+        default:
+            /* Seria: nadrabiaj, ale nie więcej niż WYCIAG_SERIA_MAX ticków */
+            if (zalegle > WYCIAG_SERIA_MAX) {
+                porzucone = zalegle - WYCIAG_SERIA_MAX;
+                termin += porzucone * g_interwal_ns;
+            }
+            break;
+    }
+    if (porzucone > 0) {
+        __atomic_fetch_add(&g_zegar->pominiete, (unsigned long)porzucone, __ATOMIC_RELAXED);
+    }
+    return termin;
+}
+
+/* Śpij do terminu (SIGTERM przerywa sen i kończy pętlę) */
+static void czekaj_do(long long termin) {
+    struct timespec ts = {
+        .tv_sec = (time_t)(termin / NS_NA_SEK),
+        .tv_nsec = (long)(termin % NS_NA_SEK),
+    };
+    while (!g_stop && clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR) {
     }
-    g_kolejka_n = 0;
 }
 
 /* Sprawdź czy wszystkie rzędy są puste */
 static int wszystkie_rzedy_puste(void) {
-    for (int i = 0; i < LICZBA_RZEDOW; i++) {
+    for (int i = 0; i < g_rzedy; i++) {
         if (g_ring[i].liczba_pasazerow > 0) return 0;
     }
     return 1;
 }
 
-int main(void) {
+int main(int argc, char *argv[]) {
     /* Handlery sygnałów */
     struct sigaction sa;
     memset(&sa, 0, sizeof(sa));
@@ -215,21 +539,62 @@ int main(void) {
         fprintf(stderr, "WYCIAG: attach_ipc failed\n");
         return EXIT_FAILURE;
     }
+    statystyki_shard_roli(STAT_ROLA_WYCIAG);
+
+    if (argc > 1) g_linia = waliduj_liczbe(argv[1], 1, g_shm->wyciag.linie);
+    if (g_linia < 0) {
+        fprintf(stderr, "WYCIAG: nieprawidłowy numer linii: %s\n", argv[1]);
+        detach_ipc();
+        return EXIT_FAILURE;
+    }
     
+    /* Geometria ringu (main sprawdził zakresy) */
+    const GeometriaWyciagu *geo = &g_shm->wyciag;
+    g_rzedy = geo->rzedy;
+    g_krzesla = geo->krzesla_w_rzedzie;
+    g_pozycja_gorna = geo->pozycja_gorna;
+    g_interwal_ns = (long long)geo->interwal_ms * NS_NA_MS;
+
     /* Inicjalizuj ring */
-    memset(g_ring, 0, sizeof(g_ring));
+    if (g_rzedy > LICZBA_RZEDOW) {
+        g_ring = calloc((size_t)g_rzedy, sizeof(Rzad));
+        if (g_ring == NULL) {
+            blad_ostrzezenie("WYCIAG: calloc ringu");
+            detach_ipc();
+            return EXIT_FAILURE;
+        }
+    } else {
+        memset(g_ring_domyslny, 0, sizeof(g_ring_domyslny));
+    }
     g_head = 0;
     
-    int czas_przejazdu_ms = POZYCJA_GORNA * INTERWAL_KRZESELKA_MS;
-    loguj("WYCIAG: Start (INTERWAL=%dms, PRZEJAZD=%dms, RZEDOW=%d, SLOTY/RZAD=%d)",
-          INTERWAL_KRZESELKA_MS, czas_przejazdu_ms, LICZBA_RZEDOW, KRZESLA_W_RZEDZIE);
+    g_zegar = &g_shm->zegar_wyciagu;
+    g_pakowanie = &g_shm->pakowanie;
+
+    int czas_przejazdu_ms = g_pozycja_gorna * geo->interwal_ms;
+    loguj("WYCIAG: Start (LINIA=%d/%d, INTERWAL=%dms, PRZEJAZD=%dms, RZEDOW=%d, GORNA=%d, SLOTY/RZAD=%d, PERON=%d, nadrabianie=%s, pakowanie=%s)",
+          g_linia, geo->linie, geo->interwal_ms, czas_przejazdu_ms, g_rzedy, g_pozycja_gorna, g_krzesla, geo->peron_sloty,
+          nazwa_nadrabiania(g_zegar->tryb), nazwa_pakowania(g_pakowanie->polityka));
+
+    long long termin = czas_mono_ns();
+    long long zero = 0;   /* start zegara ustawia pierwsza linia */
+    __atomic_compare_exchange_n(&g_zegar->start_ns, &zero, termin, 0, __ATOMIC_RELAXED, __ATOMIC_RELAXED);
     
     while (!g_stop) {
         /* Sprawdź awarię */
-        if (g_shm && g_shm->awaria) {
+        if (g_shm && STAN(awaria)) {
             loguj("WYCIAG: Awaria - zatrzymuję");
             czekaj_na_wznowienie("WYCIAG");
             loguj("WYCIAG: Wznowiono");
+            /* Postój to nie spóźnienie - nowa siatka terminów od wznowienia */
+            termin = czas_mono_ns();
+        }
+
+        long long poczatek = czas_mono_ns();
+        long long opoznienie = poczatek - termin;
+        histogram_dodaj(&g_zegar->opoznienie, opoznienie);
+        if (opoznienie >= g_interwal_ns) {
+            __atomic_fetch_add(&g_zegar->zalegle, 1, __ATOMIC_RELAXED);
         }
         
         /* Zbierz nowe requesty z kolejki */
@@ -238,22 +603,30 @@ int main(void) {
         /* === TICK: symulacja ruchu wyciągu === */
         
         /* 1. Wysadź pasażerów na górnej stacji */
-        Rzad *rzad_gora = rzad_na_pozycji(POZYCJA_GORNA);
+        Rzad *rzad_gora = rzad_na_pozycji(g_pozycja_gorna);
         if (rzad_gora->liczba_pasazerow > 0) {
             wysadz_pasazerow(rzad_gora);
         }
         
         /* 2. Załaduj pasażerów na dolnej stacji (pozycja 0) */
         Rzad *rzad_dol = rzad_na_pozycji(POZYCJA_DOLNA);
-        if (g_kolejka_n > 0 && rzad_dol->liczba_pasazerow == 0) {
+        if (oczekujacych() > 0 && rzad_dol->liczba_pasazerow == 0) {
             zaladuj_pasazerow(rzad_dol);
         }
         
         /* 3. Przesuń ring (symulacja ruchu liny) */
         przesun_ring();
+
+        /* 4. Zatwierdź paczkę ticka: liczniki, potem BOARD/ARRIVE */
+        paczka_zatwierdz();
+
+        long long koniec = czas_mono_ns();
+        histogram_dodaj(&g_zegar->praca, koniec - poczatek);
+        __atomic_fetch_add(&g_zegar->ticki, 1, __ATOMIC_RELAXED);
+        __atomic_store_n(&g_zegar->ostatni_ns, poczatek, __ATOMIC_RELAXED);
         
         /* Sprawdź koniec dnia */
-        if (g_shm && g_shm->koniec_dnia) {
+        if (g_shm && STAN(koniec_dnia)) {
             /* Koniec dnia: NIE ewakuujemy osób z peronu.
              * Zgodnie z wymaganiami: osoby, które weszły na peron, mają zostać dowiezione na górę.
              * Gdy już nikogo nie ma w kolejce i w krzesełkach, czekamy jeszcze 3 sekundy
@@ -265,36 +638,36 @@ int main(void) {
              * To pozwala "dokończyć cykl" osobom, które przeszły BRAMKA1 przed zamknięciem
              * i dopiero w CLOSING/DRAINING doszły do peronu.
              */
-            int na_peronie = 0, na_terenie = 0, w_krzesle = 0;
-            MUTEX_SHM_LOCK();
-            na_peronie = g_shm->osoby_na_peronie;
-            na_terenie = g_shm->osoby_na_terenie;
-            w_krzesle = g_shm->osoby_w_krzesle;
-            MUTEX_SHM_UNLOCK();
-
-            if (g_kolejka_n == 0 && wszystkie_rzedy_puste() && na_peronie == 0 && na_terenie == 0) {
-                loguj("WYCIAG: Drenowanie zakończone (w_krzesle=%d, kolejka=%d, peron=%d, teren=%d) - wyłączam za 3s",
-                      w_krzesle, g_kolejka_n, na_peronie, na_terenie);
+            StanObecnosci ob;
+            obecnosc_odczytaj(&ob);
+            int na_peronie = ob.peron, na_terenie = ob.teren, w_krzesle = ob.krzeslo;
+
+            if (oczekujacych() == 0 && wszystkie_rzedy_puste() && na_peronie == 0 && na_terenie == 0) {
+                loguj("WYCIAG: Drenowanie zakończone (linia %d, w_krzesle=%d, kolejka=%d, peron=%d, teren=%d) - wyłączam za 3s",
+                      g_linia, w_krzesle, oczekujacych(), na_peronie, na_terenie);
                 poll(NULL, 0, 3000);
                 break;
             }
         }
         
-        /* Czekaj do następnego ticku */
-        poll(NULL, 0, INTERWAL_KRZESELKA_MS);
+        /* Czekaj do następnego ticku (bezwzględny termin - praca nie wydłuża okresu) */
+        termin = nastepny_termin(termin, koniec);
+        czekaj_do(termin);
     }
     
     /* Koniec - ewakuuj wszystkich */
     ewakuuj_kolejke();
     
     /* Wysadź wszystkich pozostałych w krzesełkach (wszystkie pozycje dla pewności) */
-    for (int i = 0; i < LICZBA_RZEDOW; i++) {
+    for (int i = 0; i < g_rzedy; i++) {
         if (g_ring[i].liczba_pasazerow > 0) {
             wysadz_pasazerow(&g_ring[i]);
         }
     }
+    paczka_zatwierdz();
+    if (g_ring != g_ring_domyslny) free(g_ring);
     
-    loguj("WYCIAG: Kończę pracę");
+    loguj("WYCIAG: Kończę pracę (linia %d, najdłuższa kolejka na peronie: %d grup)", g_linia, g_max_oczekujacych);
     detach_ipc();
     return EXIT_SUCCESS;
 }
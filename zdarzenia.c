@@ -0,0 +1,176 @@
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include "zdarzenia.h"
+#include "czas.h"
+#include "ipc.h"
+#include "kolejki_shm.h"
+
+/*
+ * KOLEJ KRZESEŁKOWA - ZDARZENIA DZIENNIKA
+ * Producent: LOG_ZDARZENIE -> zdarzenie_zapisz (pierscien_wloz, jeden CAS).
+ * Konsument: proces dziennika (zdarzenie_wyjmij + zdarzenie_renderuj).
+ */
+
+/* ============================================
+ * TABELA KANAŁÓW
+ * ============================================ */
+
+static const char *g_pliki_kanalow[KANAL_LICZBA] = {
+    "output/klienci.log",
+    "output/bramki.log",
+    "output/kasa.log",
+    "output/generator.log",
+};
+
+int zdarzenie_kanal(int kod) {
+    if (kod < 0 || kod >= ZD_LICZBA) return -1;
+    if (kod <= ZD_KLIENT_KONIEC) return KANAL_KLIENCI;
+    if (kod == ZD_BRAMKA_OK) return KANAL_BRAMKI;
+    if (kod == ZD_GENERATOR_KLIENT) return KANAL_GENERATOR;
+    return KANAL_KASA;
+}
+
+const char *zdarzenia_plik_kanalu(int kanal) {
+    if (kanal < 0 || kanal >= KANAL_LICZBA) return NULL;
+    return g_pliki_kanalow[kanal];
+}
+
+/* ============================================
+ * RENDEROWANIE (te same formaty co dawne LOG_DEBUG)
+ * ============================================ */
+
+static const char *nazwa_typu(int typ) {
+    return (typ == TYP_ROWERZYSTA) ? "ROWER" : "PIESZY";
+}
+
+int zdarzenie_renderuj(const Zdarzenie *z, char *buf, size_t rozmiar) {
+    const int *a = z->arg;
+    char kwota[32];
+
+    switch (z->kod) {
+    case ZD_KLIENT_START:
+        return snprintf(buf, rozmiar,
+                        "KLIENT %d: start pid=%d wiek=%d typ=%s vip=%d dzieci=%d (%d,%d) rozmiar_grupy=%d",
+                        a[0], a[1], a[2], nazwa_typu(a[3]), a[4], a[5], a[6], a[7], a[8]);
+    case ZD_KLIENT_NIE_KORZYSTA:
+        return snprintf(buf, rozmiar, "KLIENT %d: odchodzi - dziś nie korzysta z kolei (los=%d < %d%%)",
+                        a[0], a[1], a[2]);
+    case ZD_KLIENT_KARNET:
+        return snprintf(buf, rozmiar, "KLIENT %d: kupił karnet id_karnetu=%d typ=%s czas_waznosci=%ds vip=%d",
+                        a[0], a[1], nazwa_karnetu((TypKarnetu)a[2]), a[3], a[4]);
+    case ZD_KLIENT_KARNET_KROTKO:
+        return snprintf(buf, rozmiar, "KLIENT %d: kupił karnet id_karnetu=%d", a[0], a[1]);
+    case ZD_KLIENT_BRAMKA1:
+        return snprintf(buf, rozmiar, "KLIENT %d: id_karnetu=%d -> BRAMKA1 nr=%d (vip=%d, grupa=%d)",
+                        a[0], a[1], a[2], a[3], a[4]);
+    case ZD_KLIENT_BRAMKA1_OK:
+        return snprintf(buf, rozmiar, "KLIENT %d: BRAMKA1 OK (nr=%d) - jestem na terenie", a[0], a[1]);
+    case ZD_KLIENT_CZEKA_PERON:
+        return snprintf(buf, rozmiar, "KLIENT %d: czekam na peron (sloty=%d, bramka2=%d)", a[0], a[1], a[2]);
+    case ZD_KLIENT_PROSI_P1:
+        return snprintf(buf, rozmiar, "KLIENT %d: prosi PRACOWNIK1 o wejście na peron (bramka2=%d sloty=%d)",
+                        a[0], a[1], a[2]);
+    case ZD_KLIENT_P1_POZWOLIL:
+        return snprintf(buf, rozmiar, "KLIENT %d: PRACOWNIK1 pozwolił wejść na peron", a[0]);
+    case ZD_KLIENT_NA_PERONIE:
+        return snprintf(buf, rozmiar, "KLIENT %d: NA_PERONIE (sloty=%d) - czekam na BOARD", a[0], a[1]);
+    case ZD_KLIENT_BOARD:
+        return snprintf(buf, rozmiar, "KLIENT %d: BOARD - wsiadam na krzesełko (sloty=%d)", a[0], a[1]);
+    case ZD_KLIENT_ARRIVE:
+        return snprintf(buf, rozmiar, "KLIENT %d: ARRIVE - jestem na górze (przejazd=%d)", a[0], a[1]);
+    case ZD_KLIENT_ZJAZD:
+        return snprintf(buf, rozmiar, "KLIENT %d: zjazd trasą %s (czas=%ds)",
+                        a[0], nazwa_trasy((Trasa)a[1]), a[2]);
+    case ZD_KLIENT_POWROT:
+        return snprintf(buf, rozmiar, "KLIENT %d: wróciłem na dół po trasie %s", a[0], nazwa_trasy((Trasa)a[1]));
+    case ZD_KLIENT_KONIEC:
+        return snprintf(buf, rozmiar, "KLIENT %d: koniec (przejazdy=%d)", a[0], a[1]);
+    case ZD_BRAMKA_OK:
+        return snprintf(buf, rozmiar, "BRAMKA%d: OK - pid=%d karnet=%d grupa=%d vip=%d",
+                        a[0], a[1], a[2], a[3], a[4]);
+    case ZD_KASJER_KLIENT:
+        return snprintf(buf, rozmiar, "KASJER: klient id=%d pid=%d wiek=%d typ=%s vip=%d dzieci=%d (%d,%d)",
+                        a[0], a[1], a[2], nazwa_typu(a[3]), a[4], a[5], a[6], a[7]);
+    case ZD_KASJER_SPRZEDAZ:
+        formatuj_kwote(a[4], kwota);
+        return snprintf(buf, rozmiar, "KASJER: SPRZEDAŻ id_klienta=%d pid=%d -> karnet=%d typ=%s cena=%s vip=%d",
+                        a[0], a[1], a[2], nazwa_karnetu((TypKarnetu)a[3]), kwota, a[5]);
+    case ZD_KASJER_SPRZEDANO:
+        formatuj_kwote(a[2], kwota);
+        return snprintf(buf, rozmiar, "KASJER: sprzedano karnet id_karnetu=%d typ=%s cena=%s dla klienta id=%d (pid=%d)",
+                        a[0], nazwa_karnetu((TypKarnetu)a[1]), kwota, a[3], a[4]);
+    case ZD_GENERATOR_KLIENT:
+        if (a[5] == 0) {
+            return snprintf(buf, rozmiar, "GENERATOR: utworzono klienta id=%d pid=%d wiek=%d typ=%s vip=%d dzieci=0",
+                            a[0], a[1], a[2], nazwa_typu(a[3]), a[4]);
+        }
+        return snprintf(buf, rozmiar, "GENERATOR: utworzono klienta id=%d pid=%d wiek=%d typ=%s vip=%d dzieci=%d (wiek:%d,%d)",
+                        a[0], a[1], a[2], nazwa_typu(a[3]), a[4], a[5], a[6], a[7]);
+    default:
+        return -1;
+    }
+}
+
+/* ============================================
+ * PIERŚCIEŃ ZDARZEŃ (region 5 segmentu SHM)
+ * ============================================ */
+
+size_t zdarzenia_rozmiar(int pojemnosc) {
+    if (pojemnosc <= 0) return 0;
+    return pierscien_rozmiar((unsigned int)pojemnosc, sizeof(Zdarzenie));
+}
+
+static Pierscien *pierscien_zdarzen(void) {
+    if (g_shm == NULL || g_shm->geometria.pojemnosc_zdarzen <= 0) return NULL;
+    return (Pierscien *)((char *)g_shm + g_shm->geometria.offset_zdarzen);
+}
+
+void zdarzenia_init(void) {
+    Pierscien *p = pierscien_zdarzen();
+    if (p == NULL) return;
+    pierscien_init(p, (unsigned int)g_shm->geometria.pojemnosc_zdarzen, sizeof(Zdarzenie));
+    g_shm->dziennik_aktywny = 0;
+    g_shm->zdarzenia_w_locie = 0;
+}
+
+void zdarzenie_zapisz(int kod, const int *arg, int n) {
+    Zdarzenie z;
+
+    z.czas_ns = czas_mono_ns();
+    z.pid = getpid();
+    z.kod = kod;
+    if (n > ZDARZENIE_ARGUMENTOW) n = ZDARZENIE_ARGUMENTOW;
+    memcpy(z.arg, arg, (size_t)n * sizeof(int));
+    memset(z.arg + n, 0, (size_t)(ZDARZENIE_ARGUMENTOW - n) * sizeof(int));
+
+    Pierscien *p = pierscien_zdarzen();
+    if (p != NULL) {
+        /* Licznik w locie PRZED odczytem flagi: dziennik po zgaszeniu flagi
+         * czeka na zero, więc końcowe drenowanie zobaczy każde włożenie */
+        __atomic_fetch_add(&g_shm->zdarzenia_w_locie, 1, __ATOMIC_SEQ_CST);
+        int wlozone = __atomic_load_n(&g_shm->dziennik_aktywny, __ATOMIC_SEQ_CST) &&
+                      pierscien_wloz(p, kod + 1, &z, sizeof(z)) == 0;
+        __atomic_fetch_sub(&g_shm->zdarzenia_w_locie, 1, __ATOMIC_RELEASE);
+        if (wlozone) return;
+    }
+
+    /* Brak dziennika albo pełny pierścień: ten sam wiersz od razu */
+    char buf[512];
+    if (zdarzenie_renderuj(&z, buf, sizeof(buf)) >= 0) {
+        loguj("%s", buf);
+    }
+}
+
+int zdarzenie_wyjmij(Zdarzenie *z) {
+    Pierscien *p = pierscien_zdarzen();
+    long mtype;
+
+    if (p == NULL) return -1;
+    return (pierscien_wyjmij(p, &mtype, z, sizeof(*z)) == (int)sizeof(*z)) ? 0 : -1;
+}
+
+unsigned long zdarzenia_oczekujace(void) {
+    Pierscien *p = pierscien_zdarzen();
+    return (p != NULL) ? pierscien_liczba(p) : 0;
+}
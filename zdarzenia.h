@@ -0,0 +1,122 @@
+#ifndef ZDARZENIA_H
+#define ZDARZENIA_H
+
+#include <stddef.h>
+#include <sys/types.h>
+#include "config.h"
+#include "types.h"
+#include "utils.h"
+
+/*
+ * KOLEJ KRZESEŁKOWA - ZDARZENIA DZIENNIKA
+ * Gorące wiersze logów jako rekordy binarne: producent zapisuje czas,
+ * PID, kod i kilka liczb do pierścienia w SHM (bez formatowania i I/O),
+ * tekst w dotychczasowym formacie składa proces dziennika.
+ * Bez dziennika (domyślnie) albo przy pełnym pierścieniu ten sam
+ * wiersz idzie od razu przez loguj() - pliki logów wyglądają tak samo.
+ */
+
+#define ZDARZENIE_ARGUMENTOW    10
+
+/* Kody zdarzeń (kolejność = tablica w zdarzenia.c) */
+typedef enum {
+    ZD_KLIENT_START = 0,        // id, pid, wiek, typ, vip, dzieci, wiek_dz0, wiek_dz1, grupa
+    ZD_KLIENT_NIE_KORZYSTA,     // id, los, próg
+    ZD_KLIENT_KARNET,           // id, id_karnetu, typ, czas_waznosci, vip
+    ZD_KLIENT_KARNET_KROTKO,    // id, id_karnetu
+    ZD_KLIENT_BRAMKA1,          // id, id_karnetu, nr, vip, grupa
+    ZD_KLIENT_BRAMKA1_OK,       // id, nr
+    ZD_KLIENT_CZEKA_PERON,      // id, sloty, bramka2
+    ZD_KLIENT_PROSI_P1,         // id, bramka2, sloty
+    ZD_KLIENT_P1_POZWOLIL,      // id
+    ZD_KLIENT_NA_PERONIE,       // id, sloty
+    ZD_KLIENT_BOARD,            // id, sloty
+    ZD_KLIENT_ARRIVE,           // id, przejazd
+    ZD_KLIENT_ZJAZD,            // id, trasa, czas
+    ZD_KLIENT_POWROT,           // id, trasa
+    ZD_KLIENT_KONIEC,           // id, przejazdy
+    ZD_BRAMKA_OK,               // nr, pid, karnet, grupa, vip
+    ZD_KASJER_KLIENT,           // id, pid, wiek, typ, vip, dzieci, wiek_dz0, wiek_dz1
+    ZD_KASJER_SPRZEDAZ,         // id_klienta, pid, karnet, typ, cena, vip
+    ZD_KASJER_SPRZEDANO,        // karnet, typ, cena, id_klienta, pid
+    ZD_GENERATOR_KLIENT,        // id, pid, wiek, typ, vip, dzieci, wiek_dz0, wiek_dz1
+    ZD_LICZBA
+} KodZdarzenia;
+
+/* Plik logu, do którego trafia zdarzenie (output/<kanał>.log) */
+typedef enum {
+    KANAL_KLIENCI = 0,
+    KANAL_BRAMKI,
+    KANAL_KASA,
+    KANAL_GENERATOR,
+    KANAL_LICZBA
+} KanalLogu;
+
+/* Rekord w pierścieniu (stały rozmiar) */
+typedef struct {
+    long long czas_ns;              // CLOCK_MONOTONIC
+    pid_t pid;
+    int kod;                        // KodZdarzenia
+    int arg[ZDARZENIE_ARGUMENTOW];
+} Zdarzenie;
+
+/*
+ * LOG_ZDARZENIE(kod, arg...) - gorący wiersz na poziomie DEBUG
+ * (ten sam próg co LOG_DEBUG: w kompilacji i ENV_LOG_LEVEL)
+ */
+#if LOG_POZIOM_MIN <= LOG_POZIOM_DEBUG
+#define LOG_ZDARZENIE(kod, ...) \
+    do { \
+        if (log_poziom_aktywny(LOG_POZIOM_DEBUG)) { \
+            const int zd_arg_[] = {__VA_ARGS__}; \
+            zdarzenie_zapisz((kod), zd_arg_, (int)(sizeof(zd_arg_) / sizeof(zd_arg_[0]))); \
+        } \
+    } while (0)
+#else
+#define LOG_ZDARZENIE(kod, ...) \
+    do { if (0) zdarzenie_zapisz((kod), (const int[]){__VA_ARGS__}, 0); } while (0)
+#endif
+
+/*
+ * Zapisuje zdarzenie do pierścienia (dziennik aktywny) albo od razu przez loguj()
+ */
+void zdarzenie_zapisz(int kod, const int *arg, int n);
+
+/*
+ * Składa treść wiersza (bez prefiksu "[czas][PID]") do buf
+ * Zwraca: długość jak snprintf, -1 = nieznany kod
+ */
+int zdarzenie_renderuj(const Zdarzenie *z, char *buf, size_t rozmiar);
+
+/*
+ * Kanał (plik logu) zdarzenia, -1 = nieznany kod
+ */
+int zdarzenie_kanal(int kod);
+
+/*
+ * Ścieżka pliku logu kanału (np. "output/klienci.log")
+ */
+const char *zdarzenia_plik_kanalu(int kanal);
+
+/*
+ * Rozmiar bloku pierścienia dla pojemnosc rekordów (do geometrii SHM)
+ */
+size_t zdarzenia_rozmiar(int pojemnosc);
+
+/*
+ * Inicjalizuje pierścień w segmencie (main, init_ipc; nic przy pojemności 0)
+ */
+void zdarzenia_init(void);
+
+/*
+ * Wyjmuje najstarszy rekord (proces dziennika)
+ * Zwraca: 0=OK, -1=pusty / brak pierścienia
+ */
+int zdarzenie_wyjmij(Zdarzenie *z);
+
+/*
+ * Przybliżona liczba rekordów czekających w pierścieniu
+ */
+unsigned long zdarzenia_oczekujace(void);
+
+#endif /* ZDARZENIA_H */